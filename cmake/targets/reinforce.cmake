@@ -1,8 +1,17 @@
 
 set(
         LIBREINFORCE_SOURCES
+        alias_table.cpp
+        bitmask.cpp
+        charset.cpp
+        dynamic_gridworld.cpp
+        graph.cpp
         multi_binary.cpp
+        process.cpp
+        shared_memory.cpp
         text.cpp
+        thread_pool.cpp
+        topology.cpp
 )
 list(TRANSFORM LIBREINFORCE_SOURCES PREPEND "${PROJECT_REINFORCE_SRC_DIR}/")
 
@@ -26,6 +35,7 @@ target_link_libraries(
         $<$<BOOL:${TBB_FOUND}>:onetbb::onetbb>
         spdlog::spdlog
         frozen::frozen
+        Threads::Threads
 #        xtensor-blas
 )
 
@@ -4,6 +4,12 @@ register_reinforce_target(
         ${reinforce_test}_gridworld
         test_gridworld.cpp
 )
+register_reinforce_target(
+        ${reinforce_test}_vector_env
+        test_topology.cpp
+        test_vector_env.cpp
+        test_wrappers.cpp
+)
 register_reinforce_target(
         ${reinforce_test}_spaces
         test_space_box.cpp
@@ -15,6 +21,10 @@ register_reinforce_target(
         test_space_sequence.cpp
         test_space_graph.cpp
         test_space_oneof.cpp
+        test_space_fixed_box.cpp
+        test_space_fixed_multidiscrete.cpp
+        test_space_dict.cpp
+        test_space_batching.cpp
 )
 
 
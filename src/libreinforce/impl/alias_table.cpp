@@ -0,0 +1,114 @@
+#include "reinforce/utils/alias_table.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace force {
+
+void AliasTable::_build(std::span< const double > weights)
+{
+   if(weights.empty()) {
+      throw std::invalid_argument("Cannot build an alias table from an empty probability vector.");
+   }
+   double total = 0.;
+   for(auto weight : weights) {
+      if(not std::isfinite(weight) or weight < 0.) {
+         throw std::invalid_argument(fmt::format(
+            "Probabilities have to be finite and non-negative. Given value: {}", weight
+         ));
+      }
+      total += weight;
+   }
+   if(not (total > 0.)) {
+      throw std::invalid_argument("Probabilities have to sum to a positive value.");
+   }
+
+   const size_t n = weights.size();
+   std::vector< double > scaled(n);
+   std::vector< size_t > small;
+   std::vector< size_t > large;
+   std::vector< size_t > zeros;
+   for(size_t i = 0; i < n; ++i) {
+      scaled[i] = weights[i] * static_cast< double >(n) / total;
+      if(weights[i] == 0.) {
+         zeros.emplace_back(i);
+      } else if(scaled[i] < 1.) {
+         small.emplace_back(i);
+      } else {
+         large.emplace_back(i);
+      }
+   }
+   // zero-probability columns are paired first, so that rounding errors which exhaust the large
+   // list early can never leave one of them with a full acceptance probability
+   small.insert(small.end(), zeros.begin(), zeros.end());
+
+   m_threshold.assign(n, std::numeric_limits< uint64_t >::max());
+   m_alias.resize(n);
+   for(size_t i = 0; i < n; ++i) {
+      m_alias[i] = i;
+   }
+   constexpr double two_pow_64 = 18446744073709551616.;
+   while(not small.empty() and not large.empty()) {
+      const size_t less = small.back();
+      small.pop_back();
+      const size_t more = large.back();
+      large.pop_back();
+      m_threshold[less] = scaled[less] >= 1.
+                             ? std::numeric_limits< uint64_t >::max()
+                             : static_cast< uint64_t >(scaled[less] * two_pow_64);
+      m_alias[less] = more;
+      scaled[more] = (scaled[more] + scaled[less]) - 1.;
+      (scaled[more] < 1. ? small : large).emplace_back(more);
+   }
+   // whatever is left has a scaled probability of 1 up to rounding and keeps its own column
+}
+
+namespace detail {
+
+namespace {
+
+uint64_t hash_probabilities(std::span< const double > probabilities)
+{
+   // FNV-1a over the raw bit patterns
+   uint64_t hash = 0xcbf29ce484222325u;
+   for(auto prob : probabilities) {
+      uint64_t bits = 0;
+      std::memcpy(&bits, &prob, sizeof(bits));
+      hash = (hash ^ bits) * 0x100000001b3u;
+   }
+   return hash ^ probabilities.size();
+}
+
+struct alias_cache_entry {
+   uint64_t hash = 0;
+   std::vector< double > probabilities{};
+   std::shared_ptr< const AliasTable > table{};
+};
+
+}  // namespace
+
+std::shared_ptr< const AliasTable > cached_alias_table(std::span< const double > probabilities)
+{
+   constexpr size_t cache_size = 8;
+   thread_local std::array< alias_cache_entry, cache_size > cache{};
+   thread_local size_t next_slot = 0;
+
+   const uint64_t hash = hash_probabilities(probabilities);
+   for(const auto& entry : cache) {
+      if(entry.table != nullptr and entry.hash == hash
+         and std::ranges::equal(entry.probabilities, probabilities)) {
+         return entry.table;
+      }
+   }
+   auto& slot = cache[next_slot];
+   next_slot = (next_slot + 1) % cache_size;
+   slot.table = std::make_shared< const AliasTable >(probabilities);
+   slot.hash = hash;
+   slot.probabilities.assign(probabilities.begin(), probabilities.end());
+   return slot.table;
+}
+
+}  // namespace detail
+
+}  // namespace force
@@ -0,0 +1,51 @@
+#include "reinforce/utils/bitmask.hpp"
+
+#include "reinforce/utils/bits.hpp"
+
+namespace force {
+
+BitMask::BitMask(size_t size, bool value)
+    : m_size(size), m_words((size + word_bits - 1) / word_bits, value ? ~word_type{0} : 0)
+{
+   if(value and size % word_bits != 0) {
+      m_words.back() >>= word_bits - size % word_bits;
+   }
+   _build_directory();
+}
+
+BitMask BitMask::from_bytes(const uint8_t* data, size_t size)
+{
+   BitMask mask;
+   mask.m_size = size;
+   mask.m_words.assign((size + word_bits - 1) / word_bits, 0);
+   detail::pack_bytes(data, size, mask.m_words.data());
+   mask._build_directory();
+   return mask;
+}
+
+void BitMask::set(size_t pos, bool value)
+{
+   if(pos >= m_size) {
+      throw std::out_of_range(fmt::format("Bit position {} out of range for size {}.", pos, m_size));
+   }
+   if(test(pos) == value) {
+      return;
+   }
+   const size_t word = pos / word_bits;
+   m_words[word] ^= word_type{1} << (pos % word_bits);
+   for(auto& cumulative : std::span{m_cumulative}.subspan(word + 1)) {
+      cumulative = value ? cumulative + 1 : cumulative - 1;
+   }
+}
+
+void BitMask::_build_directory()
+{
+   m_cumulative.resize(m_words.size() + 1);
+   m_cumulative[0] = 0;
+   for(size_t word = 0; word < m_words.size(); ++word) {
+      m_cumulative[word + 1] = m_cumulative[word]
+                               + static_cast< size_t >(std::popcount(m_words[word]));
+   }
+}
+
+}  // namespace force
@@ -0,0 +1,105 @@
+#include "reinforce/utils/charset.hpp"
+
+#include <algorithm>
+
+#if defined(__AVX2__) || defined(__SSSE3__)
+   #include <immintrin.h>
+#endif
+
+namespace force {
+
+CharsetTable::CharsetTable(std::string_view characters) : CharsetTable()
+{
+   for(size_t pos = 0; pos < characters.size(); ++pos) {
+      const auto byte = _byte(characters[pos]);
+      if(m_index[byte] < 0) {
+         m_index[byte] = static_cast< int32_t >(pos);
+      }
+      const auto low = byte & 0x0Fu;
+      const auto high = byte >> 4;
+      auto& rows = high < 8 ? m_lower_rows : m_upper_rows;
+      rows[low] = static_cast< uint8_t >(rows[low] | (1u << (high & 7u)));
+   }
+}
+
+bool CharsetTable::_contains_all_scalar(std::string_view text) const
+{
+   return std::ranges::all_of(text, [&](char chr) { return contains(chr); });
+}
+
+#if defined(__AVX2__) || defined(__SSSE3__)
+
+namespace {
+
+/// bit (h & 7) for every high nibble h
+constexpr std::array< uint8_t, 16 > high_nibble_bits = {
+   1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+
+}  // namespace
+
+#endif
+
+bool CharsetTable::contains_all(std::string_view text) const
+{
+   [[maybe_unused]] const auto* data = text.data();
+   size_t pos = 0;
+   // Every byte x is looked up as `rows[x & 0xF] & (1 << (x >> 4 & 7))`. The row table is selected
+   // by the top bit of x: pshufb yields zero for indices with the top bit set, so shuffling with
+   // x & 0x8F only reads the lower rows for x < 128 and with (x ^ 0x80) & 0x8F only the upper ones
+   // for x >= 128.
+#if defined(__AVX2__)
+   {
+      const auto lower = _mm256_broadcastsi128_si256(
+         _mm_loadu_si128(reinterpret_cast< const __m128i* >(m_lower_rows.data()))
+      );
+      const auto upper = _mm256_broadcastsi128_si256(
+         _mm_loadu_si128(reinterpret_cast< const __m128i* >(m_upper_rows.data()))
+      );
+      const auto bits = _mm256_broadcastsi128_si256(
+         _mm_loadu_si128(reinterpret_cast< const __m128i* >(high_nibble_bits.data()))
+      );
+      const auto index_mask = _mm256_set1_epi8(static_cast< char >(0x8F));
+      const auto top_bit = _mm256_set1_epi8(static_cast< char >(0x80));
+      const auto nibble_mask = _mm256_set1_epi8(0x0F);
+      for(; pos + 32 <= text.size(); pos += 32) {
+         const auto chunk = _mm256_loadu_si256(reinterpret_cast< const __m256i* >(data + pos));
+         const auto flipped = _mm256_xor_si256(chunk, top_bit);
+         const auto rows = _mm256_or_si256(
+            _mm256_shuffle_epi8(lower, _mm256_and_si256(chunk, index_mask)),
+            _mm256_shuffle_epi8(upper, _mm256_and_si256(flipped, index_mask))
+         );
+         const auto high = _mm256_and_si256(_mm256_srli_epi16(chunk, 4), nibble_mask);
+         const auto hits = _mm256_and_si256(rows, _mm256_shuffle_epi8(bits, high));
+         if(_mm256_movemask_epi8(_mm256_cmpeq_epi8(hits, _mm256_setzero_si256())) != 0) {
+            return false;
+         }
+      }
+   }
+#endif
+#if defined(__SSSE3__)
+   {
+      const auto lower = _mm_loadu_si128(reinterpret_cast< const __m128i* >(m_lower_rows.data()));
+      const auto upper = _mm_loadu_si128(reinterpret_cast< const __m128i* >(m_upper_rows.data()));
+      const auto bits = _mm_loadu_si128(reinterpret_cast< const __m128i* >(high_nibble_bits.data()));
+      const auto index_mask = _mm_set1_epi8(static_cast< char >(0x8F));
+      const auto top_bit = _mm_set1_epi8(static_cast< char >(0x80));
+      const auto nibble_mask = _mm_set1_epi8(0x0F);
+      for(; pos + 16 <= text.size(); pos += 16) {
+         const auto chunk = _mm_loadu_si128(reinterpret_cast< const __m128i* >(data + pos));
+         const auto flipped = _mm_xor_si128(chunk, top_bit);
+         const auto rows = _mm_or_si128(
+            _mm_shuffle_epi8(lower, _mm_and_si128(chunk, index_mask)),
+            _mm_shuffle_epi8(upper, _mm_and_si128(flipped, index_mask))
+         );
+         const auto high = _mm_and_si128(_mm_srli_epi16(chunk, 4), nibble_mask);
+         const auto hits = _mm_and_si128(rows, _mm_shuffle_epi8(bits, high));
+         if(_mm_movemask_epi8(_mm_cmpeq_epi8(hits, _mm_setzero_si128())) != 0) {
+            return false;
+         }
+      }
+   }
+#endif
+   return _contains_all_scalar(text.substr(pos));
+}
+
+}  // namespace force
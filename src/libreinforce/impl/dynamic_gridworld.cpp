@@ -0,0 +1,463 @@
+#include "reinforce/env/dynamic_gridworld.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <functional>
+#include <numeric>
+#include <ranges>
+#include <stdexcept>
+
+#include "reinforce/utils/macro.hpp"
+#include "reinforce/utils/utils.hpp"
+
+namespace force {
+
+namespace detail {
+
+namespace {
+
+void assert_dimensions(const idx_xarray& states, size_t dim)
+{
+   if(states.size() == 0) {
+      return;
+   }
+   if(states.dimension() != 2) {
+      throw std::invalid_argument(fmt::format(
+         "Array is not exactly two dimensional. Actual dimensions: {}", states.dimension()
+      ));
+   }
+   if(states.shape(1) != dim) {
+      throw std::invalid_argument(fmt::format(
+         "Dimension mismatch:\n"
+         "Passed states array has coordinate dimensions: {}\n"
+         "The expected dimensions are: {}",
+         states.shape(1),
+         dim
+      ));
+   }
+}
+
+}  // namespace
+
+GenericGridworld::GenericGridworld(
+   size_t dim,
+   const std::vector< size_t >& shape,
+   const idx_pyarray& start_states,
+   const idx_pyarray& goal_states,
+   const std::variant< double, pyarray< double > >& goal_reward,
+   double step_reward,
+   const std::optional< idx_pyarray >& start_states_prob_weights,
+   const std::variant< double, pyarray< double > >& transition_matrix,
+   const std::optional< idx_pyarray >& subgoal_states,
+   const std::variant< double, pyarray< double > >& subgoal_states_reward,
+   const std::optional< idx_pyarray >& obs_states,
+   const std::optional< idx_pyarray >& restart_states,
+   double restart_states_reward
+)
+    : m_dim(dim),
+      m_grid_shape(std::invoke([&] {
+         // the given shape is the tail of the grid shape, as in Gridworld< dim >::_adapt_coords
+         grid_coordinates grid_shape(dim, 0);
+         const size_t n_given = std::min(shape.size(), dim);
+         std::copy(shape.end() - long(n_given), shape.end(), grid_shape.end() - long(n_given));
+         return grid_shape;
+      })),
+      m_grid_shape_products(std::invoke([&] {
+         grid_coordinates products(dim, 1);
+         for(size_t i = dim - 1; i > 0; --i) {
+            products[i - 1] = products[i] * m_grid_shape[i];
+         }
+         return products;
+      })),
+      m_size(
+         std::accumulate(m_grid_shape.begin(), m_grid_shape.end(), size_t(1), std::multiplies{})
+      ),
+      m_start_states(start_states),
+      m_start_state_distribution(
+         start_states_prob_weights.has_value()
+            ? std::discrete_distribution<
+                 size_t >{(*start_states_prob_weights).begin(), (*start_states_prob_weights).end()}
+            : std::invoke([&] {
+                 std::vector< int > weights(m_start_states.shape(0), 1);  // makes it uniform
+                 return std::discrete_distribution< size_t >{weights.begin(), weights.end()};
+              })
+      ),
+      m_transition_tensor(xarray< double >::from_shape({m_size, 2 * dim, 2 * dim})),
+      m_step_reward(step_reward),
+      m_action_space{2 * dim},
+      m_obs_space{DiscreteSpace{m_size}, MultiDiscreteSpace< size_t >{m_grid_shape}}
+{
+   const idx_xarray goals = goal_states;
+   const auto optional_states = [](const std::optional< idx_pyarray >& states) {
+      if(states.has_value()) {
+         return idx_xarray(*states);
+      }
+      return idx_xarray(xt::empty< size_t >(std::initializer_list< size_t >{0}));
+   };
+   const idx_xarray subgoals = optional_states(subgoal_states);
+   const idx_xarray obstacles = optional_states(obs_states);
+   const idx_xarray restarts = optional_states(restart_states);
+   for(const auto* states : {&m_start_states, &goals, &subgoals, &obstacles, &restarts}) {
+      assert_dimensions(*states, dim);
+   }
+
+   const size_t n_actions = num_actions();
+   std::visit(
+      detail::overload{
+         [&](double value) {
+            if(value > 1.) {
+               throw std::invalid_argument(
+                  fmt::format("Transition probability must be <= 1. Given: {}", value)
+               );
+            }
+            for(size_t state = 0; state < m_size; ++state) {
+               for(size_t choice = 0; choice < n_actions; ++choice) {
+                  for(size_t realized = 0; realized < n_actions; ++realized) {
+                     m_transition_tensor.unchecked(state, choice, realized) =
+                        value * (realized == choice)
+                        + (1. - value) / double(n_actions - 1) * (choice != realized);
+                  }
+               }
+            }
+         },
+         [&](const pyarray< double >& arr) {
+            if(not std::ranges::equal(arr.shape(), m_transition_tensor.shape())) {
+               throw std::invalid_argument(fmt::format(
+                  "Shape mismatch:\n"
+                  "Passed array has shape: {}\n"
+                  "The required shape is: {}",
+                  arr.shape(),
+                  m_transition_tensor.shape()
+               ));
+            }
+            std::ranges::copy(arr, m_transition_tensor.begin());
+         }
+      },
+      transition_matrix
+   );
+
+   _enter_rewards(StateType::goal, goals, goal_reward);
+   _enter_rewards(StateType::subgoal, subgoals, subgoal_states_reward);
+   _enter_rewards(StateType::restart, restarts, restart_states_reward);
+   auto [min, max] = std::ranges::minmax(m_reward_map | std::views::values | std::views::values);
+   m_reward_range = std::pair{min, max};
+   reset();
+}
+
+void GenericGridworld::_enter_rewards(
+   StateType state_type,
+   const idx_xarray& states,
+   const std::variant< double, pyarray< double > >& reward
+)
+{
+   if(states.size() == 0) {
+      return;
+   }
+   const size_t n_states = states.shape(0);
+   std::visit(
+      detail::overload{
+         [&](double) {},
+         [&](const pyarray< double >& reward_arr) {
+            if(reward_arr.shape(0) != n_states) {
+               throw std::invalid_argument(fmt::format(
+                  "Length ({}) of goal state reward array does not match number of goal states "
+                  "({}).",
+                  reward_arr.shape(0),
+                  n_states
+               ));
+            }
+         }
+      },
+      reward
+   );
+   grid_coordinates coordinates(m_dim);
+   for(size_t row = 0; row < n_states; ++row) {
+      for(size_t i = 0; i < m_dim; ++i) {
+         coordinates[i] = states(row, i);
+      }
+      const double value = std::visit(
+         detail::overload{
+            [](double reward_val) { return reward_val; },
+            [&](const pyarray< double >& reward_arr) { return reward_arr(row); }
+         },
+         reward
+      );
+      m_reward_map.emplace(
+         std::piecewise_construct,
+         std::forward_as_tuple(index_state(coordinates)),
+         std::forward_as_tuple(state_type, value)
+      );
+   }
+}
+
+grid_coordinates GenericGridworld::coord_state(size_t state_index) const
+{
+   grid_coordinates coordinates(m_dim);
+   for(size_t i = m_dim; i > 0; --i) {
+      coordinates[i - 1] = state_index % m_grid_shape[i - 1];
+      state_index /= m_grid_shape[i - 1];
+   }
+   return coordinates;
+}
+
+size_t GenericGridworld::index_state(std::span< const size_t > coordinates) const
+{
+   if(coordinates.size() > m_dim) {
+      throw std::invalid_argument(fmt::format(
+         "More arguments ({}) passed than dimensions in the grid ({}).", coordinates.size(), m_dim
+      ));
+   }
+   // the given coordinates fill up the trailing dimensions, the leading ones are taken to be 0
+   const size_t offset = m_dim - coordinates.size();
+   size_t state = 0;
+   for(size_t i = 0; i < coordinates.size(); ++i) {
+      state += m_grid_shape_products[offset + i] * coordinates[i];
+   }
+   return state;
+}
+
+bool GenericGridworld::is_terminal(size_t state_index) const
+{
+   auto entry = m_reward_map.find(state_index);
+   return entry != m_reward_map.end() and entry->second.first == StateType::goal;
+}
+
+const GenericGridworld::obs_type& GenericGridworld::reset(
+   std::optional< std::mt19937_64::result_type > seed
+)
+{
+   if(seed.has_value()) {
+      reseed(*seed);
+   }
+   const auto row_index = m_start_state_distribution(m_rng);
+   grid_coordinates start_coordinates(m_dim);
+   for(size_t i = 0; i < m_dim; ++i) {
+      start_coordinates[i] = m_start_states(row_index, i);
+   }
+   m_location = std::pair{index_state(start_coordinates), std::move(start_coordinates)};
+   return m_location;
+}
+
+std::tuple< GenericGridworld::obs_type, double, bool, bool > GenericGridworld::step(size_t action)
+{
+   if(action >= num_actions()) {
+      throw std::invalid_argument(
+         fmt::format("Action ({}) is out of bounds ({})", action, num_actions())
+      );
+   }
+   auto transition_probs = xt::view(m_transition_tensor, location_idx(), action, xt::all());
+   size_t chosen_action = xt::random::
+      choice(xt::arange(num_actions()), 1, transition_probs, false, m_rng)(0);
+   // action a moves along dimension a / 2, backwards for even and forwards for odd a
+   const size_t axis = chosen_action / 2;
+   const bool forward = chosen_action % 2 == 1;
+   const size_t coordinate = location()[axis];
+   if((not forward and coordinate == 0) or (forward and coordinate + 1 >= m_grid_shape[axis])) {
+      // illegal move, we would be out of the grid bounds if we accepted it
+      // --> action has no effect
+      return std::tuple{m_location, 0., false, false};
+   }
+   grid_coordinates next_position = location();
+   next_position[axis] = forward ? coordinate + 1 : coordinate - 1;
+   const size_t next_position_index = forward ? location_idx() + m_grid_shape_products[axis]
+                                              : location_idx() - m_grid_shape_products[axis];
+   auto entry = m_reward_map.find(next_position_index);
+   const auto next_state_attr = entry != m_reward_map.end() ? entry->second
+                                                            : std::pair{StateType::default_, 0.};
+   switch(next_state_attr.first) {
+      case StateType::start:  // fall through to default_
+      case StateType::default_: {
+         m_location = std::pair{next_position_index, std::move(next_position)};
+         return std::tuple{m_location, m_step_reward + 0., false, false};
+      }
+      case StateType::subgoal: {
+         m_location = std::pair{next_position_index, std::move(next_position)};
+         return std::tuple{m_location, m_step_reward + next_state_attr.second, false, false};
+      }
+      case StateType::goal: {
+         m_location = std::pair{next_position_index, std::move(next_position)};
+         return std::tuple{m_location, m_step_reward + next_state_attr.second, true, false};
+      }
+      case StateType::obstacle: {
+         // we do not move so no step reward and no change whatsoever
+         return std::tuple{m_location, 0., false, false};
+      }
+      case StateType::restart: {
+         reset();
+         return std::tuple{m_location, m_step_reward + next_state_attr.second, false, false};
+      }
+   }
+   throw std::logic_error(
+      fmt::format("Switch statement did not handle case ({}).", next_state_attr.first)
+   );
+}
+
+}  // namespace detail
+
+namespace {
+
+template < size_t dim, typename Grid, typename... Args >
+Grid make_grid(size_t requested_dim, Args&&... args)
+{
+   if constexpr(dim > detail::max_static_grid_dim) {
+      return Grid{std::in_place_type< detail::GenericGridworld >, requested_dim, FWD(args)...};
+   } else {
+      if(requested_dim == dim) {
+         return Grid{std::in_place_type< Gridworld< dim > >, FWD(args)...};
+      }
+      return make_grid< dim + 1, Grid >(requested_dim, FWD(args)...);
+   }
+}
+
+}  // namespace
+
+DynamicGridworld::DynamicGridworld(
+   size_t dim,
+   const std::vector< size_t >& shape,
+   const idx_pyarray& start_states,
+   const idx_pyarray& goal_states,
+   const std::variant< double, pyarray< double > >& goal_reward,
+   double step_reward,
+   const std::optional< idx_pyarray >& start_states_prob_weights,
+   const std::variant< double, pyarray< double > >& transition_matrix,
+   const std::optional< idx_pyarray >& subgoal_states,
+   const std::variant< double, pyarray< double > >& subgoal_states_reward,
+   const std::optional< idx_pyarray >& obs_states,
+   const std::optional< idx_pyarray >& restart_states,
+   double restart_states_reward
+)
+    : m_dim(dim),
+      m_grid(std::invoke([&] {
+         if(dim == 0) {
+            throw std::invalid_argument("A gridworld needs at least one dimension.");
+         }
+         return make_grid< 1, decltype(m_grid) >(
+            dim,
+            shape,
+            start_states,
+            goal_states,
+            goal_reward,
+            step_reward,
+            start_states_prob_weights,
+            transition_matrix,
+            subgoal_states,
+            subgoal_states_reward,
+            obs_states,
+            restart_states,
+            restart_states_reward
+         );
+      }))
+{
+   std::visit(
+      [&](const auto& grid) {
+         m_grid_shape.resize(m_dim);
+         std::ranges::copy(grid.shape(), m_grid_shape.begin());
+      },
+      m_grid
+   );
+   m_location.second = coordinates_type::from_shape({m_dim});
+   _sync_location();
+}
+
+void DynamicGridworld::_sync_location()
+{
+   std::visit(
+      [&](const auto& grid) {
+         m_location.first = grid.location_idx();
+         std::ranges::copy(grid.location(), m_location.second.data());
+      },
+      m_grid
+   );
+}
+
+std::tuple< DynamicGridworld::obs_type, double, bool, bool > DynamicGridworld::step(size_t action)
+{
+   return std::visit(
+      [&](auto& grid) {
+         auto&& result = grid.step(action);
+         _sync_location();
+         return std::tuple{
+            m_location, std::get< 1 >(result), std::get< 2 >(result), std::get< 3 >(result)
+         };
+      },
+      m_grid
+   );
+}
+
+const DynamicGridworld::obs_type& DynamicGridworld::reset(
+   std::optional< std::mt19937_64::result_type > seed
+)
+{
+   std::visit([&](auto& grid) { grid.reset(seed); }, m_grid);
+   _sync_location();
+   return m_location;
+}
+
+void DynamicGridworld::reseed(std::mt19937_64::result_type seed)
+{
+   std::visit([&](auto& grid) { grid.reseed(seed); }, m_grid);
+}
+
+DynamicGridworld::coordinates_type DynamicGridworld::coord_state(size_t state_index) const
+{
+   return std::visit(
+      [&](const auto& grid) {
+         auto&& coordinates = grid.coord_state(state_index);
+         auto out = coordinates_type::from_shape({m_dim});
+         std::ranges::copy(coordinates, out.data());
+         return out;
+      },
+      m_grid
+   );
+}
+
+size_t DynamicGridworld::index_state(std::span< const size_t > coordinates) const
+{
+   return std::visit([&](const auto& grid) { return grid.index_state(coordinates); }, m_grid);
+}
+
+bool DynamicGridworld::is_terminal(size_t state_index) const
+{
+   return std::visit([&](const auto& grid) { return grid.is_terminal(state_index); }, m_grid);
+}
+
+size_t DynamicGridworld::size() const
+{
+   return std::visit([](const auto& grid) { return grid.size(); }, m_grid);
+}
+
+double DynamicGridworld::step_reward() const
+{
+   return std::visit([](const auto& grid) { return grid.step_reward(); }, m_grid);
+}
+
+const DiscreteSpace< size_t >& DynamicGridworld::action_space() const
+{
+   return std::visit(
+      [](const auto& grid) -> const DiscreteSpace< size_t >& { return grid.action_space(); },
+      m_grid
+   );
+}
+
+const TupleSpace< DiscreteSpace< size_t >, MultiDiscreteSpace< size_t > >&
+DynamicGridworld::observation_space() const
+{
+   return std::visit(
+      [](const auto& grid
+      ) -> const TupleSpace< DiscreteSpace< size_t >, MultiDiscreteSpace< size_t > >& {
+         return grid.observation_space();
+      },
+      m_grid
+   );
+}
+
+const std::pair< double, double >& DynamicGridworld::reward_range() const
+{
+   return std::visit(
+      [](const auto& grid) -> const std::pair< double, double >& { return grid.reward_range(); },
+      m_grid
+   );
+}
+
+}  // namespace force
@@ -0,0 +1,134 @@
+#include "reinforce/spaces/graph.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace force {
+
+GraphAdjacency make_adjacency(const idx_xarray& edge_links, size_t nr_nodes, AdjacencyOrder order)
+{
+   // an empty graph stores its links with shape {0}
+   const size_t nr_edges = edge_links.size() / 2;
+   const auto* links = edge_links.data();
+   const size_t key_column = order == AdjacencyOrder::by_source ? 0 : 1;
+
+   GraphAdjacency adjacency;
+   adjacency.offsets.assign(nr_nodes + 1, 0);
+   for(size_t edge = 0; edge < nr_edges; ++edge) {
+      const size_t node = links[2 * edge + key_column];
+      if(node >= nr_nodes or links[2 * edge + 1 - key_column] >= nr_nodes) {
+         throw std::out_of_range(fmt::format(
+            "Edge {} links nodes ({}, {}), but the graph only has {} nodes.",
+            edge,
+            links[2 * edge],
+            links[2 * edge + 1],
+            nr_nodes
+         ));
+      }
+      ++adjacency.offsets[node + 1];
+   }
+   for(size_t node = 0; node < nr_nodes; ++node) {
+      adjacency.offsets[node + 1] += adjacency.offsets[node];
+   }
+   // the stable scatter keeps the edges of every node in their original order
+   adjacency.indices.resize(nr_edges);
+   adjacency.edge_ids.resize(nr_edges);
+   std::vector< size_t > cursor(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+   for(size_t edge = 0; edge < nr_edges; ++edge) {
+      const size_t pos = cursor[links[2 * edge + key_column]]++;
+      adjacency.indices[pos] = links[2 * edge + 1 - key_column];
+      adjacency.edge_ids[pos] = edge;
+   }
+   return adjacency;
+}
+
+namespace detail {
+
+namespace {
+
+/// Draw `count` distinct keys below `nr_keys` into `keys` in ascending order.
+void sample_unique_keys(pcg64& gen, uint64_t nr_keys, size_t count, std::vector< uint64_t >& keys)
+{
+   keys.clear();
+   keys.reserve(count);
+   while(keys.size() < count) {
+      const auto sorted = static_cast< std::ptrdiff_t >(keys.size());
+      for(size_t missing = count - keys.size(); missing > 0; --missing) {
+         keys.emplace_back(uniform_below(gen, nr_keys));
+      }
+      std::sort(keys.begin() + sorted, keys.end());
+      std::inplace_merge(keys.begin(), keys.begin() + sorted, keys.end());
+      keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+   }
+}
+
+}  // namespace
+
+void sample_edge_links(
+   pcg64& gen,
+   size_t nr_nodes,
+   size_t nr_edges,
+   const EdgeSampling& sampling,
+   size_t node_offset,
+   size_t* out
+)
+{
+   if(nr_edges == 0) {
+      return;
+   }
+   const uint64_t nr_targets = sampling.self_loops or nr_nodes == 0 ? nr_nodes : nr_nodes - 1;
+   if(nr_targets == 0) {
+      throw std::invalid_argument(fmt::format(
+         "Cannot link {} edges in a graph with {} nodes{}.",
+         nr_edges,
+         nr_nodes,
+         sampling.self_loops ? "" : " and no self loops"
+      ));
+   }
+   const uint64_t nr_keys = nr_nodes * nr_targets;
+   auto write = [&](size_t edge, uint64_t key) {
+      const uint64_t source = key / nr_targets;
+      uint64_t target = key % nr_targets;
+      if(not sampling.self_loops and target >= source) {
+         ++target;
+      }
+      out[2 * edge] = node_offset + source;
+      out[2 * edge + 1] = node_offset + target;
+   };
+
+   if(not sampling.unique) {
+      for(size_t edge = 0; edge < nr_edges; ++edge) {
+         write(edge, uniform_below(gen, nr_keys));
+      }
+      return;
+   }
+   if(nr_edges > nr_keys) {
+      throw std::invalid_argument(fmt::format(
+         "Cannot sample {} unique edges, the graph only has {} possible edges.", nr_edges, nr_keys
+      ));
+   }
+   thread_local std::vector< uint64_t > keys;
+   if(nr_edges <= nr_keys / 2) {
+      sample_unique_keys(gen, nr_keys, nr_edges, keys);
+      for(size_t edge = 0; edge < nr_edges; ++edge) {
+         write(edge, keys[edge]);
+      }
+      return;
+   }
+   // for dense graphs the rejection would mostly hit duplicates, so the excluded keys are drawn
+   // instead. nr_keys is at most twice nr_edges here.
+   sample_unique_keys(gen, nr_keys, nr_keys - nr_edges, keys);
+   size_t edge = 0;
+   auto excluded = keys.begin();
+   for(uint64_t key = 0; key < nr_keys; ++key) {
+      if(excluded != keys.end() and *excluded == key) {
+         ++excluded;
+      } else {
+         write(edge++, key);
+      }
+   }
+}
+
+}  // namespace detail
+
+}  // namespace force
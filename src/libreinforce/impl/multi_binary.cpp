@@ -1,62 +1,178 @@
 #include "reinforce/spaces/multi_binary.hpp"
 
 #include <cstddef>
+#include <functional>
+#include <numeric>
 #include <optional>
 
+#include "reinforce/utils/bits.hpp"
+
 namespace force {
 
-xt::svector< int > MultiBinarySpace::samples_shape(size_t batch_size) const
+auto MultiBinarySpace::_sample(size_t batch_size, std::nullopt_t) const -> value_type
 {
-   auto out = shape();
-   if(batch_size > 1) {
-      prepend(out, static_cast< int >(batch_size));
-   }
-   SPDLOG_DEBUG(fmt::format("Samples shape: {}", out));
-   return out;
+   value_type samples;
+   _sample_into(batch_size, samples);
+   return samples;
 }
 
-auto MultiBinarySpace::_sample(size_t batch_size, std::nullopt_t) const -> value_type
+void MultiBinarySpace::_sample_into(size_t batch_size, value_type& out, std::nullopt_t) const
 {
    if(batch_size == 0) {
-      return xt::empty< int8_t >({0});
+      out = xt::empty< int8_t >({0});
+      return;
    }
-   return xt::random::randint(samples_shape(batch_size), 0, 2, rng());
+   thread_local PackedMultiBinary packed;
+   sample_packed_into(batch_size, packed);
+   packed.unpack_into(out);
 }
 
 auto MultiBinarySpace::_sample(size_t batch_size, const value_type& mask) const -> value_type
+{
+   value_type samples;
+   _sample_into(batch_size, samples, mask);
+   return samples;
+}
+
+void MultiBinarySpace::_sample_into(size_t batch_size, value_type& out, const value_type& mask)
+   const
 {
    if(batch_size == 0) {
-      return xt::empty< int8_t >({0});
+      out = xt::empty< int8_t >({0});
+      return;
    }
+   thread_local PackedMultiBinary packed;
+   sample_packed_into(batch_size, packed, mask);
+   packed.unpack_into(out);
+}
+
+void MultiBinarySpace::sample_packed_into(size_t batch_size, PackedMultiBinary& out) const
+{
+   out.resize(shape(), batch_size);
+   _fill_stream(out, nullptr);
+}
+
+void MultiBinarySpace::sample_packed_into(
+   size_t batch_size,
+   PackedMultiBinary& out,
+   const value_type& mask
+) const
+{
+   const auto masks = _stream_mask(mask);
+   out.resize(shape(), batch_size);
+   _fill_stream(out, &masks);
+}
+
+auto MultiBinarySpace::_stream_mask(const value_type& mask) const -> stream_mask
+{
    if(not ranges::equal(mask.shape(), shape())) {
       throw std::invalid_argument(fmt::format(
          "Shape of the mask ({}) needs to match shape of the space ({}).", mask.shape(), shape()
       ));
    }
-   if(not (xt::all(mask < 3))) {
+   if(not (xt::all(mask >= 0 and mask < 3))) {
       throw std::invalid_argument(
          fmt::format("All values of a mask should be 0, 1 or 2, actual values: {}", mask)
       );
    }
-   auto samples = xt::empty< int8_t >(samples_shape(batch_size));
-   for(auto i : std::views::iota(0, ranges::accumulate(shape(), 1, std::multiplies{}))) {
-      // convert the flat index i to an indexing list for the given shape
-      auto coordinates = xt::unravel_index(i, shape());
-      auto mask_value = mask.element(coordinates.begin(), coordinates.end());
-      xt::xstrided_slice_vector index_stride(coordinates.begin(), coordinates.end());
-      if(batch_size > 1) {
-         prepend(index_stride, xt::all());
+   const size_t n_bits = mask.size();
+   stream_mask masks;
+   if(n_bits == 0) {
+      return masks;
+   }
+   // the bit pattern of the stream repeats every lcm(n_bits, 64) bits
+   const size_t period = n_bits / std::gcd(n_bits, PackedMultiBinary::word_bits);
+   masks.free.assign(period, 0);
+   masks.ones.assign(period, 0);
+   for(size_t word = 0; word < period; ++word) {
+      for(size_t bit = 0; bit < PackedMultiBinary::word_bits; ++bit) {
+         const auto value = mask.data_element((word * PackedMultiBinary::word_bits + bit) % n_bits);
+         masks.free[word] |= uint64_t{value == 2} << bit;
+         masks.ones[word] |= uint64_t{value == 1} << bit;
+      }
+   }
+   return masks;
+}
+
+void MultiBinarySpace::_fill_stream(PackedMultiBinary& out, const stream_mask* mask) const
+{
+   auto words = out.words();
+   if(words.empty()) {
+      return;
+   }
+   auto& gen = rng();
+   if(mask == nullptr) {
+      for(auto& word : words) {
+         word = gen();
       }
-      SPDLOG_DEBUG(fmt::format("Strides: {}", index_stride));
-      if(mask_value < 2) {
-         xt::strided_view(samples, index_stride) = mask_value;
-      } else {
-         xt::strided_view(samples, index_stride) = xt::random::randint(
-            xt::svector{batch_size}, 0, 2, rng()
-         );
+   } else {
+      const size_t period = mask->free.size();
+      for(size_t i = 0, phase = 0; i < words.size(); ++i) {
+         words[i] = (gen() & mask->free[phase]) | mask->ones[phase];
+         phase = phase + 1 == period ? 0 : phase + 1;
       }
    }
-   return samples;
+   // keep the bits past the end of the stream zeroed
+   if(const size_t tail = out.size() % PackedMultiBinary::word_bits; tail != 0) {
+      words.back() &= (uint64_t{1} << tail) - 1;
+   }
+}
+
+PackedMultiBinary::PackedMultiBinary(xt::svector< int > sample_shape, size_t batch_size)
+{
+   resize(std::move(sample_shape), batch_size);
+}
+
+void PackedMultiBinary::resize(xt::svector< int > sample_shape, size_t batch_size)
+{
+   m_bits_per_sample = static_cast< size_t >(
+      std::accumulate(sample_shape.begin(), sample_shape.end(), 1, std::multiplies{})
+   );
+   m_sample_shape = std::move(sample_shape);
+   m_batch_size = batch_size;
+   m_words.assign((size() + word_bits - 1) / word_bits, 0);
+}
+
+PackedMultiBinary
+PackedMultiBinary::pack(const xarray< int8_t >& values, xt::svector< int > sample_shape)
+{
+   const auto& shape = values.shape();
+   const bool batched = shape.size() == sample_shape.size() + 1;
+   if((not batched and shape.size() != sample_shape.size())
+      or not ranges::equal(
+         shape | ranges::views::drop(size_t{batched}), sample_shape, [](auto lhs, auto rhs) {
+            return std::cmp_equal(lhs, rhs);
+         }
+      )) {
+      throw std::invalid_argument(fmt::format(
+         "Shape of the values ({}) needs to be the sample shape ({}) with an optional leading batch "
+         "dimension.",
+         shape,
+         sample_shape
+      ));
+   }
+   PackedMultiBinary packed{std::move(sample_shape), batched ? shape[0] : 1};
+   detail::pack_bytes(
+      reinterpret_cast< const uint8_t* >(values.data()), packed.size(), packed.m_words.data()
+   );
+   return packed;
+}
+
+xarray< int8_t > PackedMultiBinary::unpack() const
+{
+   xarray< int8_t > values;
+   unpack_into(values);
+   return values;
+}
+
+void PackedMultiBinary::unpack_into(xarray< int8_t >& out) const
+{
+   auto out_shape = m_sample_shape;
+   if(m_batch_size != 1) {
+      prepend(out_shape, static_cast< int >(m_batch_size));
+   }
+   out.resize(out_shape);
+   detail::unpack_bits(m_words.data(), size(), reinterpret_cast< uint8_t* >(out.data()));
 }
 
-}  // namespace force
\ No newline at end of file
+}  // namespace force
@@ -0,0 +1,129 @@
+#include "reinforce/utils/process.hpp"
+
+#if defined(__linux__)
+   #include <sys/prctl.h>
+   #include <sys/wait.h>
+   #include <unistd.h>
+
+   #include <csignal>
+#endif
+
+#include <cerrno>
+#include <system_error>
+#include <utility>
+
+#include "reinforce/utils/exceptions.hpp"
+
+namespace force {
+
+#if defined(__linux__)
+
+namespace {
+
+int decode_status(int status)
+{
+   if(WIFSIGNALED(status)) {
+      return 128 + WTERMSIG(status);
+   }
+   return WEXITSTATUS(status);
+}
+
+}  // namespace
+
+ChildProcess::ChildProcess(const std::function< int() >& body)
+{
+   const pid_t parent = getpid();
+   const pid_t pid = fork();
+   if(pid < 0) {
+      throw std::system_error(errno, std::generic_category(), "fork failed");
+   }
+   if(pid == 0) {
+      prctl(PR_SET_PDEATHSIG, SIGKILL);
+      // the parent may have died before the death signal was set up
+      if(getppid() != parent) {
+         _exit(1);
+      }
+      int status = 1;
+      try {
+         status = body();
+      } catch(...) {
+      }
+      _exit(status);
+   }
+   m_pid = pid;
+}
+
+ChildProcess::~ChildProcess()
+{
+   if(m_pid > 0 and not m_status.has_value()) {
+      kill(m_pid, SIGKILL);
+      join();
+   }
+}
+
+bool ChildProcess::running()
+{
+   if(m_pid <= 0 or m_status.has_value()) {
+      return false;
+   }
+   int status = 0;
+   const pid_t result = waitpid(m_pid, &status, WNOHANG);
+   if(result == 0) {
+      return true;
+   }
+   // with an error the child is gone as well (e.g. reaped elsewhere)
+   m_status = result == m_pid ? decode_status(status) : 1;
+   return false;
+}
+
+int ChildProcess::join()
+{
+   if(m_status.has_value()) {
+      return *m_status;
+   }
+   int status = 0;
+   pid_t result = 0;
+   do {
+      result = waitpid(m_pid, &status, 0);
+   } while(result < 0 and errno == EINTR);
+   m_status = result == m_pid ? decode_status(status) : 1;
+   return *m_status;
+}
+
+#else
+
+ChildProcess::ChildProcess(const std::function< int() >& /*body*/)
+{
+   throw not_implemented_error("ChildProcess (only available on Linux)");
+}
+
+ChildProcess::~ChildProcess() = default;
+
+bool ChildProcess::running()
+{
+   return false;
+}
+
+int ChildProcess::join()
+{
+   return m_status.value_or(1);
+}
+
+#endif
+
+ChildProcess::ChildProcess(ChildProcess&& other) noexcept
+    : m_pid(std::exchange(other.m_pid, -1)), m_status(std::exchange(other.m_status, std::nullopt))
+{
+}
+
+ChildProcess& ChildProcess::operator=(ChildProcess&& other) noexcept
+{
+   if(this != &other) {
+      ChildProcess discarded{std::move(*this)};
+      m_pid = std::exchange(other.m_pid, -1);
+      m_status = std::exchange(other.m_status, std::nullopt);
+   }
+   return *this;
+}
+
+}  // namespace force
@@ -0,0 +1,126 @@
+#include "reinforce/utils/shared_memory.hpp"
+
+#if defined(__linux__)
+   #include <linux/futex.h>
+   #include <sys/mman.h>
+   #include <sys/syscall.h>
+   #include <unistd.h>
+#endif
+
+#include <cerrno>
+#include <ctime>
+#include <system_error>
+#include <utility>
+
+#include "reinforce/utils/exceptions.hpp"
+
+namespace force {
+
+#if defined(__linux__)
+
+SharedMemoryRegion::SharedMemoryRegion(size_t size) : m_size(size)
+{
+   void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+   if(data == MAP_FAILED) {
+      throw std::system_error(errno, std::generic_category(), "mmap of the shared memory failed");
+   }
+   m_data = static_cast< std::byte* >(data);
+}
+
+SharedMemoryRegion::~SharedMemoryRegion()
+{
+   if(m_data != nullptr) {
+      munmap(m_data, m_size);
+   }
+}
+
+namespace detail {
+
+namespace {
+
+long futex(const std::atomic< uint32_t >& word, int op, uint32_t value, const timespec* timeout)
+{
+   // no FUTEX_PRIVATE_FLAG, the word may be shared with other processes
+   return syscall(
+      SYS_futex,
+      reinterpret_cast< const uint32_t* >(&word),
+      op,
+      value,
+      timeout,
+      nullptr,
+      0
+   );
+}
+
+}  // namespace
+
+bool futex_wait(
+   const std::atomic< uint32_t >& word,
+   uint32_t expected,
+   std::chrono::nanoseconds timeout
+)
+{
+   const auto seconds = std::chrono::duration_cast< std::chrono::seconds >(timeout);
+   const timespec relative{
+      .tv_sec = static_cast< time_t >(seconds.count()),
+      .tv_nsec = static_cast< long >((timeout - seconds).count())
+   };
+   if(futex(word, FUTEX_WAIT, expected, &relative) == 0) {
+      return true;
+   }
+   // EAGAIN: the word did not hold `expected` anymore, EINTR: a signal arrived
+   return errno != ETIMEDOUT;
+}
+
+void futex_wake_all(const std::atomic< uint32_t >& word)
+{
+   futex(word, FUTEX_WAKE, static_cast< uint32_t >(INT32_MAX), nullptr);
+}
+
+}  // namespace detail
+
+#else
+
+SharedMemoryRegion::SharedMemoryRegion(size_t /*size*/)
+{
+   throw not_implemented_error("SharedMemoryRegion (only available on Linux)");
+}
+
+SharedMemoryRegion::~SharedMemoryRegion() = default;
+
+namespace detail {
+
+bool futex_wait(
+   const std::atomic< uint32_t >& /*word*/,
+   uint32_t /*expected*/,
+   std::chrono::nanoseconds /*timeout*/
+)
+{
+   throw not_implemented_error("futex_wait (only available on Linux)");
+}
+
+void futex_wake_all(const std::atomic< uint32_t >& /*word*/)
+{
+   throw not_implemented_error("futex_wake_all (only available on Linux)");
+}
+
+}  // namespace detail
+
+#endif
+
+SharedMemoryRegion::SharedMemoryRegion(SharedMemoryRegion&& other) noexcept
+    : m_data(std::exchange(other.m_data, nullptr)), m_size(std::exchange(other.m_size, 0))
+{
+}
+
+SharedMemoryRegion& SharedMemoryRegion::operator=(SharedMemoryRegion&& other) noexcept
+{
+   if(this != &other) {
+      SharedMemoryRegion discarded{std::move(*this)};
+      m_data = std::exchange(other.m_data, nullptr);
+      m_size = std::exchange(other.m_size, 0);
+   }
+   return *this;
+}
+
+}  // namespace force
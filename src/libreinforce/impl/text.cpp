@@ -1,5 +1,10 @@
 #include "reinforce/spaces/text.hpp"
 
+#include <random>
+#include <span>
+
+#include "reinforce/utils/random.hpp"
+
 namespace force {
 
 const xarray< char >& TextSpace::_default_chars()
@@ -20,21 +25,57 @@ const xarray< char >& TextSpace::_default_chars()
    return arr;
 }
 
-std::unordered_map< char, size_t > TextSpace::make_charmap(const xarray< char >& chars)
+void TextSpace::_sample_into(value_type& out, std::nullopt_t) const
 {
-   return chars  //
-          | ranges::views::enumerate  //
-          | std::views::transform([](auto&& pair) {
-               return std::pair{pair.second, pair.first};  // index, char -> char, index
-            })
-          |  //
-          ranges::to< std::unordered_map< char, size_t > >;
+   auto& gen = rng();
+   out.resize(std::uniform_int_distribution< size_t >{m_min_length, m_max_length}(gen));
+   std::uniform_int_distribution< size_t > char_dist{0, m_chars.size() - 1};
+   for(auto& chr : out) {
+      chr = m_chars.unchecked(char_dist(gen));
+   }
 }
 
-const std::unordered_map< char, size_t >& TextSpace::_default_charmap()
+void TextSpace::_sample_into(size_t batch_size, batch_value_type& out, std::nullopt_t) const
 {
-   static auto arr = make_charmap(_default_chars());
-   return arr;
+   out.resize(batch_size);
+   for(auto& sample : out) {
+      _sample_into(sample);
+   }
+}
+
+void TextSpace::sample_columnar_into(size_t batch_size, TextBatch& out) const
+{
+   auto& gen = rng();
+   out.m_offsets.resize(batch_size + 1);
+   out.m_offsets[0] = 0;
+   const uint64_t nr_lengths = m_max_length - m_min_length + 1;
+   for(size_t i = 0; i < batch_size; ++i) {
+      out.m_offsets[i + 1] = out.m_offsets[i] + m_min_length
+                             + static_cast< size_t >(detail::uniform_below(gen, nr_lengths));
+   }
+   out.m_chars.resize(out.m_offsets.back());
+
+   const size_t nr_chars = m_chars.size();
+   if(nr_chars <= 256) {
+      // draw the character indices in bulk into the buffer itself and map them afterwards
+      std::span< char > buffer{out.m_chars.data(), out.m_chars.size()};
+      detail::uniform_below_fill(gen, nr_chars, buffer, char{0});
+      for(auto& chr : buffer) {
+         chr = m_chars.unchecked(static_cast< unsigned char >(chr));
+      }
+   } else {
+      for(auto& chr : out.m_chars) {
+         chr = m_chars.unchecked(detail::uniform_below(gen, nr_chars));
+      }
+   }
+}
+
+const CharsetTable& TextSpace::_default_charset()
+{
+   static const CharsetTable charset{
+      std::string_view{default_characters, sizeof(default_characters)}
+   };
+   return charset;
 }
 
 }  // namespace force
\ No newline at end of file
@@ -0,0 +1,151 @@
+#include "reinforce/utils/thread_pool.hpp"
+
+#if defined(__linux__)
+   #include <pthread.h>
+   #include <sched.h>
+#endif
+
+#include <algorithm>
+#include <utility>
+
+#include "reinforce/utils/utils.hpp"
+
+namespace force {
+
+namespace {
+
+/// the pool and worker index of the calling thread
+thread_local const void* this_pool = nullptr;
+thread_local size_t this_worker_index = 0;
+
+}  // namespace
+
+bool pin_this_thread(size_t core)
+{
+#if defined(__linux__)
+   if(core >= CPU_SETSIZE) {
+      return false;
+   }
+   cpu_set_t set;
+   CPU_ZERO(&set);
+   CPU_SET(core, &set);
+   return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &set) == 0;
+#else
+   (void) core;
+   return false;
+#endif
+}
+
+ThreadPool::ThreadPool(size_t n_threads, std::vector< size_t > cores)
+{
+   n_threads = std::max(n_threads, size_t{1});
+   m_queues.reserve(n_threads);
+   for(size_t i = 0; i < n_threads; ++i) {
+      m_queues.emplace_back(std::make_unique< task_queue >());
+   }
+   m_threads.reserve(n_threads);
+   for(size_t i = 0; i < n_threads; ++i) {
+      std::optional< size_t > core = std::nullopt;
+      if(not cores.empty()) {
+         core = cores[i % cores.size()];
+      }
+      m_threads.emplace_back([this, i, core] { _run(i, core); });
+   }
+}
+
+ThreadPool::~ThreadPool()
+{
+   {
+      std::lock_guard lock{m_sleep_mutex};
+      m_stop = true;
+   }
+   m_wakeup.notify_all();
+   for(auto& thread : m_threads) {
+      thread.join();
+   }
+}
+
+void ThreadPool::submit(task_type task)
+{
+   if(auto worker = this_worker(); worker.has_value() and this_pool == this) {
+      submit(*worker, std::move(task));
+      return;
+   }
+   submit(m_next_queue.fetch_add(1, std::memory_order_relaxed) % size(), std::move(task));
+}
+
+void ThreadPool::submit(size_t worker, task_type task)
+{
+   auto& queue = *m_queues[worker % size()];
+   {
+      std::lock_guard lock{queue.mutex};
+      // counted before it is published, so a worker taking the task never decrements below zero
+      m_pending.fetch_add(1, std::memory_order_relaxed);
+      queue.tasks.emplace_back(std::move(task));
+   }
+   {
+      // taking the lock orders the increment before a worker's check of the wait predicate
+      std::lock_guard lock{m_sleep_mutex};
+   }
+   m_wakeup.notify_one();
+}
+
+std::optional< size_t > ThreadPool::this_worker()
+{
+   if(this_pool == nullptr) {
+      return std::nullopt;
+   }
+   return this_worker_index;
+}
+
+bool ThreadPool::_take(size_t index, task_type& task)
+{
+   {
+      auto& own = *m_queues[index];
+      std::lock_guard lock{own.mutex};
+      if(not own.tasks.empty()) {
+         task = std::move(own.tasks.back());
+         own.tasks.pop_back();
+         return true;
+      }
+   }
+   for(size_t offset = 1; offset < m_queues.size(); ++offset) {
+      auto& victim = *m_queues[(index + offset) % m_queues.size()];
+      std::lock_guard lock{victim.mutex};
+      if(not victim.tasks.empty()) {
+         task = std::move(victim.tasks.front());
+         victim.tasks.pop_front();
+         return true;
+      }
+   }
+   return false;
+}
+
+void ThreadPool::_run(size_t index, std::optional< size_t > core)
+{
+   this_pool = this;
+   this_worker_index = index;
+   // worker i samples from the thread stream i of a space (see rng_mixin::enable_thread_streams)
+   set_this_thread_index(index);
+   if(core.has_value()) {
+      pin_this_thread(*core);
+   }
+   task_type task;
+   while(true) {
+      if(m_pending.load(std::memory_order_acquire) > 0 and _take(index, task)) {
+         m_pending.fetch_sub(1, std::memory_order_relaxed);
+         task();
+         task = nullptr;
+         continue;
+      }
+      std::unique_lock lock{m_sleep_mutex};
+      m_wakeup.wait(lock, [&] {
+         return m_stop or m_pending.load(std::memory_order_acquire) > 0;
+      });
+      if(m_stop and m_pending.load(std::memory_order_acquire) == 0) {
+         return;
+      }
+   }
+}
+
+}  // namespace force
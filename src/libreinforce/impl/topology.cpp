@@ -0,0 +1,218 @@
+#include "reinforce/utils/topology.hpp"
+
+#if defined(__linux__)
+   #include <sched.h>
+#endif
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <charconv>
+#include <exception>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+#include "reinforce/utils/thread_pool.hpp"
+
+namespace force {
+
+namespace {
+
+/// the CPUs this process may run on
+std::vector< size_t > available_cpus()
+{
+   std::vector< size_t > cpus;
+#if defined(__linux__)
+   cpu_set_t set;
+   CPU_ZERO(&set);
+   if(sched_getaffinity(0, sizeof(cpu_set_t), &set) == 0) {
+      for(size_t cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+         if(CPU_ISSET(cpu, &set)) {
+            cpus.emplace_back(cpu);
+         }
+      }
+      return cpus;
+   }
+#endif
+   const size_t n = std::max(std::thread::hardware_concurrency(), 1u);
+   for(size_t cpu = 0; cpu < n; ++cpu) {
+      cpus.emplace_back(cpu);
+   }
+   return cpus;
+}
+
+std::optional< size_t > parse_index(std::string_view text)
+{
+   size_t value = 0;
+   const auto* end = text.data() + text.size();
+   auto [ptr, error] = std::from_chars(text.data(), end, value);
+   if(error != std::errc{} or ptr != end) {
+      return std::nullopt;
+   }
+   return value;
+}
+
+}  // namespace
+
+namespace detail {
+
+std::vector< size_t > parse_cpu_list(std::string_view list)
+{
+   std::vector< size_t > cpus;
+   while(not list.empty()) {
+      const size_t comma = list.find(',');
+      std::string_view range = list.substr(0, comma);
+      list = comma == std::string_view::npos ? std::string_view{} : list.substr(comma + 1);
+      // sysfs terminates the list with a newline
+      while(not range.empty() and (range.back() == '\n' or range.back() == ' ')) {
+         range.remove_suffix(1);
+      }
+      if(range.empty()) {
+         continue;
+      }
+      const size_t dash = range.find('-');
+      const auto first = parse_index(range.substr(0, dash));
+      const auto last = dash == std::string_view::npos ? first
+                                                        : parse_index(range.substr(dash + 1));
+      if(not first.has_value() or not last.has_value() or *last < *first) {
+         throw std::invalid_argument(fmt::format("Invalid CPU list entry '{}'.", range));
+      }
+      for(size_t cpu = *first; cpu <= *last; ++cpu) {
+         cpus.emplace_back(cpu);
+      }
+   }
+   return cpus;
+}
+
+}  // namespace detail
+
+Topology::Topology(std::vector< NumaNode > nodes) : m_nodes(std::move(nodes))
+{
+   if(m_nodes.empty()) {
+      throw std::invalid_argument("A topology needs at least one node.");
+   }
+}
+
+Topology Topology::query(const std::filesystem::path& sysfs_nodes)
+{
+   const auto allowed = available_cpus();
+   std::vector< NumaNode > nodes;
+   std::error_code error;
+   for(const auto& entry : std::filesystem::directory_iterator(sysfs_nodes, error)) {
+      const std::string name = entry.path().filename().string();
+      const auto id = name.starts_with("node") ? parse_index(std::string_view{name}.substr(4))
+                                               : std::nullopt;
+      if(not id.has_value()) {
+         continue;
+      }
+      std::ifstream file{entry.path() / "cpulist"};
+      std::string list;
+      if(not std::getline(file, list)) {
+         continue;
+      }
+      NumaNode node{*id, {}};
+      try {
+         for(size_t cpu : detail::parse_cpu_list(list)) {
+            if(std::ranges::binary_search(allowed, cpu)) {
+               node.cpus.emplace_back(cpu);
+            }
+         }
+      } catch(const std::invalid_argument&) {
+         continue;
+      }
+      if(not node.cpus.empty()) {
+         nodes.emplace_back(std::move(node));
+      }
+   }
+   if(nodes.empty()) {
+      nodes.emplace_back(NumaNode{0, allowed});
+   }
+   std::ranges::sort(nodes, {}, &NumaNode::id);
+   return Topology{std::move(nodes)};
+}
+
+size_t Topology::nr_cpus() const
+{
+   size_t count = 0;
+   for(const auto& node : m_nodes) {
+      count += node.cpus.size();
+   }
+   return count;
+}
+
+std::optional< size_t > Topology::node_of(size_t cpu) const
+{
+   for(const auto& node : m_nodes) {
+      if(std::ranges::find(node.cpus, cpu) != node.cpus.end()) {
+         return node.id;
+      }
+   }
+   return std::nullopt;
+}
+
+std::vector< size_t > place_workers(const Topology& topology, size_t n_workers, placement policy)
+{
+   std::vector< size_t > cpus;
+   if(policy == placement::none) {
+      return cpus;
+   }
+   std::vector< size_t > order;
+   order.reserve(topology.nr_cpus());
+   const auto& nodes = topology.nodes();
+   if(policy == placement::compact) {
+      for(const auto& node : nodes) {
+         order.insert(order.end(), node.cpus.begin(), node.cpus.end());
+      }
+   } else {
+      // the i-th CPU of every node before the (i + 1)-th of any
+      for(size_t i = 0; order.size() < topology.nr_cpus(); ++i) {
+         for(const auto& node : nodes) {
+            if(i < node.cpus.size()) {
+               order.emplace_back(node.cpus[i]);
+            }
+         }
+      }
+   }
+   if(order.empty()) {
+      // nodes without any CPUs leave nothing to pin to
+      return cpus;
+   }
+   cpus.reserve(n_workers);
+   for(size_t worker = 0; worker < n_workers; ++worker) {
+      cpus.emplace_back(order[worker % order.size()]);
+   }
+   return cpus;
+}
+
+void run_pinned(std::span< const size_t > cpus, const std::function< void(size_t) >& task)
+{
+   std::vector< std::exception_ptr > errors(cpus.size());
+   std::vector< std::thread > threads;
+   threads.reserve(cpus.size());
+   for(size_t i = 0; i < cpus.size(); ++i) {
+      threads.emplace_back([&, i] {
+         // an unavailable CPU only costs the locality, not the task
+         pin_this_thread(cpus[i]);
+         try {
+            task(i);
+         } catch(...) {
+            errors[i] = std::current_exception();
+         }
+      });
+   }
+   for(auto& thread : threads) {
+      thread.join();
+   }
+   for(auto& error : errors) {
+      if(error) {
+         std::rethrow_exception(error);
+      }
+   }
+}
+
+}  // namespace force
@@ -0,0 +1,340 @@
+#ifndef REINFORCE_ANY_ENV_HPP
+#define REINFORCE_ANY_ENV_HPP
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "reinforce/env/vector_env.hpp"
+#include "reinforce/spaces/batching.hpp"
+#include "reinforce/utils/macro.hpp"
+#include "reinforce/utils/type_traits.hpp"
+#include "reinforce/utils/xtensor_typedefs.hpp"
+
+namespace force {
+
+namespace detail {
+
+/// Environments an AnyEnv over the given spaces can hold: their spaces convert to the given ones
+/// and their observations to the values of the observation space.
+template < typename Env, typename ObservationSpace, typename ActionSpace >
+concept erasable_env = vectorizable_env< Env > and std::move_constructible< Env >
+                       and requires(Env env, const value_t< ActionSpace >& action) {
+                              {
+                                 env.observation_space()
+                              } -> std::convertible_to< ObservationSpace >;
+                              { env.action_space() } -> std::convertible_to< ActionSpace >;
+                              requires std::constructible_from<
+                                 value_t< ObservationSpace >,
+                                 decltype(std::get< 0 >(env.step(action))) >;
+                           };
+
+}  // namespace detail
+
+/// @brief Any environment with the given observation and action spaces behind a single type.
+///
+/// Environments of up to `buffer_size` bytes (and nothrow movable) are stored inline, larger ones
+/// on the heap. Calls go through a table of function pointers built once per environment type.
+/// The spaces are copied from the environment at construction. Observations are converted to the
+/// values of the observation space, so e.g. Gridworlds of different dimensions fit into one AnyEnv
+/// (see AnyGridworld). Info maps are dropped.
+///
+/// `step` pays one indirect call per step. `step_batch` steps a whole batch of AnyEnvs into the
+/// batch buffers of a vector env and pays one indirect call per run of environments of the same
+/// type instead, within which the environment's `step` is called directly.
+template < typename ObservationSpace, typename ActionSpace, size_t buffer_size = 256 >
+class AnyEnv {
+  public:
+   using observation_space_type = ObservationSpace;
+   using action_space_type = ActionSpace;
+   using observation_type = detail::value_t< ObservationSpace >;
+   using action_type = detail::value_t< ActionSpace >;
+   using observation_batch_type = detail::value_t< batched_space_t< ObservationSpace > >;
+   using action_batch_type = detail::value_t< batched_space_t< ActionSpace > >;
+   using step_return_type = std::tuple< observation_type, double, bool, bool >;
+
+   static constexpr size_t inline_capacity = buffer_size;
+
+   /// whether an environment of the given type is stored inline
+   template < typename Env >
+   static constexpr bool fits_inline = sizeof(Env) <= buffer_size
+                                       and alignof(Env) <= alignof(std::max_align_t)
+                                       and std::is_nothrow_move_constructible_v< Env >;
+
+   template < typename Env, typename EnvT = std::remove_cvref_t< Env > >
+      requires(not std::same_as< EnvT, AnyEnv >
+               and detail::erasable_env< EnvT, ObservationSpace, ActionSpace >)
+   AnyEnv(Env&& env)  // NOLINT(google-explicit-constructor)
+       : m_observation_space(env.observation_space()),
+         m_action_space(env.action_space()),
+         m_vtable(_vtable_of< EnvT >())
+   {
+      if constexpr(fits_inline< EnvT >) {
+         ::new(static_cast< void* >(m_storage)) EnvT(FWD(env));
+      } else {
+         ::new(static_cast< void* >(m_storage)) EnvT*(new EnvT(FWD(env)));
+      }
+   }
+
+   AnyEnv(const AnyEnv& other)
+       : m_observation_space(other.m_observation_space),
+         m_action_space(other.m_action_space),
+         m_vtable(other.m_vtable)
+   {
+      if(m_vtable != nullptr) {
+         m_vtable->copy(m_storage, other.m_storage);
+      }
+   }
+   AnyEnv(AnyEnv&& other) noexcept
+       : m_observation_space(std::move(other.m_observation_space)),
+         m_action_space(std::move(other.m_action_space)),
+         m_vtable(std::exchange(other.m_vtable, nullptr))
+   {
+      if(m_vtable != nullptr) {
+         m_vtable->move(m_storage, other.m_storage);
+      }
+   }
+   AnyEnv& operator=(const AnyEnv& other)
+   {
+      if(this != &other) {
+         AnyEnv copy{other};
+         *this = std::move(copy);
+      }
+      return *this;
+   }
+   AnyEnv& operator=(AnyEnv&& other) noexcept
+   {
+      if(this != &other) {
+         _destroy();
+         m_observation_space = std::move(other.m_observation_space);
+         m_action_space = std::move(other.m_action_space);
+         m_vtable = std::exchange(other.m_vtable, nullptr);
+         if(m_vtable != nullptr) {
+            m_vtable->move(m_storage, other.m_storage);
+         }
+      }
+      return *this;
+   }
+   ~AnyEnv() { _destroy(); }
+
+   observation_type reset(std::optional< size_t > seed = std::nullopt)
+   {
+      return _table().reset(m_storage, seed);
+   }
+
+   step_return_type step(const action_type& action) { return _table().step(m_storage, action); }
+
+   void close() { _table().close(m_storage); }
+
+   /// @brief Step `envs[i]` with action i of `actions` and write its results into row i of the
+   /// buffers (laid out as those of SyncVectorEnv).
+   ///
+   /// Finished environments are not reset. Throws before stepping any environment if one of them
+   /// is empty.
+   static void step_batch(
+      std::span< AnyEnv > envs,
+      const action_batch_type& actions,
+      observation_batch_type& observations,
+      xarray< double >& rewards,
+      xarray< bool >& terminated,
+      xarray< bool >& truncated
+   );
+
+   [[nodiscard]] auto& observation_space() const { return m_observation_space; }
+   [[nodiscard]] auto& action_space() const { return m_action_space; }
+
+   /// The held environment if it is of type `Env`, nullptr otherwise.
+   template < typename Env >
+   [[nodiscard]] Env* target()
+   {
+      return m_vtable == _vtable_of< Env >() ? &_get< Env >(m_storage) : nullptr;
+   }
+   template < typename Env >
+   [[nodiscard]] const Env* target() const
+   {
+      return m_vtable == _vtable_of< Env >() ? &_get< Env >(m_storage) : nullptr;
+   }
+
+   [[nodiscard]] bool stores_inline() const { return _table().stores_inline; }
+
+   /// whether the AnyEnv holds no environment, e.g. after it was moved from
+   [[nodiscard]] bool empty() const { return m_vtable == nullptr; }
+
+  private:
+   struct batch_buffers {
+      const action_batch_type& actions;
+      observation_batch_type& observations;
+      xarray< double >& rewards;
+      xarray< bool >& terminated;
+      xarray< bool >& truncated;
+   };
+
+   struct vtable {
+      bool stores_inline;
+      void (*destroy)(std::byte* storage) noexcept;
+      void (*copy)(std::byte* storage, const std::byte* other);
+      /// move-construct from `other` and destroy what is left there
+      void (*move)(std::byte* storage, std::byte* other) noexcept;
+      observation_type (*reset)(std::byte* storage, std::optional< size_t > seed);
+      step_return_type (*step)(std::byte* storage, const action_type& action);
+      void (*close)(std::byte* storage);
+      /// `envs` all hold this type, their rows start at `first_row`
+      void (*step_batch)(std::span< AnyEnv > envs, size_t first_row, const batch_buffers& buffers);
+   };
+
+   ObservationSpace m_observation_space;
+   ActionSpace m_action_space;
+   const vtable* m_vtable;
+   alignas(std::max_align_t) std::byte m_storage[buffer_size];
+
+   const vtable& _table() const
+   {
+      if(m_vtable == nullptr) {
+         throw std::logic_error("empty AnyEnv");
+      }
+      return *m_vtable;
+   }
+
+   void _destroy() noexcept
+   {
+      if(m_vtable != nullptr) {
+         m_vtable->destroy(m_storage);
+         m_vtable = nullptr;
+      }
+   }
+
+   template < typename Env >
+   static Env& _get(std::byte* storage)
+   {
+      if constexpr(fits_inline< Env >) {
+         return *std::launder(reinterpret_cast< Env* >(storage));
+      } else {
+         return **std::launder(reinterpret_cast< Env** >(storage));
+      }
+   }
+   template < typename Env >
+   static const Env& _get(const std::byte* storage)
+   {
+      return _get< Env >(const_cast< std::byte* >(storage));
+   }
+
+   template < typename Env >
+   static const vtable* _vtable_of();
+};
+
+template < typename ObservationSpace, typename ActionSpace, size_t buffer_size >
+template < typename Env >
+auto AnyEnv< ObservationSpace, ActionSpace, buffer_size >::_vtable_of() -> const vtable*
+{
+   static constexpr vtable table{
+      .stores_inline = fits_inline< Env >,
+      .destroy = [](std::byte* storage) noexcept {
+         if constexpr(fits_inline< Env >) {
+            std::destroy_at(&_get< Env >(storage));
+         } else {
+            delete &_get< Env >(storage);
+         }
+      },
+      .copy = [](std::byte* storage, const std::byte* other) {
+         if constexpr(not std::is_copy_constructible_v< Env >) {
+            throw std::logic_error("The environment held by this AnyEnv cannot be copied.");
+         } else if constexpr(fits_inline< Env >) {
+            ::new(static_cast< void* >(storage)) Env(_get< Env >(other));
+         } else {
+            ::new(static_cast< void* >(storage)) Env*(new Env(_get< Env >(other)));
+         }
+      },
+      .move = [](std::byte* storage, std::byte* other) noexcept {
+         if constexpr(fits_inline< Env >) {
+            auto& source = _get< Env >(other);
+            ::new(static_cast< void* >(storage)) Env(std::move(source));
+            std::destroy_at(&source);
+         } else {
+            // the heap object changes hands, the pointer left behind needs no destruction
+            ::new(static_cast< void* >(storage)) Env*(&_get< Env >(other));
+         }
+      },
+      .reset = [](std::byte* storage, std::optional< size_t > seed) {
+         auto&& result = detail::reset_env(_get< Env >(storage), seed);
+         return observation_type(detail::reset_observation(result));
+      },
+      .step = [](std::byte* storage, const action_type& action) {
+         auto&& result = _get< Env >(storage).step(action);
+         return step_return_type{
+            observation_type(std::get< 0 >(result)),
+            static_cast< double >(std::get< 1 >(result)),
+            std::get< 2 >(result),
+            std::get< 3 >(result)
+         };
+      },
+      .close = [](std::byte* storage) {
+         if constexpr(requires { _get< Env >(storage).close(); }) {
+            _get< Env >(storage).close();
+         }
+      },
+      .step_batch = [](std::span< AnyEnv > envs, size_t first_row, const batch_buffers& buffers) {
+         for(size_t j = 0; j < envs.size(); ++j) {
+            auto& any_env = envs[j];
+            const size_t row = first_row + j;
+            auto& env = _get< Env >(any_env.m_storage);
+            auto&& result = env.step(
+               detail::batch_at(any_env.m_action_space, buffers.actions, row)
+            );
+            batch_assign(
+               any_env.m_observation_space, buffers.observations, row, std::get< 0 >(result)
+            );
+            buffers.rewards(row) = static_cast< double >(std::get< 1 >(result));
+            buffers.terminated(row) = std::get< 2 >(result);
+            buffers.truncated(row) = std::get< 3 >(result);
+         }
+      }
+   };
+   return &table;
+}
+
+template < typename ObservationSpace, typename ActionSpace, size_t buffer_size >
+void AnyEnv< ObservationSpace, ActionSpace, buffer_size >::step_batch(
+   std::span< AnyEnv > envs,
+   const action_batch_type& actions,
+   observation_batch_type& observations,
+   xarray< double >& rewards,
+   xarray< bool >& terminated,
+   xarray< bool >& truncated
+)
+{
+   if(detail::batch_length(actions) != envs.size()) {
+      throw std::invalid_argument(fmt::format(
+         "Expected one action for each of the {} environments, got {}.",
+         envs.size(),
+         detail::batch_length(actions)
+      ));
+   }
+   if(std::ranges::any_of(envs, &AnyEnv::empty)) {
+      throw std::logic_error("empty AnyEnv");
+   }
+   const batch_buffers buffers{actions, observations, rewards, terminated, truncated};
+   size_t begin = 0;
+   while(begin < envs.size()) {
+      const vtable* table = envs[begin].m_vtable;
+      size_t end = begin + 1;
+      while(end < envs.size() and envs[end].m_vtable == table) {
+         ++end;
+      }
+      table->step_batch(envs.subspan(begin, end - begin), begin, buffers);
+      begin = end;
+   }
+}
+
+}  // namespace force
+
+#endif  // REINFORCE_ANY_ENV_HPP
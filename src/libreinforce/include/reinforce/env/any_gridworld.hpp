@@ -0,0 +1,55 @@
+#ifndef REINFORCE_ANY_GRIDWORLD_HPP
+#define REINFORCE_ANY_GRIDWORLD_HPP
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+
+#include "reinforce/env/any_env.hpp"
+#include "reinforce/env/gridworld.hpp"
+#include "reinforce/spaces/discrete.hpp"
+#include "reinforce/spaces/multi_discrete.hpp"
+#include "reinforce/spaces/tuple.hpp"
+#include "reinforce/utils/macro.hpp"
+
+namespace force {
+
+namespace detail {
+
+template < size_t... dims >
+constexpr size_t max_gridworld_size(std::index_sequence< dims... >)
+{
+   return std::max({sizeof(Gridworld< dims + 1 >)...});
+}
+
+}  // namespace detail
+
+/// Gridworlds of the dimensions 1 to 5 behind a single type, with room for any of them inline.
+using AnyGridworld = AnyEnv<
+   TupleSpace< DiscreteSpace< size_t >, MultiDiscreteSpace< size_t > >,
+   DiscreteSpace< size_t >,
+   detail::max_gridworld_size(std::make_index_sequence< 5 >{}) >;
+
+/// Construct a `Gridworld< dim >` from `args` for a dimension only known at runtime.
+template < typename... Args >
+AnyGridworld make_any_gridworld(size_t dim, Args&&... args)
+{
+   switch(dim) {
+      case 1: return AnyGridworld{Gridworld< 1 >(FWD(args)...)};
+      case 2: return AnyGridworld{Gridworld< 2 >(FWD(args)...)};
+      case 3: return AnyGridworld{Gridworld< 3 >(FWD(args)...)};
+      case 4: return AnyGridworld{Gridworld< 4 >(FWD(args)...)};
+      case 5: return AnyGridworld{Gridworld< 5 >(FWD(args)...)};
+      default:
+         throw std::invalid_argument(
+            fmt::format("AnyGridworld supports the dimensions 1 to 5, got {}.", dim)
+         );
+   }
+}
+
+}  // namespace force
+
+#endif  // REINFORCE_ANY_GRIDWORLD_HPP
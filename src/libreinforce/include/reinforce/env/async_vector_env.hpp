@@ -0,0 +1,438 @@
+#ifndef REINFORCE_ASYNC_VECTOR_ENV_HPP
+#define REINFORCE_ASYNC_VECTOR_ENV_HPP
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "reinforce/env/vector_env.hpp"
+#include "reinforce/spaces/batching.hpp"
+#include "reinforce/utils/macro.hpp"
+#include "reinforce/utils/mpsc_queue.hpp"
+#include "reinforce/utils/thread_pool.hpp"
+#include "reinforce/utils/topology.hpp"
+#include "reinforce/utils/xtensor_typedefs.hpp"
+
+namespace force {
+
+/// @brief Steps environments on a thread pool and hands back whichever finish first (as EnvPool).
+///
+/// `send(actions, env_ids)` queues one step for each of the given environments and returns at
+/// once. `recv(k)` blocks until k of the environments in flight have finished and gathers their
+/// results into rows [0, k) of preallocated batch buffers, together with their environment ids.
+/// Every worker owns a contiguous block of the environments and their steps are queued at it, idle
+/// workers steal from the others. Workers report finished environments through a lock-free queue.
+///
+/// Every worker writes the result of its environment into the environment's own row of a staging
+/// batch, `recv` copies the rows of the k finished environments into the output batch. If the
+/// workers are pinned to cores (see `placement`), each worker copies the state of its environments
+/// and first writes their staging rows at construction, placing both on the worker's NUMA node.
+/// Finished environments are reset right away as in SyncVectorEnv. An environment may only be sent
+/// again after it was received. Info maps are not collected.
+template < detail::vectorizable_env Env >
+class AsyncVectorEnv {
+  public:
+   using env_type = Env;
+   using single_observation_space_type = detail::observation_space_of_t< Env >;
+   using single_action_space_type = detail::action_space_of_t< Env >;
+   using observation_space_type = batched_space_t< single_observation_space_type >;
+   using action_space_type = batched_space_t< single_action_space_type >;
+   using observation_batch_type = detail::value_t< observation_space_type >;
+   using action_batch_type = detail::value_t< action_space_type >;
+   using recv_return_type = std::tuple<
+      std::span< const size_t >,
+      const observation_batch_type&,
+      const xarray< double >&,
+      const xarray< bool >&,
+      const xarray< bool >& >;
+
+   /// Step the environments on `n_threads` workers, pinned to `cores` if given (see ThreadPool).
+   explicit AsyncVectorEnv(
+      std::vector< Env > envs,
+      size_t n_threads = std::thread::hardware_concurrency(),
+      std::vector< size_t > cores = {}
+   );
+
+   /// Step the environments on `n_threads` workers placed on the CPUs of `topology` by `policy`.
+   AsyncVectorEnv(
+      std::vector< Env > envs,
+      size_t n_threads,
+      placement policy,
+      const Topology& topology = Topology::query()
+   )
+       : AsyncVectorEnv(std::move(envs), n_threads, place_workers(topology, n_threads, policy))
+   {
+   }
+
+   /// Create `n` environments with `make_env(i)`.
+   template < typename Factory, typename... Args >
+      requires std::convertible_to< std::invoke_result_t< Factory&, size_t >, Env >
+   AsyncVectorEnv(size_t n, Factory&& make_env, Args&&... args)
+       : AsyncVectorEnv(_make_envs(n, make_env), FWD(args)...)
+   {
+   }
+
+   AsyncVectorEnv(const AsyncVectorEnv&) = delete;
+   AsyncVectorEnv& operator=(const AsyncVectorEnv&) = delete;
+
+   /// Queue a reset of all environments, environment i seeded with `seed + i` if a seed is given.
+   /// No environment may be in flight.
+   void async_reset(std::optional< size_t > seed = std::nullopt);
+
+   /// Queue a step of environment `env_ids[j]` with action j of `actions` for every j.
+   void send(const action_batch_type& actions, std::span< const size_t > env_ids);
+   /// Queue a step of every environment.
+   void send(const action_batch_type& actions) { send(actions, m_all_ids); }
+
+   /// Wait for `k` environments in flight to finish. Only rows [0, k) of the buffers are valid.
+   recv_return_type recv(size_t k);
+   /// Wait for all environments in flight to finish.
+   recv_return_type recv() { return recv(m_nr_in_flight); }
+
+   /// Step all environments and wait for all of them. Row j of the result belongs to the
+   /// environment with id j of the returned ids.
+   recv_return_type step(const action_batch_type& actions)
+   {
+      send(actions);
+      return recv();
+   }
+
+   [[nodiscard]] size_t size() const { return m_envs.size(); }
+   [[nodiscard]] size_t nr_in_flight() const { return m_nr_in_flight; }
+   [[nodiscard]] size_t nr_threads() const { return m_pool->size(); }
+
+   [[nodiscard]] auto& envs() const { return m_envs; }
+
+   [[nodiscard]] auto& observation_space() const { return m_observation_space; }
+   [[nodiscard]] auto& action_space() const { return m_action_space; }
+   [[nodiscard]] auto& single_observation_space() const { return m_single_observation_space; }
+   [[nodiscard]] auto& single_action_space() const { return m_single_action_space; }
+
+   [[nodiscard]] auto& final_observations() const { return m_final_observations; }
+
+  private:
+   std::vector< Env > m_envs;
+   single_observation_space_type m_single_observation_space;
+   single_action_space_type m_single_action_space;
+   observation_space_type m_observation_space;
+   action_space_type m_action_space;
+   std::vector< size_t > m_all_ids;
+
+   /// row i belongs to environment i
+   action_batch_type m_staged_actions;
+   observation_batch_type m_staged_observations;
+   observation_batch_type m_staged_final_observations;
+   xarray< double > m_staged_rewards;
+   xarray< bool > m_staged_terminated;
+   xarray< bool > m_staged_truncated;
+   std::vector< std::exception_ptr > m_errors;
+
+   /// row j belongs to the j-th received environment
+   std::vector< size_t > m_env_ids;
+   observation_batch_type m_observations;
+   observation_batch_type m_final_observations;
+   xarray< double > m_rewards;
+   xarray< bool > m_terminated;
+   xarray< bool > m_truncated;
+
+   /// only touched by the thread calling send and recv
+   std::vector< uint8_t > m_in_flight;
+   size_t m_nr_in_flight = 0;
+   MpscQueue< size_t > m_finished;
+   /// declared last, so that the workers are joined before any buffer is destroyed
+   std::unique_ptr< ThreadPool > m_pool;
+
+   template < typename Factory >
+   static std::vector< Env > _make_envs(size_t n, Factory& make_env)
+   {
+      std::vector< Env > envs;
+      envs.reserve(n);
+      for(size_t i = 0; i < n; ++i) {
+         envs.emplace_back(make_env(i));
+      }
+      return envs;
+   }
+
+   static std::vector< Env > _non_empty(std::vector< Env > envs)
+   {
+      if(envs.empty()) {
+         throw std::invalid_argument("A vector env needs at least one environment.");
+      }
+      return envs;
+   }
+
+   /// the worker owning the environment
+   [[nodiscard]] size_t _worker_of(size_t env_id) const { return env_id * nr_threads() / size(); }
+
+   void _mark_in_flight(size_t env_id)
+   {
+      m_in_flight[env_id] = 1;
+      ++m_nr_in_flight;
+   }
+
+   /// write every staging row and copy every environment on the worker owning it
+   void _first_touch(const std::vector< size_t >& cores);
+   /// runs on a worker
+   void _reset_env(size_t env_id, std::optional< size_t > seed);
+   /// runs on a worker
+   void _step_env(size_t env_id);
+};
+
+template < detail::vectorizable_env Env >
+AsyncVectorEnv< Env >::AsyncVectorEnv(
+   std::vector< Env > envs,
+   size_t n_threads,
+   std::vector< size_t > cores
+)
+    : m_envs(_non_empty(std::move(envs))),
+      m_single_observation_space(m_envs.front().observation_space()),
+      m_single_action_space(m_envs.front().action_space()),
+      m_observation_space(batch_space(m_single_observation_space, m_envs.size())),
+      m_action_space(batch_space(m_single_action_space, m_envs.size())),
+      m_all_ids(m_envs.size()),
+      // samples have the full shape of the batches, the buffers are only written into afterwards
+      m_staged_actions(detail::uninitialized_like(m_action_space.sample())),
+      m_staged_observations(detail::uninitialized_like(m_observation_space.sample())),
+      m_staged_final_observations(detail::uninitialized_like(m_staged_observations)),
+      m_staged_rewards(xarray< double >::from_shape({m_envs.size()})),
+      m_staged_terminated(xarray< bool >::from_shape({m_envs.size()})),
+      m_staged_truncated(xarray< bool >::from_shape({m_envs.size()})),
+      m_errors(m_envs.size()),
+      m_env_ids(m_envs.size()),
+      m_observations(m_observation_space.sample()),
+      m_final_observations(m_observations),
+      m_rewards(xt::zeros< double >({m_envs.size()})),
+      m_terminated(xt::zeros< bool >({m_envs.size()})),
+      m_truncated(xt::zeros< bool >({m_envs.size()})),
+      m_in_flight(m_envs.size(), 0),
+      m_finished(m_envs.size()),
+      m_pool(std::make_unique< ThreadPool >(std::min(n_threads, m_envs.size()), cores))
+{
+   std::iota(m_all_ids.begin(), m_all_ids.end(), size_t{0});
+   _first_touch(cores);
+}
+
+template < detail::vectorizable_env Env >
+void AsyncVectorEnv< Env >::_first_touch(const std::vector< size_t >& cores)
+{
+   const auto& observations = m_observations;
+   const auto actions = m_action_space.sample();
+   auto touch = [&](size_t worker) {
+      for(size_t env_id = 0; env_id < size(); ++env_id) {
+         if(_worker_of(env_id) != worker) {
+            continue;
+         }
+         if constexpr(std::is_copy_constructible_v< Env > and std::is_move_assignable_v< Env >) {
+            if(not cores.empty()) {
+               // the copy allocates the environment's state on the calling worker's node
+               m_envs[env_id] = Env(std::as_const(m_envs[env_id]));
+            }
+         }
+         auto&& observation = detail::batch_at(m_single_observation_space, observations, env_id);
+         batch_assign(m_single_observation_space, m_staged_observations, env_id, observation);
+         batch_assign(m_single_observation_space, m_staged_final_observations, env_id, observation);
+         batch_assign(
+            m_single_action_space,
+            m_staged_actions,
+            env_id,
+            detail::batch_at(m_single_action_space, actions, env_id)
+         );
+         m_staged_rewards(env_id) = 0.;
+         m_staged_terminated(env_id) = false;
+         m_staged_truncated(env_id) = false;
+      }
+   };
+   if(cores.empty()) {
+      for(size_t worker = 0; worker < nr_threads(); ++worker) {
+         touch(worker);
+      }
+      return;
+   }
+   // the same cores as the pool's workers
+   std::vector< size_t > worker_cores(nr_threads());
+   for(size_t worker = 0; worker < nr_threads(); ++worker) {
+      worker_cores[worker] = cores[worker % cores.size()];
+   }
+   run_pinned(worker_cores, touch);
+}
+
+template < detail::vectorizable_env Env >
+void AsyncVectorEnv< Env >::async_reset(std::optional< size_t > seed)
+{
+   if(m_nr_in_flight > 0) {
+      throw std::logic_error(fmt::format(
+         "Cannot reset while {} environments are in flight, receive them first.", m_nr_in_flight
+      ));
+   }
+   for(size_t env_id = 0; env_id < size(); ++env_id) {
+      _mark_in_flight(env_id);
+      std::optional< size_t > env_seed = std::nullopt;
+      if(seed.has_value()) {
+         env_seed = *seed + env_id;
+      }
+      m_pool->submit(_worker_of(env_id), [this, env_id, env_seed] {
+         _reset_env(env_id, env_seed);
+      });
+   }
+}
+
+template < detail::vectorizable_env Env >
+void AsyncVectorEnv< Env >::send(
+   const action_batch_type& actions,
+   std::span< const size_t > env_ids
+)
+{
+   if(detail::batch_length(actions) != env_ids.size()) {
+      throw std::invalid_argument(fmt::format(
+         "Expected one action for each of the {} environments, got {}.",
+         env_ids.size(),
+         detail::batch_length(actions)
+      ));
+   }
+   for(size_t env_id : env_ids) {
+      if(env_id >= size()) {
+         throw std::out_of_range(
+            fmt::format("Environment id {} out of range for {} environments.", env_id, size())
+         );
+      }
+      if(m_in_flight[env_id] != 0) {
+         throw std::logic_error(
+            fmt::format("Environment {} is still in flight, receive it first.", env_id)
+         );
+      }
+   }
+   for(size_t j = 0; j < env_ids.size(); ++j) {
+      const size_t env_id = env_ids[j];
+      batch_assign(
+         m_single_action_space,
+         m_staged_actions,
+         env_id,
+         detail::batch_at(m_single_action_space, actions, j)
+      );
+      _mark_in_flight(env_id);
+      // queueing happens-after the staged action was written, the worker sees the action
+      m_pool->submit(_worker_of(env_id), [this, env_id] { _step_env(env_id); });
+   }
+}
+
+template < detail::vectorizable_env Env >
+auto AsyncVectorEnv< Env >::recv(size_t k) -> recv_return_type
+{
+   if(k > m_nr_in_flight) {
+      throw std::invalid_argument(fmt::format(
+         "Cannot receive {} environments with only {} in flight.", k, m_nr_in_flight
+      ));
+   }
+   const auto& staged_observations = m_staged_observations;
+   const auto& staged_final_observations = m_staged_final_observations;
+   for(size_t row = 0; row < k; ++row) {
+      size_t env_id = 0;
+      m_finished.pop_wait(env_id);
+      m_in_flight[env_id] = 0;
+      --m_nr_in_flight;
+      if(auto error = std::exchange(m_errors[env_id], nullptr)) {
+         std::rethrow_exception(error);
+      }
+      m_env_ids[row] = env_id;
+      m_rewards(row) = m_staged_rewards(env_id);
+      m_terminated(row) = m_staged_terminated(env_id);
+      m_truncated(row) = m_staged_truncated(env_id);
+      batch_assign(
+         m_single_observation_space,
+         m_observations,
+         row,
+         detail::batch_at(m_single_observation_space, staged_observations, env_id)
+      );
+      if(m_terminated(row) or m_truncated(row)) {
+         batch_assign(
+            m_single_observation_space,
+            m_final_observations,
+            row,
+            detail::batch_at(m_single_observation_space, staged_final_observations, env_id)
+         );
+      }
+   }
+   return {
+      std::span< const size_t >{m_env_ids.data(), k},
+      m_observations,
+      m_rewards,
+      m_terminated,
+      m_truncated
+   };
+}
+
+template < detail::vectorizable_env Env >
+void AsyncVectorEnv< Env >::_reset_env(size_t env_id, std::optional< size_t > seed)
+{
+   try {
+      auto&& result = detail::reset_env(m_envs[env_id], seed);
+      batch_assign(
+         m_single_observation_space,
+         m_staged_observations,
+         env_id,
+         detail::reset_observation(result)
+      );
+      m_staged_rewards(env_id) = 0.;
+      m_staged_terminated(env_id) = false;
+      m_staged_truncated(env_id) = false;
+   } catch(...) {
+      m_errors[env_id] = std::current_exception();
+   }
+   m_finished.try_push(env_id);
+}
+
+template < detail::vectorizable_env Env >
+void AsyncVectorEnv< Env >::_step_env(size_t env_id)
+{
+   try {
+      auto& env = m_envs[env_id];
+      const auto& staged_actions = m_staged_actions;
+      auto&& result = env.step(detail::batch_at(m_single_action_space, staged_actions, env_id));
+      const bool terminated = std::get< 2 >(result);
+      const bool truncated = std::get< 3 >(result);
+      m_staged_rewards(env_id) = static_cast< double >(std::get< 1 >(result));
+      m_staged_terminated(env_id) = terminated;
+      m_staged_truncated(env_id) = truncated;
+      if(terminated or truncated) {
+         batch_assign(
+            m_single_observation_space,
+            m_staged_final_observations,
+            env_id,
+            std::get< 0 >(result)
+         );
+         auto&& reset_result = detail::reset_env(env, std::nullopt);
+         batch_assign(
+            m_single_observation_space,
+            m_staged_observations,
+            env_id,
+            detail::reset_observation(reset_result)
+         );
+      } else {
+         batch_assign(
+            m_single_observation_space, m_staged_observations, env_id, std::get< 0 >(result)
+         );
+      }
+   } catch(...) {
+      m_errors[env_id] = std::current_exception();
+   }
+   // never full, since every environment is in flight at most once
+   m_finished.try_push(env_id);
+}
+
+}  // namespace force
+
+#endif  // REINFORCE_ASYNC_VECTOR_ENV_HPP
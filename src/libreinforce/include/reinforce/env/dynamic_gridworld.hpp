@@ -0,0 +1,179 @@
+#ifndef REINFORCE_DYNAMIC_GRIDWORLD_HPP
+#define REINFORCE_DYNAMIC_GRIDWORLD_HPP
+
+#include <cstddef>
+#include <optional>
+#include <random>
+#include <span>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
+#include <xtensor/xstorage.hpp>
+
+#include "reinforce/env/gridworld.hpp"
+#include "reinforce/spaces/discrete.hpp"
+#include "reinforce/spaces/multi_discrete.hpp"
+#include "reinforce/spaces/tuple.hpp"
+#include "reinforce/utils/xtensor_typedefs.hpp"
+
+namespace force {
+
+namespace detail {
+
+/// the largest dimension with a compiled Gridworld< dim > behind DynamicGridworld
+constexpr size_t max_static_grid_dim = 6;
+
+using grid_coordinates = xt::svector< size_t, max_static_grid_dim >;
+
+/// @brief The rules of Gridworld with the dimension as a runtime value.
+///
+/// Backs DynamicGridworld for the dimensions without a compiled Gridworld< dim >. Mirrors
+/// Gridworld< dim > member by member, with loops over the dimension instead of fixed-size tensors.
+class GenericGridworld {
+  public:
+   using obs_type = std::pair< size_t, grid_coordinates >;
+
+   GenericGridworld(
+      size_t dim,
+      const std::vector< size_t >& shape,
+      const idx_pyarray& start_states,
+      const idx_pyarray& goal_states,
+      const std::variant< double, pyarray< double > >& goal_reward,
+      double step_reward,
+      const std::optional< idx_pyarray >& start_states_prob_weights,
+      const std::variant< double, pyarray< double > >& transition_matrix,
+      const std::optional< idx_pyarray >& subgoal_states,
+      const std::variant< double, pyarray< double > >& subgoal_states_reward,
+      const std::optional< idx_pyarray >& obs_states,
+      const std::optional< idx_pyarray >& restart_states,
+      double restart_states_reward
+   );
+
+   std::tuple< obs_type, double, bool, bool > step(size_t action);
+   const obs_type& reset(std::optional< std::mt19937_64::result_type > seed = std::nullopt);
+   void reseed(std::mt19937_64::result_type seed) { m_rng = std::mt19937_64{seed}; }
+
+   [[nodiscard]] grid_coordinates coord_state(size_t state_index) const;
+   [[nodiscard]] size_t index_state(std::span< const size_t > coordinates) const;
+   [[nodiscard]] bool is_terminal(size_t state_index) const;
+
+   [[nodiscard]] size_t dim() const { return m_dim; }
+   [[nodiscard]] size_t num_actions() const { return 2 * m_dim; }
+   [[nodiscard]] size_t size() const { return m_size; }
+   [[nodiscard]] auto& shape() const { return m_grid_shape; }
+   [[nodiscard]] auto& location() const { return m_location.second; }
+   [[nodiscard]] auto& location_idx() const { return m_location.first; }
+   [[nodiscard]] auto& step_reward() const { return m_step_reward; }
+   [[nodiscard]] auto& action_space() const { return m_action_space; }
+   [[nodiscard]] auto& observation_space() const { return m_obs_space; }
+   [[nodiscard]] auto& reward_range() const { return m_reward_range; }
+
+  private:
+   size_t m_dim;
+   grid_coordinates m_grid_shape;
+   /// entry i holds the product of the grid shape after dimension i
+   grid_coordinates m_grid_shape_products;
+   size_t m_size;
+   /// shape (n, dim)
+   idx_xarray m_start_states;
+   std::discrete_distribution< size_t > m_start_state_distribution;
+   /// shape (N, A, A) as in Gridworld
+   xarray< double > m_transition_tensor;
+   std::unordered_map< size_t, std::pair< StateType, double > > m_reward_map;
+   double m_step_reward;
+   obs_type m_location{};
+   DiscreteSpace< size_t > m_action_space;
+   TupleSpace< DiscreteSpace< size_t >, MultiDiscreteSpace< size_t > > m_obs_space;
+   std::pair< double, double > m_reward_range;
+   std::mt19937_64 m_rng{std::random_device{}()};
+
+   void _enter_rewards(
+      StateType state_type,
+      const idx_xarray& states,
+      const std::variant< double, pyarray< double > >& reward
+   );
+};
+
+}  // namespace detail
+
+/// @brief A Gridworld whose dimension is a constructor argument.
+///
+/// Takes the arguments of Gridworld< dim > after the dimension and follows the same rules, so
+/// bindings and configurations can choose the dimension at runtime without instantiating Gridworld
+/// for every dimension they might need. Coordinates are 1-D tensors, so observations can be written
+/// into the batches of vector envs as those of Gridworld< dim >. The dimensions 1 to 6 are stepped
+/// by a compiled Gridworld< dim > held inside, all higher ones by a generic implementation looping
+/// over the dimension. Everything dimension-specific is compiled into the library once.
+class DynamicGridworld {
+  public:
+   using coordinates_type = xtensor< size_t, 1 >;
+   using obs_type = std::pair< size_t, coordinates_type >;
+
+   DynamicGridworld(
+      size_t dim,
+      const std::vector< size_t >& shape,
+      const idx_pyarray& start_states,
+      const idx_pyarray& goal_states,
+      const std::variant< double, pyarray< double > >& goal_reward,
+      double step_reward = 0.,
+      const std::optional< idx_pyarray >& start_states_prob_weights = {},
+      const std::variant< double, pyarray< double > >& transition_matrix = double{1.},
+      const std::optional< idx_pyarray >& subgoal_states = {},
+      const std::variant< double, pyarray< double > >& subgoal_states_reward = double{0.},
+      const std::optional< idx_pyarray >& obs_states = {},
+      const std::optional< idx_pyarray >& restart_states = {},
+      double restart_states_reward = 0.
+   );
+
+   std::tuple< obs_type, double, bool, bool > step(size_t action);
+   const obs_type& reset(std::optional< std::mt19937_64::result_type > seed = std::nullopt);
+   void reseed(std::mt19937_64::result_type seed);
+   /// a gridworld environment currently does not require any external streams to be opened.
+   void close() const {}
+
+   [[nodiscard]] coordinates_type coord_state(size_t state_index) const;
+   [[nodiscard]] size_t index_state(std::span< const size_t > coordinates) const;
+   [[nodiscard]] size_t index_state(const coordinates_type& coordinates) const
+   {
+      return index_state(std::span{coordinates.data(), coordinates.size()});
+   }
+   [[nodiscard]] bool is_terminal(size_t state_index) const;
+
+   [[nodiscard]] size_t dim() const { return m_dim; }
+   [[nodiscard]] size_t num_actions() const { return 2 * m_dim; }
+   [[nodiscard]] size_t size() const;
+   [[nodiscard]] auto& shape() const { return m_grid_shape; }
+   [[nodiscard]] auto& location() const { return m_location.second; }
+   [[nodiscard]] auto& location_idx() const { return m_location.first; }
+   [[nodiscard]] double step_reward() const;
+   /// whether a compiled Gridworld< dim > steps this grid
+   [[nodiscard]] bool is_static() const { return m_dim <= detail::max_static_grid_dim; }
+
+   [[nodiscard]] const DiscreteSpace< size_t >& action_space() const;
+   [[nodiscard]] const TupleSpace< DiscreteSpace< size_t >, MultiDiscreteSpace< size_t > >&
+   observation_space() const;
+   [[nodiscard]] const std::pair< double, double >& reward_range() const;
+
+  private:
+   size_t m_dim;
+   detail::grid_coordinates m_grid_shape;
+   std::variant<
+      Gridworld< 1 >,
+      Gridworld< 2 >,
+      Gridworld< 3 >,
+      Gridworld< 4 >,
+      Gridworld< 5 >,
+      Gridworld< 6 >,
+      detail::GenericGridworld >
+      m_grid;
+   /// the location of the grid in tensor coordinates
+   obs_type m_location{};
+
+   void _sync_location();
+};
+
+}  // namespace force
+
+#endif  // REINFORCE_DYNAMIC_GRIDWORLD_HPP
@@ -0,0 +1,551 @@
+#ifndef REINFORCE_PROCESS_VECTOR_ENV_HPP
+#define REINFORCE_PROCESS_VECTOR_ENV_HPP
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <xtensor/xadapt.hpp>
+
+#include "reinforce/env/vector_env.hpp"
+#include "reinforce/spaces/batching.hpp"
+#include "reinforce/utils/exceptions.hpp"
+#include "reinforce/utils/macro.hpp"
+#include "reinforce/utils/process.hpp"
+#include "reinforce/utils/shared_memory.hpp"
+#include "reinforce/utils/thread_pool.hpp"
+#include "reinforce/utils/topology.hpp"
+#include "reinforce/utils/type_traits.hpp"
+#include "reinforce/utils/xtensor_typedefs.hpp"
+
+namespace force {
+
+namespace detail {
+
+/// @brief Hands out consecutive, cache line aligned arrays of a shared memory region.
+///
+/// Without a base pointer it only counts the bytes needed, so that the same layout code first
+/// sizes the region and then carves it up.
+struct shared_arena {
+   static constexpr size_t alignment = 64;
+
+   std::byte* base = nullptr;
+   size_t offset = 0;
+
+   template < typename T >
+   T* allocate(size_t count)
+   {
+      offset = (offset + alignment - 1) / alignment * alignment;
+      T* data = base == nullptr ? nullptr : reinterpret_cast< T* >(base + offset);
+      offset += count * sizeof(T);
+      return data;
+   }
+};
+
+/// an array viewing memory it does not own
+template < typename T >
+using shared_array_t = decltype(xt::adapt(
+   std::declval< T* >(),
+   size_t{},
+   xt::no_ownership(),
+   std::declval< const xt::svector< size_t >& >()
+));
+
+template < typename T >
+shared_array_t< T > make_shared_array(shared_arena& arena, const xt::svector< size_t >& shape)
+{
+   size_t size = 1;
+   for(size_t extent : shape) {
+      size *= extent;
+   }
+   return xt::adapt(arena.allocate< T >(size), size, xt::no_ownership(), shape);
+}
+
+/// @brief The layout of a batch of `n` samples of a space in shared memory.
+///
+/// Spaces whose samples are arrays or scalars of fixed shape (Box, Discrete, MultiDiscrete,
+/// MultiBinary and their fixed-shape variants) get one array of shape (n, shape...) in the memory,
+/// tuples and dicts of them the tuple or dict of their subspaces' arrays. The batches have the
+/// structure of the batches of `batch_space(space, n)`, so `batch_at` and `batch_assign` work on
+/// both alike. Spaces with samples of varying size (Text, Graph, Sequence, OneOf) have no layout.
+template < typename SpaceT >
+struct shared_batch;
+
+template < typename SpaceT >
+using shared_batch_t = typename shared_batch< SpaceT >::type;
+
+template < typename SpaceT >
+concept fixed_shape_space = has_data_type< SpaceT >
+                            and (xt::is_xexpression< value_t< SpaceT > >::value
+                                 or std::is_arithmetic_v< value_t< SpaceT > >)
+                            and not is_specialization_v< SpaceT, TupleSpace >
+                            and not is_specialization_v< SpaceT, DictSpace >;
+
+template < fixed_shape_space SpaceT >
+struct shared_batch< SpaceT > {
+   using type = shared_array_t< data_t< SpaceT > >;
+
+   static type make(const SpaceT& space, size_t n, shared_arena& arena)
+   {
+      xt::svector< size_t > shape{n};
+      for(int extent : space.shape()) {
+         shape.push_back(static_cast< size_t >(extent));
+      }
+      return make_shared_array< data_t< SpaceT > >(arena, shape);
+   }
+};
+
+template < typename... Spaces >
+struct shared_batch< TupleSpace< Spaces... > > {
+   using type = std::tuple< shared_batch_t< Spaces >... >;
+
+   static type make(const TupleSpace< Spaces... >& space, size_t n, shared_arena& arena)
+   {
+      return std::invoke(
+         [&]< size_t... Is >(std::index_sequence< Is... >) {
+            // braced initialization keeps the arrays in the order of the subspaces
+            return type{shared_batch< Spaces >::make(space.template get< Is >(), n, arena)...};
+         },
+         std::index_sequence_for< Spaces... >{}
+      );
+   }
+};
+
+template < typename... Entries >
+struct shared_batch< DictSpace< Entries... > > {
+   using type = Dict<
+      typename DictSpace< Entries... >::keys,
+      shared_batch_t< typename Entries::space_type >... >;
+
+   static type make(const DictSpace< Entries... >& space, size_t n, shared_arena& arena)
+   {
+      return std::invoke(
+         [&]< size_t... Is >(std::index_sequence< Is... >) {
+            return type{shared_batch< typename Entries::space_type >::make(
+               space.template get< Is >(), n, arena
+            )...};
+         },
+         std::index_sequence_for< Entries... >{}
+      );
+   }
+};
+
+/// @brief The handshake between the parent and one worker process.
+///
+/// The parent writes the command and then bumps `request`, the worker answers by setting
+/// `response` to the request it served. Both sides sleep on these words with futexes.
+struct alignas(64) worker_channel {
+   enum class command : uint32_t { reset, step, close };
+
+   std::atomic< uint32_t > request{0};
+   std::atomic< uint32_t > response{0};
+   command cmd = command::step;
+   bool has_seed = false;
+   size_t seed = 0;
+   bool failed = false;
+   char error[256] = {};
+};
+
+}  // namespace detail
+
+/// @brief Steps environments in forked worker processes (as gymnasium's AsyncVectorEnv, without
+/// pipes and pickling).
+///
+/// For environments that are not thread-safe. Each of the worker processes owns a contiguous slice
+/// of the environments, forked off the parent together with them at construction. Workers and
+/// parent share one memory region, laid out from the observation and action spaces (see
+/// `detail::shared_batch`): the parent writes the actions into it, the workers write
+/// observations, rewards and flags of their environments straight into the rows of the batches
+/// the parent returns. Nothing is serialized or copied on the way back. Step handshakes use
+/// futexes on the shared memory, so an idle worker sleeps in the kernel.
+///
+/// Finished environments are reset within the same step as in SyncVectorEnv. Info maps are not
+/// collected. Exceptions thrown by an environment are reported by `reset` or `step` as
+/// `force_library_error` with the original message; a worker that dies is reported the same way.
+/// Since the environments live in the workers, the parent holds no environment after construction.
+/// Forking is only safe if no other thread of the parent holds locks the environments need.
+template < detail::vectorizable_env Env >
+class ProcessVectorEnv {
+  public:
+   using env_type = Env;
+   using single_observation_space_type = detail::observation_space_of_t< Env >;
+   using single_action_space_type = detail::action_space_of_t< Env >;
+   using observation_space_type = batched_space_t< single_observation_space_type >;
+   using action_space_type = batched_space_t< single_action_space_type >;
+   /// the batches in shared memory
+   using observation_batch_type = detail::shared_batch_t< single_observation_space_type >;
+   using reward_batch_type = detail::shared_array_t< double >;
+   using flag_batch_type = detail::shared_array_t< bool >;
+   using action_batch_type = detail::value_t< action_space_type >;
+   using step_return_type = std::tuple<
+      const observation_batch_type&,
+      const reward_batch_type&,
+      const flag_batch_type&,
+      const flag_batch_type& >;
+
+   /// Step the environments in `n_workers` processes, pinned to CPUs of `topology` by `policy`.
+   explicit ProcessVectorEnv(
+      std::vector< Env > envs,
+      size_t n_workers = std::thread::hardware_concurrency(),
+      placement policy = placement::none,
+      const Topology& topology = Topology::query()
+   );
+
+   /// Create `n` environments with `make_env(i)`.
+   template < typename Factory, typename... Args >
+      requires std::convertible_to< std::invoke_result_t< Factory&, size_t >, Env >
+   ProcessVectorEnv(size_t n, Factory&& make_env, Args&&... args)
+       : ProcessVectorEnv(_make_envs(n, make_env), FWD(args)...)
+   {
+   }
+
+   ProcessVectorEnv(const ProcessVectorEnv&) = delete;
+   ProcessVectorEnv& operator=(const ProcessVectorEnv&) = delete;
+
+   ~ProcessVectorEnv() { close(); }
+
+   /// Reset all environments. Environment i is seeded with `seed + i` if a seed is given.
+   const observation_batch_type& reset(std::optional< size_t > seed = std::nullopt)
+   {
+      _request(detail::worker_channel::command::reset, seed);
+      _await();
+      return m_shared.observations;
+   }
+
+   /// Step environment i with action i of `actions`.
+   step_return_type step(const action_batch_type& actions);
+
+   /// Stop the workers, closing their environments. Further calls do nothing.
+   void close();
+
+   [[nodiscard]] size_t size() const { return m_size; }
+   [[nodiscard]] size_t nr_workers() const { return m_workers.size(); }
+
+   [[nodiscard]] auto& observation_space() const { return m_observation_space; }
+   [[nodiscard]] auto& action_space() const { return m_action_space; }
+   [[nodiscard]] auto& single_observation_space() const { return m_single_observation_space; }
+   [[nodiscard]] auto& single_action_space() const { return m_single_action_space; }
+
+   [[nodiscard]] auto& observations() const { return m_shared.observations; }
+   [[nodiscard]] auto& final_observations() const { return m_shared.final_observations; }
+   [[nodiscard]] auto& rewards() const { return m_shared.rewards; }
+   [[nodiscard]] auto& terminated() const { return m_shared.terminated; }
+   [[nodiscard]] auto& truncated() const { return m_shared.truncated; }
+
+  private:
+   /// the views into the shared memory, valid in the parent and all workers alike
+   struct shared_buffers {
+      std::span< detail::worker_channel > channels;
+      observation_batch_type observations;
+      observation_batch_type final_observations;
+      detail::shared_batch_t< single_action_space_type > actions;
+      reward_batch_type rewards;
+      flag_batch_type terminated;
+      flag_batch_type truncated;
+   };
+
+   /// how long to sleep on a futex before checking whether the other side is still alive
+   static constexpr std::chrono::milliseconds liveness_interval{100};
+
+   size_t m_size;
+   single_observation_space_type m_single_observation_space;
+   single_action_space_type m_single_action_space;
+   observation_space_type m_observation_space;
+   action_space_type m_action_space;
+   SharedMemoryRegion m_region;
+   shared_buffers m_shared;
+   /// worker w owns the environments [m_slices[w], m_slices[w + 1])
+   std::vector< size_t > m_slices;
+   std::vector< ChildProcess > m_workers;
+   bool m_closed = false;
+
+   template < typename Factory >
+   static std::vector< Env > _make_envs(size_t n, Factory& make_env)
+   {
+      std::vector< Env > envs;
+      envs.reserve(n);
+      for(size_t i = 0; i < n; ++i) {
+         envs.emplace_back(make_env(i));
+      }
+      return envs;
+   }
+
+   static const std::vector< Env >& _non_empty(const std::vector< Env >& envs)
+   {
+      if(envs.empty()) {
+         throw std::invalid_argument("A vector env needs at least one environment.");
+      }
+      return envs;
+   }
+
+   shared_buffers _carve(detail::shared_arena& arena, size_t n_workers) const
+   {
+      return shared_buffers{
+         .channels = {arena.allocate< detail::worker_channel >(n_workers), n_workers},
+         .observations = detail::shared_batch< single_observation_space_type >::make(
+            m_single_observation_space, m_size, arena
+         ),
+         .final_observations = detail::shared_batch< single_observation_space_type >::make(
+            m_single_observation_space, m_size, arena
+         ),
+         .actions = detail::shared_batch< single_action_space_type >::make(
+            m_single_action_space, m_size, arena
+         ),
+         .rewards = detail::make_shared_array< double >(arena, {m_size}),
+         .terminated = detail::make_shared_array< bool >(arena, {m_size}),
+         .truncated = detail::make_shared_array< bool >(arena, {m_size})
+      };
+   }
+
+   size_t _region_size(size_t n_workers) const
+   {
+      detail::shared_arena arena{};
+      _carve(arena, n_workers);
+      return arena.offset;
+   }
+
+   void _request(detail::worker_channel::command cmd, std::optional< size_t > seed = std::nullopt);
+   void _await();
+
+   /// the loop of worker `worker`, runs in its process
+   int _serve(size_t worker, std::vector< Env >& envs);
+   void _serve_step(Env& env, size_t env_id);
+};
+
+template < detail::vectorizable_env Env >
+ProcessVectorEnv< Env >::ProcessVectorEnv(
+   std::vector< Env > envs,
+   size_t n_workers,
+   placement policy,
+   const Topology& topology
+)
+    : m_size(_non_empty(envs).size()),
+      m_single_observation_space(envs.front().observation_space()),
+      m_single_action_space(envs.front().action_space()),
+      m_observation_space(batch_space(m_single_observation_space, m_size)),
+      m_action_space(batch_space(m_single_action_space, m_size)),
+      m_region(_region_size(std::clamp(n_workers, size_t{1}, m_size))),
+      m_shared([&] {
+         detail::shared_arena arena{.base = m_region.data()};
+         return _carve(arena, std::clamp(n_workers, size_t{1}, m_size));
+      }())
+{
+   n_workers = m_shared.channels.size();
+   for(auto& channel : m_shared.channels) {
+      std::construct_at(&channel);
+   }
+   m_slices.reserve(n_workers + 1);
+   for(size_t w = 0; w <= n_workers; ++w) {
+      m_slices.emplace_back(w * m_size / n_workers);
+   }
+   const auto cpus = place_workers(topology, n_workers, policy);
+   m_workers.reserve(n_workers);
+   for(size_t w = 0; w < n_workers; ++w) {
+      // the worker continues on its copy of the parent's memory, including `envs`
+      m_workers.emplace_back([this, w, &envs, &cpus] {
+         if(not cpus.empty()) {
+            // the pages of its batch rows and of the environment state it writes (copy-on-write)
+            // are then placed on the worker's node
+            pin_this_thread(cpus[w]);
+         }
+         return _serve(w, envs);
+      });
+   }
+}
+
+template < detail::vectorizable_env Env >
+auto ProcessVectorEnv< Env >::step(const action_batch_type& actions) -> step_return_type
+{
+   if(detail::batch_length(actions) != size()) {
+      throw std::invalid_argument(fmt::format(
+         "Expected one action for each of the {} environments, got {}.",
+         size(),
+         detail::batch_length(actions)
+      ));
+   }
+   for(size_t i = 0; i < size(); ++i) {
+      batch_assign(
+         m_single_action_space,
+         m_shared.actions,
+         i,
+         detail::batch_at(m_single_action_space, actions, i)
+      );
+   }
+   _request(detail::worker_channel::command::step);
+   _await();
+   return {m_shared.observations, m_shared.rewards, m_shared.terminated, m_shared.truncated};
+}
+
+template < detail::vectorizable_env Env >
+void ProcessVectorEnv< Env >::close()
+{
+   if(std::exchange(m_closed, true)) {
+      return;
+   }
+   _request(detail::worker_channel::command::close);
+   for(auto& worker : m_workers) {
+      worker.join();
+   }
+}
+
+template < detail::vectorizable_env Env >
+void ProcessVectorEnv< Env >::_request(
+   detail::worker_channel::command cmd,
+   std::optional< size_t > seed
+)
+{
+   if(m_closed and cmd != detail::worker_channel::command::close) {
+      throw std::logic_error("The vector env is closed.");
+   }
+   for(auto& channel : m_shared.channels) {
+      channel.cmd = cmd;
+      channel.has_seed = seed.has_value();
+      channel.seed = seed.value_or(0);
+      // publishes the command and, for steps, the actions written before
+      channel.request.fetch_add(1, std::memory_order_release);
+      detail::futex_wake_all(channel.request);
+   }
+}
+
+template < detail::vectorizable_env Env >
+void ProcessVectorEnv< Env >::_await()
+{
+   for(size_t w = 0; w < m_workers.size(); ++w) {
+      auto& channel = m_shared.channels[w];
+      const uint32_t expected = channel.request.load(std::memory_order_relaxed);
+      while(true) {
+         const uint32_t response = channel.response.load(std::memory_order_acquire);
+         if(response == expected) {
+            break;
+         }
+         if(not detail::futex_wait(channel.response, response, liveness_interval)
+            and not m_workers[w].running()) {
+            m_closed = true;
+            throw force_library_error(fmt::format(
+               "Worker {} exited unexpectedly with status {}.", w, m_workers[w].join()
+            ));
+         }
+      }
+   }
+   for(size_t w = 0; w < m_workers.size(); ++w) {
+      auto& channel = m_shared.channels[w];
+      if(channel.failed) {
+         throw force_library_error(fmt::format(
+            "Environment failed in worker {}: {}",
+            w,
+            std::string_view{channel.error, std::strlen(channel.error)}
+         ));
+      }
+   }
+}
+
+template < detail::vectorizable_env Env >
+int ProcessVectorEnv< Env >::_serve(size_t worker, std::vector< Env >& envs)
+{
+   using command = detail::worker_channel::command;
+   auto& channel = m_shared.channels[worker];
+   uint32_t served = 0;
+   while(true) {
+      uint32_t request = channel.request.load(std::memory_order_acquire);
+      while(request == served) {
+         detail::futex_wait(channel.request, served, liveness_interval);
+         request = channel.request.load(std::memory_order_acquire);
+      }
+      served = request;
+      channel.failed = false;
+      try {
+         for(size_t env_id = m_slices[worker]; env_id < m_slices[worker + 1]; ++env_id) {
+            auto& env = envs[env_id];
+            switch(channel.cmd) {
+               case command::reset: {
+                  std::optional< size_t > seed = std::nullopt;
+                  if(channel.has_seed) {
+                     seed = channel.seed + env_id;
+                  }
+                  auto&& result = detail::reset_env(env, seed);
+                  batch_assign(
+                     m_single_observation_space,
+                     m_shared.observations,
+                     env_id,
+                     detail::reset_observation(result)
+                  );
+                  m_shared.rewards(env_id) = 0.;
+                  m_shared.terminated(env_id) = false;
+                  m_shared.truncated(env_id) = false;
+                  break;
+               }
+               case command::step: {
+                  _serve_step(env, env_id);
+                  break;
+               }
+               case command::close: {
+                  if constexpr(requires { env.close(); }) {
+                     env.close();
+                  }
+                  break;
+               }
+            }
+         }
+      } catch(const std::exception& e) {
+         channel.failed = true;
+         std::strncpy(channel.error, e.what(), sizeof(channel.error) - 1);
+      } catch(...) {
+         channel.failed = true;
+         std::strncpy(channel.error, "unknown exception", sizeof(channel.error) - 1);
+      }
+      channel.response.store(served, std::memory_order_release);
+      detail::futex_wake_all(channel.response);
+      if(channel.cmd == command::close) {
+         return 0;
+      }
+   }
+}
+
+template < detail::vectorizable_env Env >
+void ProcessVectorEnv< Env >::_serve_step(Env& env, size_t env_id)
+{
+   const auto& actions = m_shared.actions;
+   auto&& result = env.step(detail::batch_at(m_single_action_space, actions, env_id));
+   const bool terminated = std::get< 2 >(result);
+   const bool truncated = std::get< 3 >(result);
+   m_shared.rewards(env_id) = static_cast< double >(std::get< 1 >(result));
+   m_shared.terminated(env_id) = terminated;
+   m_shared.truncated(env_id) = truncated;
+   if(not(terminated or truncated)) {
+      batch_assign(
+         m_single_observation_space, m_shared.observations, env_id, std::get< 0 >(result)
+      );
+      return;
+   }
+   batch_assign(
+      m_single_observation_space, m_shared.final_observations, env_id, std::get< 0 >(result)
+   );
+   auto&& reset_result = detail::reset_env(env, std::nullopt);
+   batch_assign(
+      m_single_observation_space,
+      m_shared.observations,
+      env_id,
+      detail::reset_observation(reset_result)
+   );
+}
+
+}  // namespace force
+
+#endif  // REINFORCE_PROCESS_VECTOR_ENV_HPP
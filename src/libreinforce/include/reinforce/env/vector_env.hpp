@@ -0,0 +1,325 @@
+#ifndef REINFORCE_VECTOR_ENV_HPP
+#define REINFORCE_VECTOR_ENV_HPP
+
+#include <fmt/format.h>
+
+#include <any>
+#include <concepts>
+#include <cstddef>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "reinforce/spaces/batching.hpp"
+#include "reinforce/utils/macro.hpp"
+#include "reinforce/utils/type_traits.hpp"
+#include "reinforce/utils/xtensor_typedefs.hpp"
+
+namespace force {
+
+namespace detail {
+
+template < typename Env >
+using observation_space_of_t = raw_t< decltype(std::declval< const Env& >().observation_space()) >;
+
+template < typename Env >
+using action_space_of_t = raw_t< decltype(std::declval< const Env& >().action_space()) >;
+
+template < typename Env >
+using step_result_of_t = raw_t< decltype(std::declval< Env& >().step(
+   std::declval< const value_t< action_space_of_t< Env > >& >()
+)) >;
+
+/// @brief Environments that a vector env can drive.
+///
+/// Besides the `gym_env` environments this admits environments like Gridworld whose `step` returns
+/// (observation, reward, terminated, truncated) without an info map and whose `reset` returns the
+/// observation alone.
+template < typename Env >
+concept vectorizable_env = requires(Env env, const Env const_env) {
+   const_env.observation_space();
+   const_env.action_space();
+   env.reset();
+   requires std::tuple_size_v< step_result_of_t< Env > > >= 4;
+};
+
+template < typename Env >
+decltype(auto) reset_env(Env& env, std::optional< size_t > seed)
+{
+   if constexpr(requires { env.reset(seed); }) {
+      return env.reset(seed);
+   } else {
+      return env.reset();
+   }
+}
+
+/// whether `reset` returns an (observation, info) tuple rather than the observation alone
+template < typename ResetResult >
+constexpr bool reset_returns_info = is_specialization_v< raw_t< ResetResult >, std::tuple >
+                                    and std::tuple_size_v< raw_t< ResetResult > > == 2;
+
+template < typename ResetResult >
+decltype(auto) reset_observation(ResetResult&& result)
+{
+   if constexpr(reset_returns_info< ResetResult >) {
+      return std::get< 0 >(FWD(result));
+   } else {
+      return FWD(result);
+   }
+}
+
+}  // namespace detail
+
+/// @brief Steps n environments one after the other in a single call (as gymnasium's SyncVectorEnv).
+///
+/// Observations, rewards, terminations and truncations are written into batch buffers allocated
+/// once at construction in the layout of the batched observation space (see `batch_space`).
+/// `step` returns references to these buffers, which stay valid until the next call.
+///
+/// Finished environments are reset within the same `step` call: their row of the observation
+/// batch then holds the first observation of the new episode, while the last observation of the
+/// finished episode is kept in `final_observations` (only the rows of finished environments are
+/// meaningful). Info maps are only collected if `step` or `reset` is given a vector to fill.
+template < detail::vectorizable_env Env >
+class SyncVectorEnv {
+  public:
+   using env_type = Env;
+   using single_observation_space_type = detail::observation_space_of_t< Env >;
+   using single_action_space_type = detail::action_space_of_t< Env >;
+   using observation_space_type = batched_space_t< single_observation_space_type >;
+   using action_space_type = batched_space_t< single_action_space_type >;
+   using observation_batch_type = detail::value_t< observation_space_type >;
+   using action_batch_type = detail::value_t< action_space_type >;
+   using info_type = std::unordered_map< std::string, std::any >;
+   using step_return_type = std::tuple<
+      const observation_batch_type&,
+      const xarray< double >&,
+      const xarray< bool >&,
+      const xarray< bool >& >;
+
+   explicit SyncVectorEnv(std::vector< Env > envs);
+
+   /// Create `n` environments with `make_env(i)`.
+   template < typename Factory >
+      requires std::convertible_to< std::invoke_result_t< Factory&, size_t >, Env >
+   SyncVectorEnv(size_t n, Factory&& make_env) : SyncVectorEnv(_make_envs(n, make_env))
+   {
+   }
+
+   /// Reset all environments. Environment i is seeded with `seed + i` if a seed is given.
+   const observation_batch_type& reset(std::optional< size_t > seed = std::nullopt)
+   {
+      _reset(seed, nullptr);
+      return m_observations;
+   }
+   const observation_batch_type&
+   reset(std::optional< size_t > seed, std::vector< info_type >& infos)
+   {
+      _reset(seed, &infos);
+      return m_observations;
+   }
+
+   /// Step environment i with action i of `actions`.
+   step_return_type step(const action_batch_type& actions)
+   {
+      _step(actions, nullptr);
+      return {m_observations, m_rewards, m_terminated, m_truncated};
+   }
+   step_return_type step(const action_batch_type& actions, std::vector< info_type >& infos)
+   {
+      _step(actions, &infos);
+      return {m_observations, m_rewards, m_terminated, m_truncated};
+   }
+
+   /// @brief End the running episode of environment `env_id` from outside (e.g. at a time limit).
+   ///
+   /// Marks the environment as truncated in the buffers of the last `step` and resets it as if it
+   /// had reported the truncation itself. Environments that finished in the last `step` are left
+   /// alone, they have been reset already.
+   void truncate(size_t env_id);
+
+   void close()
+   {
+      for(auto& env : m_envs) {
+         if constexpr(requires { env.close(); }) {
+            env.close();
+         }
+      }
+   }
+
+   [[nodiscard]] size_t size() const { return m_envs.size(); }
+
+   [[nodiscard]] auto& envs() const { return m_envs; }
+   [[nodiscard]] auto& envs() { return m_envs; }
+
+   [[nodiscard]] auto& observation_space() const { return m_observation_space; }
+   [[nodiscard]] auto& action_space() const { return m_action_space; }
+   [[nodiscard]] auto& single_observation_space() const { return m_single_observation_space; }
+   [[nodiscard]] auto& single_action_space() const { return m_single_action_space; }
+
+   [[nodiscard]] auto& observations() const { return m_observations; }
+   [[nodiscard]] auto& final_observations() const { return m_final_observations; }
+   [[nodiscard]] auto& rewards() const { return m_rewards; }
+   [[nodiscard]] auto& terminated() const { return m_terminated; }
+   [[nodiscard]] auto& truncated() const { return m_truncated; }
+
+  private:
+   std::vector< Env > m_envs;
+   single_observation_space_type m_single_observation_space;
+   single_action_space_type m_single_action_space;
+   observation_space_type m_observation_space;
+   action_space_type m_action_space;
+   observation_batch_type m_observations;
+   observation_batch_type m_final_observations;
+   xarray< double > m_rewards;
+   xarray< bool > m_terminated;
+   xarray< bool > m_truncated;
+
+   static std::vector< Env > _non_empty(std::vector< Env > envs)
+   {
+      if(envs.empty()) {
+         throw std::invalid_argument("A vector env needs at least one environment.");
+      }
+      return envs;
+   }
+
+   template < typename Factory >
+   static std::vector< Env > _make_envs(size_t n, Factory& make_env)
+   {
+      std::vector< Env > envs;
+      envs.reserve(n);
+      for(size_t i = 0; i < n; ++i) {
+         envs.emplace_back(make_env(i));
+      }
+      return envs;
+   }
+
+   void _reset(std::optional< size_t > seed, std::vector< info_type >* infos);
+
+   void _step(const action_batch_type& actions, std::vector< info_type >* infos);
+};
+
+template < detail::vectorizable_env Env >
+SyncVectorEnv< Env >::SyncVectorEnv(std::vector< Env > envs)
+    : m_envs(_non_empty(std::move(envs))),
+      m_single_observation_space(m_envs.front().observation_space()),
+      m_single_action_space(m_envs.front().action_space()),
+      m_observation_space(batch_space(m_single_observation_space, m_envs.size())),
+      m_action_space(batch_space(m_single_action_space, m_envs.size())),
+      // a sample has the full shape of the batch, the buffers are only ever written into afterwards
+      m_observations(m_observation_space.sample()),
+      m_final_observations(m_observations),
+      m_rewards(xt::zeros< double >({m_envs.size()})),
+      m_terminated(xt::zeros< bool >({m_envs.size()})),
+      m_truncated(xt::zeros< bool >({m_envs.size()}))
+{
+}
+
+template < detail::vectorizable_env Env >
+void SyncVectorEnv< Env >::_reset(std::optional< size_t > seed, std::vector< info_type >* infos)
+{
+   if(infos != nullptr) {
+      infos->resize(size());
+   }
+   for(size_t i = 0; i < size(); ++i) {
+      auto&& result = detail::reset_env(
+         m_envs[i], seed.has_value() ? std::optional{*seed + i} : std::nullopt
+      );
+      batch_assign(
+         m_single_observation_space, m_observations, i, detail::reset_observation(result)
+      );
+      if(infos != nullptr) {
+         auto& info = (*infos)[i];
+         info.clear();
+         if constexpr(detail::reset_returns_info< decltype(result) >) {
+            info = std::get< 1 >(result);
+         }
+      }
+   }
+   m_rewards.fill(0.);
+   m_terminated.fill(false);
+   m_truncated.fill(false);
+}
+
+template < detail::vectorizable_env Env >
+void SyncVectorEnv< Env >::_step(
+   const action_batch_type& actions,
+   std::vector< info_type >* infos
+)
+{
+   if(detail::batch_length(actions) != size()) {
+      throw std::invalid_argument(fmt::format(
+         "Expected one action for each of the {} environments, got {}.",
+         size(),
+         detail::batch_length(actions)
+      ));
+   }
+   if(infos != nullptr) {
+      infos->resize(size());
+   }
+   for(size_t i = 0; i < size(); ++i) {
+      auto& env = m_envs[i];
+      auto&& result = env.step(detail::batch_at(m_single_action_space, actions, i));
+      const bool terminated = std::get< 2 >(result);
+      const bool truncated = std::get< 3 >(result);
+      m_rewards(i) = static_cast< double >(std::get< 1 >(result));
+      m_terminated(i) = terminated;
+      m_truncated(i) = truncated;
+      if(infos != nullptr) {
+         auto& info = (*infos)[i];
+         info.clear();
+         if constexpr(std::tuple_size_v< detail::raw_t< decltype(result) > > >= 5) {
+            info = std::move(std::get< 4 >(result));
+         }
+      }
+      if(not(terminated or truncated)) {
+         batch_assign(m_single_observation_space, m_observations, i, std::get< 0 >(result));
+         continue;
+      }
+      // auto-reset: the new episode's first observation replaces the final one in the batch
+      batch_assign(m_single_observation_space, m_final_observations, i, std::get< 0 >(result));
+      auto&& reset_result = detail::reset_env(env, std::nullopt);
+      batch_assign(
+         m_single_observation_space, m_observations, i, detail::reset_observation(reset_result)
+      );
+      if constexpr(detail::reset_returns_info< decltype(reset_result) >) {
+         if(infos != nullptr) {
+            // the entries of the step take precedence over those of the reset
+            (*infos)[i].merge(std::get< 1 >(reset_result));
+         }
+      }
+   }
+}
+
+template < detail::vectorizable_env Env >
+void SyncVectorEnv< Env >::truncate(size_t env_id)
+{
+   if(env_id >= size()) {
+      throw std::invalid_argument(fmt::format(
+         "Environment id {} is out of bounds for {} environments.", env_id, size()
+      ));
+   }
+   if(m_terminated(env_id) or m_truncated(env_id)) {
+      return;
+   }
+   m_truncated(env_id) = true;
+   batch_assign(
+      m_single_observation_space,
+      m_final_observations,
+      env_id,
+      detail::batch_at(m_single_observation_space, m_observations, env_id)
+   );
+   auto&& reset_result = detail::reset_env(m_envs[env_id], std::nullopt);
+   batch_assign(
+      m_single_observation_space, m_observations, env_id, detail::reset_observation(reset_result)
+   );
+}
+
+}  // namespace force
+
+#endif  // REINFORCE_VECTOR_ENV_HPP
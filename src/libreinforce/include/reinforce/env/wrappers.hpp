@@ -0,0 +1,531 @@
+#ifndef REINFORCE_WRAPPERS_HPP
+#define REINFORCE_WRAPPERS_HPP
+
+#include <any>
+#include <concepts>
+#include <cstddef>
+#include <deque>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <xtensor/xmath.hpp>
+#include <xtensor/xnoalias.hpp>
+
+#include "reinforce/env/vector_env.hpp"
+#include "reinforce/utils/macro.hpp"
+#include "reinforce/utils/type_traits.hpp"
+#include "reinforce/utils/xtensor_typedefs.hpp"
+
+namespace force {
+
+namespace detail {
+
+/// action spaces with elementwise bounds, as BoxSpace and FixedBoxSpace
+template < typename SpaceT >
+concept bounded_space = requires(const SpaceT& space) {
+   space.low();
+   space.high();
+};
+
+/// vector envs with a synchronous `reset` and `step`, as SyncVectorEnv and ProcessVectorEnv
+template < typename VecEnv >
+concept stepped_vector_env = requires(
+   VecEnv env,
+   const typename VecEnv::action_batch_type& actions
+) {
+   env.reset(std::optional< size_t >{});
+   env.size();
+   env.single_action_space();
+   requires std::tuple_size_v< raw_t< decltype(env.step(actions)) > > == 4;
+};
+
+/// vector envs which can end the episode of a single environment (see SyncVectorEnv::truncate)
+template < typename VecEnv >
+concept truncatable_vector_env = stepped_vector_env< VecEnv >
+                                 and requires(VecEnv env, size_t env_id) { env.truncate(env_id); };
+
+}  // namespace detail
+
+/// @brief Base of the environment wrappers.
+///
+/// A wrapper holds the wrapped environment by value and derives its behaviour from hooks of the
+/// `Derived` wrapper, which are resolved at compile time: `_action` maps the action passed to
+/// `step`, `_on_step` may modify the result of the wrapped `step` in place and `_on_reset` is
+/// called after every reset. Stacks of wrappers are therefore plain nested types whose calls inline
+/// down to the innermost environment. `step` and `reset` return what the wrapped environment
+/// returns, so a wrapper fulfills `gym_env` (or `vectorizable_env`) whenever its environment does.
+template < typename Derived, typename Env >
+class Wrapper {
+  public:
+   using env_type = Env;
+   using action_type = detail::value_t< detail::action_space_of_t< Env > >;
+
+   explicit Wrapper(Env env) : m_env(std::move(env)) {}
+
+   auto step(const action_type& action)
+   {
+      auto result = m_env.step(_self()._action(action));
+      _self()._on_step(result);
+      return result;
+   }
+
+   template < typename... Args >
+      requires requires(Env& env, Args&&... args) { env.reset(FWD(args)...); }
+   decltype(auto) reset(Args&&... args)
+   {
+      decltype(auto) result = m_env.reset(FWD(args)...);
+      _self()._on_reset();
+      return result;
+   }
+
+   void close()
+   {
+      if constexpr(requires { m_env.close(); }) {
+         m_env.close();
+      }
+   }
+
+   /// tell the wrappers inside that the running episode was ended from outside (see TimeLimit)
+   void truncate()
+      requires requires(Env& env) { env.truncate(); }
+   {
+      m_env.truncate();
+   }
+
+   [[nodiscard]] decltype(auto) observation_space() const { return m_env.observation_space(); }
+   [[nodiscard]] decltype(auto) action_space() const { return m_env.action_space(); }
+   [[nodiscard]] decltype(auto) reward_range() const
+      requires requires(const Env& env) { env.reward_range(); }
+   {
+      return m_env.reward_range();
+   }
+
+   /// the environment wrapped by this wrapper
+   [[nodiscard]] auto& env() const { return m_env; }
+   [[nodiscard]] auto& env() { return m_env; }
+   /// the innermost environment of a stack of wrappers
+   [[nodiscard]] auto& unwrapped() const
+   {
+      if constexpr(requires { m_env.unwrapped(); }) {
+         return m_env.unwrapped();
+      } else {
+         return m_env;
+      }
+   }
+   [[nodiscard]] auto& unwrapped()
+   {
+      if constexpr(requires { m_env.unwrapped(); }) {
+         return m_env.unwrapped();
+      } else {
+         return m_env;
+      }
+   }
+
+  protected:
+   Env m_env;
+
+   const action_type& _action(const action_type& action) { return action; }
+   template < typename StepResult >
+   void _on_step(StepResult& /*result*/)
+   {
+   }
+   void _on_reset() {}
+
+  private:
+   Derived& _self() { return static_cast< Derived& >(*this); }
+};
+
+/// Truncates the episode once it has run for `max_episode_steps` steps (as gymnasium's TimeLimit).
+/// Wrappers inside of it which provide `truncate` (e.g. RecordEpisodeStatistics) are told about the
+/// truncation.
+template < typename Env >
+class TimeLimit: public Wrapper< TimeLimit< Env >, Env > {
+  public:
+   using base = Wrapper< TimeLimit< Env >, Env >;
+   friend base;
+
+   TimeLimit(Env env, size_t max_episode_steps)
+       : base(std::move(env)), m_max_episode_steps(max_episode_steps)
+   {
+      if(max_episode_steps == 0) {
+         throw std::invalid_argument("The maximum number of episode steps must be positive.");
+      }
+   }
+
+   [[nodiscard]] size_t max_episode_steps() const { return m_max_episode_steps; }
+   [[nodiscard]] size_t elapsed_steps() const { return m_elapsed_steps; }
+
+  private:
+   size_t m_max_episode_steps;
+   size_t m_elapsed_steps = 0;
+
+   template < typename StepResult >
+   void _on_step(StepResult& result)
+   {
+      if(++m_elapsed_steps < m_max_episode_steps) {
+         return;
+      }
+      if constexpr(requires(Env& env) { env.truncate(); }) {
+         if(not(std::get< 2 >(result) or std::get< 3 >(result))) {
+            this->m_env.truncate();
+         }
+      }
+      std::get< 3 >(result) = true;
+   }
+   void _on_reset() { m_elapsed_steps = 0; }
+};
+
+/// the return and length of a finished episode
+struct EpisodeStatistics {
+   double episode_return;
+   size_t length;
+};
+
+/// @brief Records the return and length of every episode (as gymnasium's RecordEpisodeStatistics).
+///
+/// The statistics of the last `buffer_length` finished episodes are kept. If `step` returns an info
+/// map, the statistics of a finished episode are also entered there under "episode". An episode
+/// ended from outside through `truncate`, e.g. by a TimeLimit wrapped around this wrapper, is
+/// recorded right there (without an info entry). Episodes cut short by a `reset` are discarded.
+template < typename Env >
+class RecordEpisodeStatistics: public Wrapper< RecordEpisodeStatistics< Env >, Env > {
+  public:
+   using base = Wrapper< RecordEpisodeStatistics< Env >, Env >;
+   friend base;
+
+   explicit RecordEpisodeStatistics(Env env, size_t buffer_length = 100)
+       : base(std::move(env)), m_buffer_length(buffer_length)
+   {
+   }
+
+   /// the return of the running episode so far
+   [[nodiscard]] double episode_return() const { return m_episode_return; }
+   /// the number of steps of the running episode so far
+   [[nodiscard]] size_t episode_length() const { return m_episode_length; }
+   /// the number of finished episodes
+   [[nodiscard]] size_t episode_count() const { return m_episode_count; }
+   /// the statistics of the last finished episodes, the most recent one last
+   [[nodiscard]] auto& history() const { return m_history; }
+
+   void truncate()
+   {
+      if constexpr(requires(Env& env) { env.truncate(); }) {
+         this->m_env.truncate();
+      }
+      if(m_episode_length > 0) {
+         _finish_episode();
+      }
+   }
+
+  private:
+   size_t m_buffer_length;
+   double m_episode_return = 0.;
+   size_t m_episode_length = 0;
+   size_t m_episode_count = 0;
+   std::deque< EpisodeStatistics > m_history;
+
+   template < typename StepResult >
+   void _on_step(StepResult& result)
+   {
+      m_episode_return += static_cast< double >(std::get< 1 >(result));
+      ++m_episode_length;
+      if(not(std::get< 2 >(result) or std::get< 3 >(result))) {
+         return;
+      }
+      const EpisodeStatistics statistics = _finish_episode();
+      if constexpr(std::tuple_size_v< StepResult > >= 5) {
+         if constexpr(std::same_as<
+                         std::tuple_element_t< 4, StepResult >,
+                         std::unordered_map< std::string, std::any > >) {
+            std::get< 4 >(result).insert_or_assign("episode", statistics);
+         }
+      }
+   }
+   void _on_reset()
+   {
+      m_episode_return = 0.;
+      m_episode_length = 0;
+   }
+
+   EpisodeStatistics _finish_episode()
+   {
+      const EpisodeStatistics statistics{m_episode_return, m_episode_length};
+      m_history.push_back(statistics);
+      if(m_history.size() > m_buffer_length) {
+         m_history.pop_front();
+      }
+      ++m_episode_count;
+      _on_reset();
+      return statistics;
+   }
+};
+
+template < typename Env >
+using EpisodeStats = RecordEpisodeStatistics< Env >;
+
+/// Clips the actions into the bounds of the action space before stepping (as gymnasium's
+/// ClipAction). The clipped action is written into a buffer reused by every step.
+template < typename Env >
+   requires detail::bounded_space< detail::action_space_of_t< Env > >
+class ClipAction: public Wrapper< ClipAction< Env >, Env > {
+  public:
+   using base = Wrapper< ClipAction< Env >, Env >;
+   using typename base::action_type;
+   friend base;
+
+   explicit ClipAction(Env env) : base(std::move(env)), m_clipped(this->m_env.action_space().low())
+   {
+   }
+
+  private:
+   action_type m_clipped;
+
+   const action_type& _action(const action_type& action)
+   {
+      const auto& space = this->m_env.action_space();
+      xt::noalias(m_clipped) = xt::clip(action, space.low(), space.high());
+      return m_clipped;
+   }
+};
+
+/// @brief Base of the wrappers of vector envs, the batched counterpart of Wrapper.
+///
+/// The hooks are the same as those of Wrapper, but see the batches of all environments, so the
+/// per-environment state of a vector wrapper is kept in arrays over the environments. The wrapped
+/// vector env is constructed in place from the trailing constructor arguments of the wrapper, since
+/// not all vector envs can be moved.
+template < typename Derived, detail::stepped_vector_env VecEnv >
+class VectorWrapper {
+  public:
+   using env_type = VecEnv;
+   using action_batch_type = typename VecEnv::action_batch_type;
+
+   template < typename... Args >
+      requires std::constructible_from< VecEnv, Args... >
+   explicit VectorWrapper(Args&&... env_args) : m_env(FWD(env_args)...)
+   {
+   }
+
+   auto step(const action_batch_type& actions)
+   {
+      auto result = m_env.step(_self()._actions(actions));
+      _self()._on_step(result);
+      return result;
+   }
+
+   decltype(auto) reset(std::optional< size_t > seed = std::nullopt)
+   {
+      decltype(auto) result = m_env.reset(seed);
+      _self()._on_reset();
+      return result;
+   }
+
+   void truncate(size_t env_id)
+      requires detail::truncatable_vector_env< VecEnv >
+   {
+      m_env.truncate(env_id);
+   }
+
+   void close() { m_env.close(); }
+
+   [[nodiscard]] size_t size() const { return m_env.size(); }
+
+   [[nodiscard]] decltype(auto) observation_space() const { return m_env.observation_space(); }
+   [[nodiscard]] decltype(auto) action_space() const { return m_env.action_space(); }
+   [[nodiscard]] decltype(auto) single_observation_space() const
+   {
+      return m_env.single_observation_space();
+   }
+   [[nodiscard]] decltype(auto) single_action_space() const
+   {
+      return m_env.single_action_space();
+   }
+   [[nodiscard]] decltype(auto) final_observations() const { return m_env.final_observations(); }
+
+   /// the vector env wrapped by this wrapper
+   [[nodiscard]] auto& env() const { return m_env; }
+   [[nodiscard]] auto& env() { return m_env; }
+
+  protected:
+   VecEnv m_env;
+
+   const action_batch_type& _actions(const action_batch_type& actions) { return actions; }
+   template < typename StepResult >
+   void _on_step(StepResult& /*result*/)
+   {
+   }
+   void _on_reset() {}
+
+  private:
+   Derived& _self() { return static_cast< Derived& >(*this); }
+};
+
+/// @brief The batched TimeLimit.
+///
+/// Counts the steps of all environments in one array and truncates those reaching
+/// `max_episode_steps` through the `truncate` of the wrapped vector env, which marks them in its
+/// truncation buffer and resets them.
+template < detail::truncatable_vector_env VecEnv >
+class VectorTimeLimit: public VectorWrapper< VectorTimeLimit< VecEnv >, VecEnv > {
+  public:
+   using base = VectorWrapper< VectorTimeLimit< VecEnv >, VecEnv >;
+   friend base;
+
+   template < typename... Args >
+      requires std::constructible_from< VecEnv, Args... >
+   explicit VectorTimeLimit(size_t max_episode_steps, Args&&... env_args)
+       : base(FWD(env_args)...),
+         m_max_episode_steps(max_episode_steps),
+         m_elapsed_steps(xt::zeros< size_t >({this->m_env.size()}))
+   {
+      if(max_episode_steps == 0) {
+         throw std::invalid_argument("The maximum number of episode steps must be positive.");
+      }
+   }
+
+   [[nodiscard]] size_t max_episode_steps() const { return m_max_episode_steps; }
+   [[nodiscard]] auto& elapsed_steps() const { return m_elapsed_steps; }
+
+  private:
+   size_t m_max_episode_steps;
+   xarray< size_t > m_elapsed_steps;
+
+   template < typename StepResult >
+   void _on_step(StepResult& result)
+   {
+      const auto& terminated = std::get< 2 >(result);
+      const auto& truncated = std::get< 3 >(result);
+      for(size_t i = 0; i < m_elapsed_steps.size(); ++i) {
+         if(terminated(i) or truncated(i)) {
+            // the environment has been reset by the vector env already
+            m_elapsed_steps(i) = 0;
+         } else if(++m_elapsed_steps(i) >= m_max_episode_steps) {
+            this->m_env.truncate(i);
+            m_elapsed_steps(i) = 0;
+         }
+      }
+   }
+   void _on_reset() { m_elapsed_steps.fill(0); }
+};
+
+/// @brief The batched RecordEpisodeStatistics.
+///
+/// The returns and lengths of the running episodes are accumulated in one array each. After a
+/// `step` the statistics of the episodes finished in it are in `final_returns` and `final_lengths`
+/// (only the rows of finished environments are meaningful) and appended to the history. Episodes
+/// ended through `truncate`, e.g. by a VectorTimeLimit wrapped around this wrapper, are recorded
+/// right there. As for RecordEpisodeStatistics, episodes cut short by a `reset` are discarded.
+template < detail::stepped_vector_env VecEnv >
+class VectorRecordEpisodeStatistics
+    : public VectorWrapper< VectorRecordEpisodeStatistics< VecEnv >, VecEnv > {
+  public:
+   using base = VectorWrapper< VectorRecordEpisodeStatistics< VecEnv >, VecEnv >;
+   friend base;
+
+   template < typename... Args >
+      requires std::constructible_from< VecEnv, Args... >
+   explicit VectorRecordEpisodeStatistics(size_t buffer_length, Args&&... env_args)
+       : base(FWD(env_args)...),
+         m_buffer_length(buffer_length),
+         m_episode_returns(xt::zeros< double >({this->m_env.size()})),
+         m_episode_lengths(xt::zeros< size_t >({this->m_env.size()})),
+         m_final_returns(m_episode_returns),
+         m_final_lengths(m_episode_lengths)
+   {
+   }
+
+   [[nodiscard]] auto& episode_returns() const { return m_episode_returns; }
+   [[nodiscard]] auto& episode_lengths() const { return m_episode_lengths; }
+   [[nodiscard]] auto& final_returns() const { return m_final_returns; }
+   [[nodiscard]] auto& final_lengths() const { return m_final_lengths; }
+   [[nodiscard]] size_t episode_count() const { return m_episode_count; }
+   [[nodiscard]] auto& history() const { return m_history; }
+
+   void truncate(size_t env_id)
+      requires detail::truncatable_vector_env< VecEnv >
+   {
+      base::truncate(env_id);
+      // environments finished in the last step have been recorded already
+      if(m_episode_lengths(env_id) > 0) {
+         _finish_episode(env_id);
+      }
+   }
+
+  private:
+   size_t m_buffer_length;
+   xarray< double > m_episode_returns;
+   xarray< size_t > m_episode_lengths;
+   xarray< double > m_final_returns;
+   xarray< size_t > m_final_lengths;
+   size_t m_episode_count = 0;
+   std::deque< EpisodeStatistics > m_history;
+
+   template < typename StepResult >
+   void _on_step(StepResult& result)
+   {
+      const auto& rewards = std::get< 1 >(result);
+      const auto& terminated = std::get< 2 >(result);
+      const auto& truncated = std::get< 3 >(result);
+      m_episode_returns += rewards;
+      m_episode_lengths += size_t{1};
+      for(size_t i = 0; i < m_episode_returns.size(); ++i) {
+         if(terminated(i) or truncated(i)) {
+            _finish_episode(i);
+         }
+      }
+   }
+   void _finish_episode(size_t i)
+   {
+      m_final_returns(i) = m_episode_returns(i);
+      m_final_lengths(i) = m_episode_lengths(i);
+      m_history.push_back({m_episode_returns(i), m_episode_lengths(i)});
+      if(m_history.size() > m_buffer_length) {
+         m_history.pop_front();
+      }
+      ++m_episode_count;
+      m_episode_returns(i) = 0.;
+      m_episode_lengths(i) = 0;
+   }
+   void _on_reset()
+   {
+      m_episode_returns.fill(0.);
+      m_episode_lengths.fill(0);
+   }
+};
+
+/// The batched ClipAction: clips the whole action batch against the bounds of a single action.
+template < detail::stepped_vector_env VecEnv >
+   requires detail::bounded_space< detail::raw_t<
+      decltype(std::declval< const VecEnv& >().single_action_space()) > >
+class VectorClipAction: public VectorWrapper< VectorClipAction< VecEnv >, VecEnv > {
+  public:
+   using base = VectorWrapper< VectorClipAction< VecEnv >, VecEnv >;
+   using typename base::action_batch_type;
+   friend base;
+
+   template < typename... Args >
+      requires std::constructible_from< VecEnv, Args... >
+   explicit VectorClipAction(Args&&... env_args)
+       : base(FWD(env_args)...), m_clipped(this->m_env.action_space().sample())
+   {
+   }
+
+  private:
+   action_batch_type m_clipped;
+
+   const action_batch_type& _actions(const action_batch_type& actions)
+   {
+      const auto& space = this->m_env.single_action_space();
+      // the bounds of a single action broadcast along the leading batch axis
+      xt::noalias(m_clipped) = xt::clip(actions, space.low(), space.high());
+      return m_clipped;
+   }
+};
+
+}  // namespace force
+
+#endif  // REINFORCE_WRAPPERS_HPP
@@ -34,9 +34,15 @@ class TupleSpace;
 template < typename... Spaces >
 class OneOfSpace;
 
+template < typename... Entries >
+class DictSpace;
+
 template < typename FS, bool stacked >
 class SequenceSpace;
 
+template < typename SpaceT >
+class BatchedSpace;
+
 }  // namespace force
 
 #endif  // REINFORCE_FWD_HPP
@@ -1,9 +1,21 @@
 #ifndef REINFORCE_REINFORCE_HPP
 #define REINFORCE_REINFORCE_HPP
 
+#include "reinforce/env/any_env.hpp"
+#include "reinforce/env/any_gridworld.hpp"
+#include "reinforce/env/async_vector_env.hpp"
+#include "reinforce/env/dynamic_gridworld.hpp"
 #include "reinforce/env/gridworld.hpp"
+#include "reinforce/env/process_vector_env.hpp"
+#include "reinforce/env/vector_env.hpp"
+#include "reinforce/env/wrappers.hpp"
+#include "reinforce/spaces/batching.hpp"
 #include "reinforce/spaces/box.hpp"
+#include "reinforce/spaces/dict.hpp"
 #include "reinforce/spaces/discrete.hpp"
+#include "reinforce/spaces/fixed_box.hpp"
+#include "reinforce/spaces/fixed_multi_discrete.hpp"
+#include "reinforce/spaces/flatten.hpp"
 #include "reinforce/spaces/graph.hpp"
 #include "reinforce/spaces/multi_binary.hpp"
 #include "reinforce/spaces/multi_discrete.hpp"
@@ -0,0 +1,436 @@
+#ifndef REINFORCE_SPACES_BATCHING_HPP
+#define REINFORCE_SPACES_BATCHING_HPP
+
+#include <fmt/format.h>
+
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <xtensor/xbroadcast.hpp>
+#include <xtensor/xview.hpp>
+
+#include "reinforce/spaces/box.hpp"
+#include "reinforce/spaces/dict.hpp"
+#include "reinforce/spaces/discrete.hpp"
+#include "reinforce/spaces/fixed_box.hpp"
+#include "reinforce/spaces/fixed_multi_discrete.hpp"
+#include "reinforce/spaces/graph.hpp"
+#include "reinforce/spaces/multi_binary.hpp"
+#include "reinforce/spaces/multi_discrete.hpp"
+#include "reinforce/spaces/sequence.hpp"
+#include "reinforce/spaces/space.hpp"
+#include "reinforce/spaces/tuple.hpp"
+#include "reinforce/utils/type_traits.hpp"
+#include "reinforce/utils/xtensor_typedefs.hpp"
+
+namespace force {
+
+namespace detail {
+
+/// The number of samples in a batch of any space.
+template < typename Batch >
+size_t batch_length(const Batch& batch)
+{
+   if constexpr(xt::is_xexpression< Batch >::value) {
+      return batch.dimension() == 0 ? 0 : batch.shape()[0];
+   } else if constexpr(is_specialization_v< Batch, std::tuple >) {
+      if constexpr(std::tuple_size_v< Batch > == 0) {
+         return 0;
+      } else {
+         return batch_length(std::get< 0 >(batch));
+      }
+   } else if constexpr(requires { batch.as_tuple(); }) {
+      return batch_length(batch.as_tuple());
+   } else {
+      return batch.size();
+   }
+}
+
+/// @brief Sample `index` of a batch of `space` without copying.
+///
+/// Array batches give views of their rows (or references to their entries if the samples are
+/// scalars), string batches give string_views, packed graph batches GraphInstanceViews and ragged
+/// batches views of their sequences. Tuples and dicts give a tuple or dict of the views of their
+/// subspaces. Batches assembling their values on access (TextBatch, OneOfBatch) return them as
+/// their `operator[]` does. The constness of `batch` carries over to the views.
+template < typename SpaceT, typename Batch >
+decltype(auto) batch_at(const SpaceT& space, Batch& batch, size_t index)
+{
+   using batch_type = std::remove_const_t< Batch >;
+   if constexpr(is_specialization_v< SpaceT, TupleSpace >) {
+      return std::invoke(
+         [&]< size_t... Is >(std::index_sequence< Is... >) {
+            return std::tuple< decltype(batch_at(
+               space.template get< Is >(), std::get< Is >(batch), index
+            ))... >{batch_at(space.template get< Is >(), std::get< Is >(batch), index)...};
+         },
+         typename SpaceT::spaces_idx_seq{}
+      );
+   } else if constexpr(is_specialization_v< SpaceT, DictSpace >) {
+      return std::invoke(
+         [&]< size_t... Is >(std::index_sequence< Is... >) {
+            return Dict<
+               typename SpaceT::keys,
+               decltype(batch_at(
+                  space.template get< Is >(), batch.template get< Is >(), index
+               ))... >{batch_at(space.template get< Is >(), batch.template get< Is >(), index)...};
+         },
+         typename SpaceT::spaces_idx_seq{}
+      );
+   } else if constexpr(xt::is_xexpression< batch_type >::value) {
+      if constexpr(xt::is_xexpression< value_t< SpaceT > >::value) {
+         return xt::view(batch, index);
+      } else {
+         // the batch array merely holds the scalar values like a std::vector would
+         return batch.flat(index);
+      }
+   } else if constexpr(std::same_as< batch_type, std::vector< std::string > >) {
+      return std::string_view{batch[index]};
+   } else if constexpr(is_specialization_v< batch_type, PackedGraphBatch >) {
+      return batch.view(index);
+   } else if constexpr(is_specialization_v< batch_type, RaggedArray >) {
+      return batch.row(index);
+   } else {
+      return batch[index];
+   }
+}
+
+/// Write `value` as sample `index` of a batch of `space`, the counterpart of `batch_at`.
+///
+/// Tuple values may be any tuple-like type (e.g. std::pair). Array rows are assigned in place, so
+/// the batch needs to have its full shape already.
+template < typename SpaceT, typename Batch, typename Value >
+void batch_assign(const SpaceT& space, Batch& batch, size_t index, const Value& value)
+{
+   if constexpr(is_specialization_v< SpaceT, TupleSpace >) {
+      std::invoke(
+         [&]< size_t... Is >(std::index_sequence< Is... >) {
+            (batch_assign(
+                space.template get< Is >(), std::get< Is >(batch), index, std::get< Is >(value)
+             ),
+             ...);
+         },
+         typename SpaceT::spaces_idx_seq{}
+      );
+   } else if constexpr(is_specialization_v< SpaceT, DictSpace >) {
+      std::invoke(
+         [&]< size_t... Is >(std::index_sequence< Is... >) {
+            (batch_assign(
+                space.template get< Is >(),
+                batch.template get< Is >(),
+                index,
+                value.template get< Is >()
+             ),
+             ...);
+         },
+         typename SpaceT::spaces_idx_seq{}
+      );
+   } else if constexpr(xt::is_xexpression< Batch >::value) {
+      if constexpr(xt::is_xexpression< Value >::value) {
+         xt::view(batch, index) = value;
+      } else {
+         batch.flat(index) = static_cast< typename Batch::value_type >(value);
+      }
+   } else {
+      batch[index] = value;
+   }
+}
+
+/// @brief A batch of the structure and shapes of `batch` with allocated but unwritten arrays.
+///
+/// Pages of large arrays are then placed on the NUMA node of whoever writes them first, e.g. the
+/// worker owning the rows. Arrays of fixed size and batches of other kinds are copied.
+template < typename Batch >
+Batch uninitialized_like(const Batch& batch)
+{
+   if constexpr(xt::is_xexpression< Batch >::value) {
+      if constexpr(requires { Batch::from_shape(batch.shape()); }) {
+         return Batch::from_shape(batch.shape());
+      } else {
+         return batch;
+      }
+   } else if constexpr(is_specialization_v< Batch, std::tuple >) {
+      return std::apply(
+         [](const auto&... elements) { return Batch{uninitialized_like(elements)...}; }, batch
+      );
+   } else if constexpr(requires { batch.as_tuple(); }) {
+      return Batch{uninitialized_like(batch.as_tuple())};
+   } else {
+      return batch;
+   }
+}
+
+/// Copy `array` `n` times along a new leading axis.
+template < typename T, typename Array >
+xarray< T > tile(const Array& array, size_t n)
+{
+   xt::svector< size_t > shape{n};
+   shape.insert(shape.end(), array.shape().begin(), array.shape().end());
+   return xt::broadcast(array, shape);
+}
+
+}  // namespace detail
+
+/// @brief A space of batches of n samples of another space.
+///
+/// The fallback of `batch_space` for spaces without a batched counterpart among the other spaces
+/// (e.g. Text, Graph, Sequence and OneOf). Its samples are the batches of the wrapped space, i.e.
+/// `sample()` is `space.sample(n)`.
+template < typename SpaceT >
+class BatchedSpace:
+    public Space<
+       detail::batch_value_t< SpaceT >,
+       BatchedSpace< SpaceT >,
+       std::vector< detail::batch_value_t< SpaceT > > > {
+  public:
+   friend class Space<
+      detail::batch_value_t< SpaceT >,
+      BatchedSpace,
+      std::vector< detail::batch_value_t< SpaceT > > >;
+   using base = Space<
+      detail::batch_value_t< SpaceT >,
+      BatchedSpace,
+      std::vector< detail::batch_value_t< SpaceT > > >;
+   using space_type = SpaceT;
+   using typename base::value_type;
+   using typename base::batch_value_type;
+   using base::shape;
+   using base::rng;
+
+   BatchedSpace(SpaceT space, size_t n, std::optional< size_t > seed_ = std::nullopt)
+       : base(_batched_shape(space.shape(), n)), m_space(std::move(space)), m_n(n)
+   {
+      seed(seed_);
+   }
+
+   template < typename T >
+   void seed(T value)
+   {
+      base::seed(value);
+      m_space.seed(std::optional{static_cast< size_t >(rng()())});
+   }
+   auto seed() const { return base::seed(); }
+
+   void enable_thread_streams(size_t n_threads)
+   {
+      base::enable_thread_streams(n_threads);
+      m_space.enable_thread_streams(n_threads);
+   }
+
+   void disable_thread_streams()
+   {
+      base::disable_thread_streams();
+      m_space.disable_thread_streams();
+   }
+
+   bool operator==(const BatchedSpace& rhs) const
+   {
+      return m_n == rhs.m_n and m_space == rhs.m_space;
+   }
+
+   [[nodiscard]] std::string repr() const
+   {
+      return fmt::format("Batched({}, n={})", m_space.repr(), m_n);
+   }
+
+   [[nodiscard]] const SpaceT& space() const { return m_space; }
+   [[nodiscard]] size_t n() const { return m_n; }
+
+  private:
+   SpaceT m_space;
+   size_t m_n;
+
+   static xt::svector< int > _batched_shape(const xt::svector< int >& shape_, size_t n)
+   {
+      xt::svector< int > batched{static_cast< int >(n)};
+      batched.insert(batched.end(), shape_.begin(), shape_.end());
+      return batched;
+   }
+
+   [[nodiscard]] value_type _sample(std::nullopt_t /**/ = std::nullopt) const
+   {
+      return m_space.sample(m_n);
+   }
+
+   [[nodiscard]] batch_value_type _sample(size_t batch_size) const
+   {
+      batch_value_type samples;
+      samples.reserve(batch_size);
+      for(size_t i = 0; i < batch_size; ++i) {
+         samples.emplace_back(m_space.sample(m_n));
+      }
+      return samples;
+   }
+
+   [[nodiscard]] bool _contains(const value_type& value) const
+   {
+      return detail::batch_length(value) == m_n and m_space.contains_all(value);
+   }
+};
+
+/// @brief The batched counterpart of a space (as gymnasium's `batch_space`).
+///
+/// `batching< Space >::batch_space(space, n)` returns a space whose samples are batches of n
+/// samples of `space` in the layout of `space.sample(n)`:
+///   - Box, FixedBox: a Box with the bounds repeated along a leading axis of size n,
+///   - Discrete: a MultiDiscrete of shape (n),
+///   - MultiDiscrete, FixedMultiDiscrete: a MultiDiscrete with a leading axis of size n,
+///   - MultiBinary: a MultiBinary with a leading axis of size n,
+///   - Tuple, Dict: a Tuple or Dict of the batched subspaces,
+///   - all other spaces: a BatchedSpace.
+/// The batched space is seeded with the seed of `space`.
+template < typename SpaceT >
+struct batching {
+   using type = BatchedSpace< SpaceT >;
+
+   static type batch_space(const SpaceT& space, size_t n) { return type{space, n, space.seed()}; }
+};
+
+template < typename SpaceT >
+using batched_space_t = typename batching< SpaceT >::type;
+
+template < typename T >
+struct batching< BoxSpace< T > > {
+   using type = BoxSpace< T >;
+
+   static type batch_space(const BoxSpace< T >& space, size_t n)
+   {
+      return type{
+         detail::tile< T >(space.low(), n), detail::tile< T >(space.high(), n), space.seed()
+      };
+   }
+};
+
+template < typename T, size_t... Shape >
+struct batching< FixedBoxSpace< T, Shape... > > {
+   using type = BoxSpace< T >;
+
+   static type batch_space(const FixedBoxSpace< T, Shape... >& space, size_t n)
+   {
+      return type{
+         detail::tile< T >(space.low(), n), detail::tile< T >(space.high(), n), space.seed()
+      };
+   }
+};
+
+template < typename T >
+struct batching< DiscreteSpace< T > > {
+   using type = MultiDiscreteSpace< T >;
+
+   static type batch_space(const DiscreteSpace< T >& space, size_t n)
+   {
+      xarray< T > start = xarray< T >::from_shape({n});
+      xarray< T > end = xarray< T >::from_shape({n});
+      start.fill(space.start());
+      end.fill(static_cast< T >(space.start() + space.n()));
+      return type{std::move(start), std::move(end), space.seed()};
+   }
+};
+
+template < typename T >
+struct batching< MultiDiscreteSpace< T > > {
+   using type = MultiDiscreteSpace< T >;
+
+   static type batch_space(const MultiDiscreteSpace< T >& space, size_t n)
+   {
+      return type{
+         detail::tile< T >(space.start(), n), detail::tile< T >(space.end(), n), space.seed()
+      };
+   }
+};
+
+template < typename T, size_t... Shape >
+struct batching< FixedMultiDiscreteSpace< T, Shape... > > {
+   using type = MultiDiscreteSpace< T >;
+
+   static type batch_space(const FixedMultiDiscreteSpace< T, Shape... >& space, size_t n)
+   {
+      return type{
+         detail::tile< T >(space.start(), n), detail::tile< T >(space.end(), n), space.seed()
+      };
+   }
+};
+
+template <>
+struct batching< MultiBinarySpace > {
+   using type = MultiBinarySpace;
+
+   static type batch_space(const MultiBinarySpace& space, size_t n)
+   {
+      xt::svector< int > shape{static_cast< int >(n)};
+      shape.insert(shape.end(), space.shape().begin(), space.shape().end());
+      return type(shape, space.seed());
+   }
+};
+
+template < typename... Spaces >
+struct batching< TupleSpace< Spaces... > > {
+   using type = TupleSpace< batched_space_t< Spaces >... >;
+
+   static type batch_space(const TupleSpace< Spaces... >& space, size_t n)
+   {
+      return std::invoke(
+         [&]< size_t... Is >(std::index_sequence< Is... >) {
+            return type{
+               space.seed(), batching< Spaces >::batch_space(space.template get< Is >(), n)...
+            };
+         },
+         std::index_sequence_for< Spaces... >{}
+      );
+   }
+};
+
+template < typename... Entries >
+struct batching< DictSpace< Entries... > > {
+   using type = DictSpace<
+      DictEntry< Entries::key, batched_space_t< typename Entries::space_type > >... >;
+
+   static type batch_space(const DictSpace< Entries... >& space, size_t n)
+   {
+      return std::invoke(
+         [&]< size_t... Is >(std::index_sequence< Is... >) {
+            return type{
+               space.seed(),
+               DictEntry< Entries::key, batched_space_t< typename Entries::space_type > >{
+                  batching< typename Entries::space_type >::batch_space(
+                     space.template get< Is >(), n
+                  )
+               }...
+            };
+         },
+         std::index_sequence_for< Entries... >{}
+      );
+   }
+};
+
+/// The space of batches of `n` samples of `space`, see `batching`.
+template < typename SpaceT >
+batched_space_t< SpaceT > batch_space(const SpaceT& space, size_t n)
+{
+   return batching< SpaceT >::batch_space(space, n);
+}
+
+/// @brief The samples of a batch as a range of views into it (as gymnasium's `iterate`).
+///
+/// Nothing is copied, see `detail::batch_at` for the element types. The views of a mutable batch
+/// can be written to, e.g. to place the observation of every sub-environment into a shared batch.
+/// `space` and `batch` have to outlive the range.
+template < typename SpaceT, typename Batch >
+auto iterate(const SpaceT& space, Batch& batch)
+{
+   return std::views::iota(size_t{0}, detail::batch_length(batch))
+          | std::views::transform([&space, &batch](size_t index) -> decltype(auto) {
+               return detail::batch_at(space, batch, index);
+            });
+}
+
+}  // namespace force
+
+#endif  // REINFORCE_SPACES_BATCHING_HPP
@@ -114,6 +114,9 @@ class BoxSpace: public Space< xarray< T >, BoxSpace< T > > {
    // Checks whether this space can be flattened to a Box
    [[nodiscard]] bool is_flattenable() const { return true; }
 
+   const auto& low() const { return m_low; }
+   const auto& high() const { return m_high; }
+
    std::string repr() { return fmt::format("Box({}, {}, {})", m_low, m_high, shape()); }
 
   private:
@@ -131,10 +134,31 @@ class BoxSpace: public Space< xarray< T >, BoxSpace< T > > {
       const std::optional< xarray< bool > >& /*unused*/ = std::nullopt
    ) const;
 
+   void _sample_into(
+      value_type& out,
+      const std::optional< xarray< bool > >& /*unused*/ = std::nullopt
+   ) const;
+
+   void _sample_into(
+      size_t batch_size,
+      value_type& out,
+      const std::optional< xarray< bool > >& /*unused*/ = std::nullopt
+   ) const;
+
    [[nodiscard]] bool _contains(const value_type& value) const
    {
       return base::_isin_shape_and_bounds(value, m_low, m_high);
    }
+
+   [[nodiscard]] xarray< bool > _contains_batch(const value_type& batch) const
+   {
+      return base::_rows_in_shape_and_bounds(batch, m_low, m_high);
+   }
+
+   [[nodiscard]] bool _contains_all(const value_type& batch) const
+   {
+      return batch.dimension() == shape().size() + 1 and _contains(batch);
+   }
 };
 
 /// Deduction guides
@@ -221,9 +245,19 @@ BoxSpace< T >::BoxSpace(
 template < typename T >
 
    requires box_reqs< T >
-auto BoxSpace< T >::_sample(const std::optional< xarray< bool > >&) const -> value_type
+auto BoxSpace< T >::_sample(const std::optional< xarray< bool > >& mask) const -> value_type
+{
+   value_type samples;
+   _sample_into(samples, mask);
+   return samples;
+}
+
+template < typename T >
+   requires box_reqs< T >
+void BoxSpace< T >::_sample_into(value_type& samples, const std::optional< xarray< bool > >&) const
 {
-   xarray< T > samples = xt::empty< T >(shape());
+   // resizing keeps the buffer whenever the number of elements does not change
+   samples.resize(shape());
    SPDLOG_DEBUG(fmt::format("Samples shape: {}", samples.shape()));
    for(auto&& [i, bounds] :
        ranges::views::enumerate(ranges::views::zip(m_bounded_below, m_bounded_above))) {
@@ -266,20 +300,31 @@ auto BoxSpace< T >::_sample(const std::optional< xarray< bool > >&) const -> val
          }
       }
    }
+}
+
+template < typename T >
+   requires box_reqs< T >
+auto BoxSpace< T >::_sample(size_t batch_size, const std::optional< xarray< bool > >& mask) const
+   -> value_type
+{
+   value_type samples;
+   _sample_into(batch_size, samples, mask);
    return samples;
 }
 
 template < typename T >
    requires box_reqs< T >
-auto BoxSpace< T >::_sample(
+void BoxSpace< T >::_sample_into(
    size_t batch_size,
+   value_type& samples,
    const std::optional< xarray< bool > >& /*unused*/
-) const -> value_type
+) const
 {
    if(batch_size == 0) {
-      return xt::empty< T >({0});
+      samples = xt::empty< T >({0});
+      return;
    }
-   xarray< T > samples = xt::empty< T >(prepend(shape(), static_cast< int >(batch_size)));
+   samples.resize(prepend(shape(), static_cast< int >(batch_size)));
    SPDLOG_DEBUG(fmt::format("Samples shape: {}", samples.shape()));
 
    for(auto&& [i, bounds] :
@@ -331,7 +376,6 @@ auto BoxSpace< T >::_sample(
          }
       }
    }
-   return samples;
 }
 
 template < typename T >
@@ -0,0 +1,348 @@
+#ifndef REINFORCE_SPACE_DICT_HPP
+#define REINFORCE_SPACE_DICT_HPP
+
+#include <fmt/format.h>
+#include <fmt/ranges.h>
+
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "reinforce/spaces/space.hpp"
+#include "reinforce/spaces/tuple.hpp"
+#include "reinforce/utils/fixed_string.hpp"
+#include "reinforce/utils/macro.hpp"
+#include "reinforce/utils/type_traits.hpp"
+
+namespace force {
+
+/// @brief A subspace of a DictSpace together with its key.
+template < fixed_string Key, typename SpaceT >
+struct DictEntry {
+   static constexpr auto key = Key;
+   using space_type = SpaceT;
+
+   SpaceT space;
+};
+
+/// Attach a key to a space for the construction of a DictSpace, e.g. `entry< "goal" >(space)`.
+template < fixed_string Key, typename SpaceT >
+DictEntry< Key, detail::raw_t< SpaceT > > entry(SpaceT&& space)
+{
+   return {FWD(space)};
+}
+
+/// @brief A tuple whose elements are also addressable by their compile-time keys.
+///
+/// The values and batches of DictSpace. Batches are stored as a struct of arrays, i.e. as one
+/// batch per key. `get< "key" >()` resolves the key to the index at compile time, so access is
+/// exactly as cheap as `std::get`.
+template < typename Keys, typename... Values >
+class Dict: public std::tuple< Values... > {
+  public:
+   using keys = Keys;
+   using tuple_type = std::tuple< Values... >;
+   using tuple_type::tuple_type;
+
+   static_assert(keys::size == sizeof...(Values), "Every value needs exactly one key.");
+
+   Dict() = default;
+   explicit Dict(tuple_type values) : tuple_type(std::move(values)) {}
+
+   template < fixed_string Key >
+   auto& get() &
+   {
+      return std::get< keys::template index_of< Key > >(as_tuple());
+   }
+   template < fixed_string Key >
+   auto& get() const&
+   {
+      return std::get< keys::template index_of< Key > >(as_tuple());
+   }
+   template < fixed_string Key >
+   auto&& get() &&
+   {
+      return std::get< keys::template index_of< Key > >(std::move(as_tuple()));
+   }
+
+   template < size_t I >
+   auto& get() &
+   {
+      return std::get< I >(as_tuple());
+   }
+   template < size_t I >
+   auto& get() const&
+   {
+      return std::get< I >(as_tuple());
+   }
+   template < size_t I >
+   auto&& get() &&
+   {
+      return std::get< I >(std::move(as_tuple()));
+   }
+
+   tuple_type& as_tuple() & { return *this; }
+   const tuple_type& as_tuple() const& { return *this; }
+
+   static constexpr const auto& names() { return keys::names; }
+};
+
+template < fixed_string Key, typename Keys, typename... Values >
+decltype(auto) get(Dict< Keys, Values... >& dict)
+{
+   return dict.template get< Key >();
+}
+template < fixed_string Key, typename Keys, typename... Values >
+decltype(auto) get(const Dict< Keys, Values... >& dict)
+{
+   return dict.template get< Key >();
+}
+template < fixed_string Key, typename Keys, typename... Values >
+decltype(auto) get(Dict< Keys, Values... >&& dict)
+{
+   return std::move(dict).template get< Key >();
+}
+
+namespace detail {
+
+template < typename T >
+inline constexpr bool is_dict_entry_v = false;
+
+template < fixed_string Key, typename SpaceT >
+inline constexpr bool is_dict_entry_v< DictEntry< Key, SpaceT > > = true;
+
+template < typename... Entries >
+using dict_keys_t = key_list< Entries::key... >;
+
+}  // namespace detail
+
+/// @brief The gymnasium Dict space with keys fixed at compile time.
+///
+/// The subspaces are held in declaration order by a TupleSpace, which does all the sampling,
+/// seeding and membership checks. Values and batches are `Dict`s, i.e. tuples of the subspaces'
+/// values and batches which can also be indexed by key. Keys only known at runtime are translated
+/// to indices with `index_of`.
+template < typename... Entries >
+class DictSpace:
+    public Space<
+       Dict< detail::dict_keys_t< Entries... >, typename Entries::space_type::value_type... >,
+       DictSpace< Entries... >,
+       Dict<
+          detail::dict_keys_t< Entries... >,
+          typename Entries::space_type::batch_value_type... > > {
+  public:
+   friend class Space<
+      Dict< detail::dict_keys_t< Entries... >, typename Entries::space_type::value_type... >,
+      DictSpace,
+      Dict<
+         detail::dict_keys_t< Entries... >,
+         typename Entries::space_type::batch_value_type... > >;
+   using base = Space<
+      Dict< detail::dict_keys_t< Entries... >, typename Entries::space_type::value_type... >,
+      DictSpace,
+      Dict<
+         detail::dict_keys_t< Entries... >,
+         typename Entries::space_type::batch_value_type... > >;
+   using keys = detail::dict_keys_t< Entries... >;
+   using tuple_space_type = TupleSpace< typename Entries::space_type... >;
+   using spaces_tuple_type = typename tuple_space_type::spaces_tuple_type;
+   using data_type = typename tuple_space_type::data_type;
+   using typename base::value_type;
+   using typename base::batch_value_type;
+   using base::shape;
+   using base::rng;
+
+   using spaces_idx_seq = std::index_sequence_for< Entries... >;
+
+   static constexpr bool _is_composite_space = true;
+
+   static_assert(
+      (detail::is_dict_entry_v< Entries > and ...),
+      "DictSpace is built from DictEntry< key, space > types, see `entry`."
+   );
+
+  private:
+   tuple_space_type m_spaces;
+
+  public:
+   template < std::integral T = size_t >
+   explicit DictSpace(T seed_, Entries... entries) : m_spaces{std::move(entries.space)...}
+   {
+      seed(seed_);
+   }
+
+   template < typename OptionalT = std::optional< size_t > >
+      requires detail::is_specialization_v< OptionalT, std::optional >
+               and std::convertible_to< detail::value_t< OptionalT >, size_t >
+   explicit DictSpace(OptionalT seed_, Entries... entries) : m_spaces{std::move(entries.space)...}
+   {
+      seed(seed_);
+   }
+
+   explicit DictSpace(Entries... entries) : m_spaces{std::move(entries.space)...}
+   {
+      seed(std::optional< size_t >{});
+   }
+
+   template < typename T >
+   void seed(T value)
+   {
+      base::seed(value);
+      m_spaces.seed(std::optional{static_cast< size_t >(rng()())});
+   }
+   auto seed() const { return base::seed(); }
+
+   void enable_thread_streams(size_t n_threads)
+   {
+      base::enable_thread_streams(n_threads);
+      m_spaces.enable_thread_streams(n_threads);
+   }
+
+   void disable_thread_streams()
+   {
+      base::disable_thread_streams();
+      m_spaces.disable_thread_streams();
+   }
+
+   bool operator==(const DictSpace& other) const { return m_spaces == other.m_spaces; }
+
+   [[nodiscard]] std::string repr() const
+   {
+      return fmt::format(
+         "Dict({})",
+         fmt::join(
+            std::invoke(
+               [&]< size_t... Is >(std::index_sequence< Is... >) {
+                  return std::array< std::string, sizeof...(Is) >{
+                     fmt::format("{}: {}", keys::names[Is], m_spaces.template get< Is >())...
+                  };
+               },
+               spaces_idx_seq{}
+            ),
+            ", "
+         )
+      );
+   }
+
+   template < fixed_string Key >
+   auto& get() const
+   {
+      return m_spaces.template get< keys::template index_of< Key > >();
+   }
+   template < fixed_string Key >
+   auto& get()
+   {
+      return m_spaces.template get< keys::template index_of< Key > >();
+   }
+   template < size_t I >
+   auto& get() const
+   {
+      return m_spaces.template get< I >();
+   }
+   template < size_t I >
+   auto& get()
+   {
+      return m_spaces.template get< I >();
+   }
+
+   /// the subspaces in declaration order
+   [[nodiscard]] const tuple_space_type& spaces() const { return m_spaces; }
+
+   /// the index of a key given at runtime or nullopt if there is no such key
+   static constexpr std::optional< size_t > index_of(std::string_view key)
+   {
+      return keys::find(key);
+   }
+
+   static constexpr const auto& names() { return keys::names; }
+
+   [[nodiscard]] constexpr size_t size() const { return sizeof...(Entries); }
+
+  private:
+   template < typename MaskTuple >
+      requires detail::is_specialization_v< detail::raw_t< MaskTuple >, std::tuple >
+               and (std::tuple_size_v< detail::raw_t< MaskTuple > > == sizeof...(Entries))
+   [[nodiscard]] batch_value_type _sample(size_t batch_size, MaskTuple&& mask_tuple) const
+   {
+      return batch_value_type{m_spaces.sample(batch_size, FWD(mask_tuple))};
+   }
+
+   [[nodiscard]] batch_value_type _sample(size_t batch_size) const
+   {
+      return batch_value_type{m_spaces.sample(batch_size)};
+   }
+
+   template < typename MaskTuple >
+      requires detail::is_specialization_v< detail::raw_t< MaskTuple >, std::tuple >
+               and (std::tuple_size_v< detail::raw_t< MaskTuple > > == sizeof...(Entries))
+   [[nodiscard]] value_type _sample(MaskTuple&& mask_tuple) const
+   {
+      return value_type{m_spaces.sample(FWD(mask_tuple))};
+   }
+
+   [[nodiscard]] value_type _sample(std::nullopt_t = std::nullopt) const
+   {
+      return value_type{m_spaces.sample()};
+   }
+
+   /// the subspaces fill their entries of the output dict in place
+   template < typename... Args >
+   void _sample_into(value_type& out, Args&&... args) const
+   {
+      m_spaces.sample_into(out.as_tuple(), FWD(args)...);
+   }
+
+   template < typename... Args >
+   void _sample_into(size_t batch_size, batch_value_type& out, Args&&... args) const
+   {
+      m_spaces.sample_into(batch_size, out.as_tuple(), FWD(args)...);
+   }
+
+   [[nodiscard]] bool _contains(const value_type& value) const
+   {
+      return m_spaces.contains(value.as_tuple());
+   }
+
+   [[nodiscard]] xarray< bool > _contains_batch(const batch_value_type& batch) const
+   {
+      return m_spaces.contains_batch(batch.as_tuple());
+   }
+
+   [[nodiscard]] bool _contains_all(const batch_value_type& batch) const
+   {
+      return m_spaces.contains_all(batch.as_tuple());
+   }
+};
+
+}  // namespace force
+
+namespace std {
+
+template < typename Keys, typename... Values >
+struct tuple_size< ::force::Dict< Keys, Values... > >:
+    integral_constant< size_t, sizeof...(Values) > {};
+
+template < size_t idx, typename Keys, typename... Values >
+struct tuple_element< idx, ::force::Dict< Keys, Values... > > {
+   using type = std::tuple_element_t< idx, std::tuple< Values... > >;
+};
+
+template < typename... Entries >
+struct tuple_size< ::force::DictSpace< Entries... > >:
+    integral_constant< size_t, sizeof...(Entries) > {};
+
+template < size_t idx, typename... Entries >
+struct tuple_element< idx, ::force::DictSpace< Entries... > > {
+   using type = std::
+      tuple_element_t< idx, typename ::force::DictSpace< Entries... >::spaces_tuple_type >;
+};
+
+}  // namespace std
+
+#endif  // REINFORCE_SPACE_DICT_HPP
@@ -4,11 +4,15 @@
 
 #include <fmt/format.h>
 
+#include <array>
 #include <concepts>
 #include <cstddef>
+#include <functional>
+#include <memory>
 #include <optional>
 #include <random>
 #include <ranges>
+#include <span>
 #include <stdexcept>
 #include <string>
 #include <vector>
@@ -18,6 +22,9 @@
 
 #include "reinforce/spaces/concepts.hpp"
 #include "reinforce/spaces/space.hpp"
+#include "reinforce/utils/alias_table.hpp"
+#include "reinforce/utils/bitmask.hpp"
+#include "reinforce/utils/random.hpp"
 #include "reinforce/utils/xtensor_typedefs.hpp"
 
 namespace force {
@@ -64,45 +71,162 @@ class DiscreteSpace: public Space< T, DiscreteSpace< T >, xarray< T > > {
    T m_nr_values;
    T m_start;
 
-   /// for tag dispatch within this class
-   struct internal_tag_t {};
-   static constexpr internal_tag_t internal_tag{};
-
    [[nodiscard]] value_type _sample(std::nullopt_t /*unused*/ = std::nullopt) const
    {
-      return xt::random::randint< T >({1}, m_start, m_start + m_nr_values, rng()).unchecked(0);
+      value_type out;
+      _sample_into(out);
+      return out;
+   }
+
+   void _sample_into(value_type& out, std::nullopt_t /*unused*/ = std::nullopt) const
+   {
+      out = m_start + static_cast< T >(detail::uniform_below(rng(), _nr_values()));
+   }
+
+   [[nodiscard]] value_type _sample(const BitMask& mask) const
+   {
+      value_type out;
+      _sample_into(out, mask);
+      return out;
+   }
+
+   /// If the mask excludes every value, `start` is returned (as gymnasium does).
+   void _sample_into(value_type& out, const BitMask& mask) const
+   {
+      _check_mask_size(mask.size());
+      const size_t n_valid = mask.count();
+      if(n_valid == 0) {
+         out = m_start;
+         return;
+      }
+      out = m_start + static_cast< T >(mask.select(detail::uniform_below(rng(), n_valid)));
+   }
+
+   template < std::integral U >
+   [[nodiscard]] value_type _sample(const xarray< U >& mask) const
+   {
+      return _sample(_to_bitmask(mask));
+   }
+
+   /// Probability masks draw `start + i` with probability proportional to `probabilities[i]`.
+   template < std::floating_point U >
+   [[nodiscard]] value_type _sample(const xarray< U >& probabilities) const
+   {
+      return _sample(*_alias_table(probabilities));
+   }
+
+   [[nodiscard]] value_type _sample(const AliasTable& table) const
+   {
+      value_type out;
+      _sample_into(out, table);
+      return out;
    }
 
-   [[nodiscard]] value_type _sample(const xarray< bool >& mask) const
+   void _sample_into(value_type& out, const AliasTable& table) const
    {
-      return xt::random::choice(
-                xt::eval(xt::filter(xt::arange(m_start, m_start + m_nr_values), mask)),
-                1,
-                true,
-                rng()
-      )
-         .unchecked(0);
+      _check_mask_size(table.size());
+      out = m_start + static_cast< T >(table.sample(rng()));
    }
 
    [[nodiscard]] batch_value_type _sample(size_t batch_size) const;
 
    [[nodiscard]] batch_value_type _sample(size_t batch_size, std::nullopt_t) const;
 
+   void _sample_into(size_t batch_size, batch_value_type& out, std::nullopt_t = std::nullopt) const;
+
+   [[nodiscard]] batch_value_type _sample(size_t batch_size, const BitMask& mask) const;
+
+   void _sample_into(size_t batch_size, batch_value_type& out, const BitMask& mask) const;
+
+   [[nodiscard]] batch_value_type _sample(size_t batch_size, const AliasTable& table) const
+   {
+      batch_value_type samples;
+      _sample_into(batch_size, samples, table);
+      return samples;
+   }
+
+   void _sample_into(size_t batch_size, batch_value_type& out, const AliasTable& table) const
+   {
+      _check_mask_size(table.size());
+      table.sample_fill(rng(), _batch_storage(out, batch_size), m_start);
+   }
+
+   template < std::ranges::range MaskRange >
+   [[nodiscard]] batch_value_type _sample(size_t batch_size, MaskRange&& mask) const
+   {
+      batch_value_type samples;
+      _sample_into(batch_size, samples, mask);
+      return samples;
+   }
+
+   /// Boolean masks restrict the draw to the allowed values, floating point masks are treated as
+   /// (unnormalized) probabilities.
+   template < std::ranges::range MaskRange >
+   void _sample_into(size_t batch_size, batch_value_type& out, MaskRange&& mask) const
+   {
+      if constexpr(std::floating_point< std::ranges::range_value_t< MaskRange > >) {
+         _sample_into(batch_size, out, *_alias_table(mask));
+      } else {
+         _sample_into(batch_size, out, _to_bitmask(mask));
+      }
+   }
+
    template < std::ranges::range MaskRange >
-   [[nodiscard]] batch_value_type _sample(size_t batch_size, MaskRange&& mask) const;
+   [[nodiscard]] BitMask _to_bitmask(const MaskRange& mask) const;
 
-   [[nodiscard]] batch_value_type
-   _sample(internal_tag_t, size_t batch_size, const xarray< bool >& mask) const;
+   /// The alias table of a probability mask. Tables of contiguous masks are cached per thread, so
+   /// repeatedly sampling with the same distribution builds its table only once.
+   template < std::ranges::range ProbabilityRange >
+   [[nodiscard]] std::shared_ptr< const AliasTable > _alias_table(
+      const ProbabilityRange& probabilities
+   ) const;
+
+   void _check_mask_size(size_t mask_size) const
+   {
+      if(mask_size != _nr_values()) {
+         throw std::invalid_argument(fmt::format(
+            "Mask size ({}) does not match the number of elements ({})", mask_size, m_nr_values
+         ));
+      }
+   }
+
+   [[nodiscard]] size_t _nr_values() const { return static_cast< size_t >(m_nr_values); }
+
+   /// the (resized) contiguous storage of a batch of `batch_size` samples
+   [[nodiscard]] static std::span< T > _batch_storage(batch_value_type& out, size_t batch_size)
+   {
+      out.resize(typename batch_value_type::shape_type{batch_size});
+      return {out.data(), batch_size};
+   }
 
    [[nodiscard]] bool _contains(const value_type& value) const
    {
       return m_start <= value && value < m_start + m_nr_values;
    }
+   /// every entry of a batch of any shape is a sample of its own
    [[nodiscard]] bool _contains(const batch_value_type& value) const
    {
-      return xt::all(
-         xt::greater_equal(value, m_start) and xt::less_equal(value, m_start + m_nr_values)
+      return detail::all_in_bounds< true, false, T >(
+         std::span{value.data(), value.size()}, _lower_bound(), _upper_bound()
+      );
+   }
+
+   [[nodiscard]] xarray< bool > _contains_batch(const batch_value_type& batch) const
+   {
+      xarray< bool > valid = xarray< bool >::from_shape(batch.shape());
+      detail::rows_in_bounds< true, false, T >(
+         std::span{batch.data(), batch.size()},
+         _lower_bound(),
+         _upper_bound(),
+         std::span{valid.data(), valid.size()}
       );
+      return valid;
+   }
+
+   [[nodiscard]] std::array< T, 1 > _lower_bound() const { return {m_start}; }
+   [[nodiscard]] std::array< T, 1 > _upper_bound() const
+   {
+      return {static_cast< T >(m_start + m_nr_values)};
    }
 };
 
@@ -110,7 +234,9 @@ template < typename T >
    requires discrete_reqs< T >
 auto DiscreteSpace< T >::_sample(size_t batch_size) const -> batch_value_type
 {
-   return xt::random::randint< T >({batch_size}, m_start, m_start + m_nr_values, rng());
+   batch_value_type samples;
+   _sample_into(batch_size, samples);
+   return samples;
 }
 
 template < typename T >
@@ -123,67 +249,87 @@ auto DiscreteSpace< T >::_sample(size_t batch_size, std::nullopt_t /*unused*/) c
 
 template < typename T >
    requires discrete_reqs< T >
-template < std::ranges::range MaskRange >
-auto DiscreteSpace< T >::_sample(size_t batch_size, MaskRange&& mask) const -> batch_value_type
+void DiscreteSpace< T >::_sample_into(size_t batch_size, batch_value_type& out, std::nullopt_t)
+   const
 {
-   using namespace ranges;
-   if(batch_size == 0) {
-      return xt::empty< value_type >({0});
-   }
+   detail::uniform_below_fill(rng(), _nr_values(), _batch_storage(out, batch_size), m_start);
+}
 
-   if constexpr(std::ranges::sized_range< MaskRange >) {
-      if(std::ranges::size(mask) != static_cast< size_t >(m_nr_values)) {
-         throw std::invalid_argument(
-            fmt::format("Mask size cannot be smaller than the number of elements ({})", m_nr_values)
-         );
-      }
-   }
+template < typename T >
+   requires discrete_reqs< T >
+auto DiscreteSpace< T >::_sample(size_t batch_size, const BitMask& mask) const -> batch_value_type
+{
+   batch_value_type samples;
+   _sample_into(batch_size, samples, mask);
+   return samples;
+}
 
-   if constexpr(detail::is_xarray< MaskRange >
-                and std::integral< detail::value_t< detail::raw_t< MaskRange > > >) {
-      return _sample(internal_tag, batch_size, mask);
+template < typename T >
+   requires discrete_reqs< T >
+void DiscreteSpace< T >::_sample_into(
+   size_t batch_size,
+   batch_value_type& out,
+   const BitMask& mask
+) const
+{
+   _check_mask_size(mask.size());
+   auto samples = _batch_storage(out, batch_size);
+   const size_t n_valid = mask.count();
+   if(n_valid == 0) {
+      std::ranges::fill(samples, m_start);
+      return;
    }
-
-   std::vector< value_type > valid_indices;
-   valid_indices.reserve(batch_size);
-   auto&& flat_mask = xt::flatten(mask);
-   [[maybe_unused]] size_t mask_size = 0;
-   for(auto [i, selected] : views::zip(views::indices(0ul, batch_size), flat_mask)) {
-      if(selected) {
-         valid_indices.emplace_back(i);
-      }
-      ++mask_size;
+   if(n_valid == _nr_values()) {
+      detail::uniform_below_fill(rng(), n_valid, samples, m_start);
+      return;
    }
-   if constexpr(not std::ranges::sized_range< MaskRange >) {
-      if(mask_size != static_cast< size_t >(m_nr_values)) {
-         throw std::invalid_argument(
-            fmt::format("Mask size cannot be smaller than the number of elements ({})", m_nr_values)
-         );
-      }
+   // draw all ranks among the valid values in bulk, then map each rank to its value
+   detail::uniform_below_fill(rng(), n_valid, samples, T{0});
+   for(auto& sample : samples) {
+      sample = m_start + static_cast< T >(mask.select(static_cast< size_t >(sample)));
    }
+}
 
-   auto samples = xt::empty< value_type >(xt::svector{batch_size});
-   if(not valid_indices.empty()) {
-      std::uniform_int_distribution< size_t > dist(0UL, valid_indices.size() - 1);
-      for(auto i : views::iota(0UL, batch_size)) {
-         samples.unchecked(i) = m_start + static_cast< value_type >(valid_indices[dist(rng())]);
+template < typename T >
+   requires discrete_reqs< T >
+template < std::ranges::range MaskRange >
+BitMask DiscreteSpace< T >::_to_bitmask(const MaskRange& mask) const
+{
+   auto bitmask = std::invoke([&] {
+      if constexpr(detail::is_xarray< MaskRange >) {
+         if constexpr(std::integral< detail::value_t< MaskRange > >
+                      and sizeof(detail::value_t< MaskRange >) == 1) {
+            // bool and int8 masks are packed 8 bytes at a time
+            return BitMask{mask};
+         } else {
+            return BitMask::from_range(mask);
+         }
+      } else {
+         return BitMask::from_range(mask);
       }
-      return samples;
-   }
-   return {};
+   });
+   _check_mask_size(bitmask.size());
+   return bitmask;
 }
 
 template < typename T >
    requires discrete_reqs< T >
-auto DiscreteSpace< T >::_sample(internal_tag_t, size_t batch_size, const xarray< bool >& mask)
-   const -> batch_value_type
+template < std::ranges::range ProbabilityRange >
+std::shared_ptr< const AliasTable > DiscreteSpace< T >::_alias_table(
+   const ProbabilityRange& probabilities
+) const
 {
-   return xt::random::choice(
-      xt::eval(xt::filter(xt::arange(m_start, m_start + m_nr_values), mask)),
-      batch_size,
-      true,
-      rng()
-   );
+   auto table = std::invoke([&] {
+      if constexpr(detail::is_xarray< ProbabilityRange >) {
+         return detail::cached_alias_table(std::span{probabilities.data(), probabilities.size()});
+      } else if constexpr(std::ranges::contiguous_range< ProbabilityRange >) {
+         return detail::cached_alias_table(probabilities);
+      } else {
+         return std::make_shared< const AliasTable >(probabilities);
+      }
+   });
+   _check_mask_size(table->size());
+   return table;
 }
 
 }  // namespace force
@@ -0,0 +1,289 @@
+#ifndef REINFORCE_FIXED_BOX_HPP
+#define REINFORCE_FIXED_BOX_HPP
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "reinforce/spaces/concepts.hpp"
+#include "reinforce/spaces/space.hpp"
+#include "reinforce/utils/bounds.hpp"
+#include "reinforce/utils/xarray_formatter.hpp"
+#include "reinforce/utils/xtensor_typedefs.hpp"
+
+namespace force {
+
+namespace detail {
+
+/// which of the bounds of a box element are finite
+enum class box_bound_kind : uint8_t { unbounded, bounded_above, bounded_below, bounded };
+
+template < typename T >
+box_bound_kind bound_kind(T low, T high)
+{
+   const bool below = not std::isinf(low);
+   const bool above = not std::isinf(high);
+   if(below and above) {
+      return box_bound_kind::bounded;
+   }
+   if(below) {
+      return box_bound_kind::bounded_below;
+   }
+   return above ? box_bound_kind::bounded_above : box_bound_kind::unbounded;
+}
+
+}  // namespace detail
+
+/// @brief A Box space whose shape is part of its type.
+///
+/// Samples are `xtensor_fixed` arrays of shape (Shape...), which live on the stack and need no
+/// allocation. Batches of n samples are `xtensor`s of shape (n, Shape...). Sampling follows
+/// BoxSpace: uniform within finite bounds, exponential beyond a single finite bound and normal
+/// if both bounds are infinite. As with BoxSpace, masks are accepted but ignored.
+template < typename T, size_t... Shape >
+   requires box_reqs< T > and (sizeof...(Shape) > 0)
+class FixedBoxSpace: public Space<
+                        xstacktensor< T, Shape... >,
+                        FixedBoxSpace< T, Shape... >,
+                        xtensor< T, sizeof...(Shape) + 1 > > {
+  public:
+   friend class Space<
+      xstacktensor< T, Shape... >,
+      FixedBoxSpace,
+      xtensor< T, sizeof...(Shape) + 1 > >;
+   using base = Space<
+      xstacktensor< T, Shape... >,
+      FixedBoxSpace,
+      xtensor< T, sizeof...(Shape) + 1 > >;
+   using data_type = T;
+   using typename base::value_type;
+   using typename base::batch_value_type;
+   using base::shape;
+   using base::rng;
+
+   static constexpr size_t rank = sizeof...(Shape);
+   /// the number of elements of a single sample
+   static constexpr size_t size = (Shape * ...);
+   static constexpr std::array< size_t, rank > static_shape{Shape...};
+
+   FixedBoxSpace(value_type low, value_type high, std::optional< size_t > seed = std::nullopt);
+
+   template < typename U, typename V >
+      requires(std::is_arithmetic_v< U > and std::is_arithmetic_v< V >)
+   FixedBoxSpace(const U& low, const V& high, std::optional< size_t > seed = std::nullopt)
+       : FixedBoxSpace(_filled(static_cast< T >(low)), _filled(static_cast< T >(high)), seed)
+   {
+   }
+
+   bool operator==(const FixedBoxSpace& rhs) const
+   {
+      return m_low == rhs.m_low and m_high == rhs.m_high;
+   }
+
+   [[nodiscard]] bool is_flattenable() const { return true; }
+
+   const auto& low() const { return m_low; }
+   const auto& high() const { return m_high; }
+
+   [[nodiscard]] std::string repr() const
+   {
+      return fmt::format("FixedBox({}, {}, {})", m_low, m_high, shape());
+   }
+
+  private:
+   value_type m_low;
+   value_type m_high;
+   std::array< detail::box_bound_kind, size > m_kinds{};
+
+   static value_type _filled(T value)
+   {
+      value_type filled;
+      filled.fill(value);
+      return filled;
+   }
+
+   [[nodiscard]] value_type _sample(
+      const std::optional< xarray< bool > >& /*unused*/ = std::nullopt
+   ) const
+   {
+      value_type sample;
+      _fill(std::span< T, size >{sample.data(), size}, 1);
+      return sample;
+   }
+
+   void _sample_into(
+      value_type& out,
+      const std::optional< xarray< bool > >& /*unused*/ = std::nullopt
+   ) const
+   {
+      _fill(std::span< T, size >{out.data(), size}, 1);
+   }
+
+   [[nodiscard]] batch_value_type _sample(
+      size_t batch_size,
+      const std::optional< xarray< bool > >& /*unused*/ = std::nullopt
+   ) const
+   {
+      batch_value_type samples;
+      _sample_into(batch_size, samples);
+      return samples;
+   }
+
+   void _sample_into(
+      size_t batch_size,
+      batch_value_type& out,
+      const std::optional< xarray< bool > >& /*unused*/ = std::nullopt
+   ) const
+   {
+      // resizing keeps the buffer whenever the number of elements does not change
+      out.resize({batch_size, Shape...});
+      _fill(std::span< T >{out.data(), out.size()}, batch_size);
+   }
+
+   value_type _batch_to_value_type(const batch_value_type& batch) const
+   {
+      value_type value;
+      std::copy_n(batch.data(), size, value.data());
+      return value;
+   }
+
+   [[nodiscard]] bool _contains(const value_type& value) const
+   {
+      return detail::all_in_bounds< true, true, T >(
+         std::span{value.data(), size}, _bounds_span(m_low), _bounds_span(m_high)
+      );
+   }
+
+   [[nodiscard]] bool _contains(const batch_value_type& batch) const
+   {
+      return _has_sample_shape(batch)
+             and detail::all_in_bounds< true, true, T >(
+                std::span{batch.data(), batch.size()}, _bounds_span(m_low), _bounds_span(m_high)
+             );
+   }
+
+   [[nodiscard]] xarray< bool > _contains_batch(const batch_value_type& batch) const
+   {
+      if(not _has_sample_shape(batch)) {
+         throw std::invalid_argument(
+            "The batch has to be of the shape of the space with a leading batch dimension."
+         );
+      }
+      xarray< bool > valid = xarray< bool >::from_shape({batch.shape()[0]});
+      detail::rows_in_bounds< true, true, T >(
+         std::span< const T >{batch.data(), batch.size()},
+         _bounds_span(m_low),
+         _bounds_span(m_high),
+         std::span{valid.data(), valid.size()}
+      );
+      return valid;
+   }
+
+   [[nodiscard]] bool _contains_all(const batch_value_type& batch) const
+   {
+      return _contains(batch);
+   }
+
+   static std::span< const T > _bounds_span(const value_type& bounds)
+   {
+      return {bounds.data(), size};
+   }
+
+   static bool _has_sample_shape(const batch_value_type& batch)
+   {
+      return std::equal(static_shape.begin(), static_shape.end(), batch.shape().begin() + 1);
+   }
+
+   /// Fill the `nr_samples` consecutive samples of `out`, one element (column) at a time.
+   template < size_t extent >
+   void _fill(std::span< T, extent > out, size_t nr_samples) const;
+};
+
+template < typename T, size_t... Shape >
+   requires box_reqs< T > and (sizeof...(Shape) > 0)
+FixedBoxSpace< T, Shape... >::FixedBoxSpace(
+   value_type low,
+   value_type high,
+   std::optional< size_t > seed
+)
+    : base(xt::svector< int >{static_cast< int >(Shape)...}, seed),
+      m_low(std::move(low)),
+      m_high(std::move(high))
+{
+   for(size_t i = 0; i < size; ++i) {
+      if(m_high.data_element(i) < m_low.data_element(i)) {
+         throw std::invalid_argument(
+            "Some value-positions in 'low' are greater than their corresponding 'high' values."
+         );
+      }
+      m_kinds[i] = detail::bound_kind(m_low.data_element(i), m_high.data_element(i));
+   }
+}
+
+template < typename T, size_t... Shape >
+   requires box_reqs< T > and (sizeof...(Shape) > 0)
+template < size_t extent >
+void FixedBoxSpace< T, Shape... >::_fill(std::span< T, extent > out, size_t nr_samples) const
+{
+   using detail::box_bound_kind;
+   using uniform_distribution = std::conditional_t<
+      std::is_integral_v< T >,
+      std::uniform_int_distribution< T >,
+      std::uniform_real_distribution< T > >;
+   auto& gen = rng();
+   // the element loop has a compile-time trip count, the distributions are set up once per element
+   for(size_t i = 0; i < size; ++i) {
+      const T low = m_low.data_element(i);
+      const T high = m_high.data_element(i);
+      T* entry = out.data() + i;
+      switch(m_kinds[i]) {
+         case box_bound_kind::unbounded: {
+            // (-infinity, infinity)
+            std::normal_distribution< double > distribution{};
+            for(size_t sample = 0; sample < nr_samples; ++sample, entry += size) {
+               *entry = static_cast< T >(distribution(gen));
+            }
+            break;
+         }
+         case box_bound_kind::bounded_above: {
+            // (-infinity, B]
+            std::exponential_distribution< double > distribution{1};
+            for(size_t sample = 0; sample < nr_samples; ++sample, entry += size) {
+               *entry = static_cast< T >(high - static_cast< T >(distribution(gen)));
+            }
+            break;
+         }
+         case box_bound_kind::bounded_below: {
+            // [A, infinity)
+            std::exponential_distribution< double > distribution{1};
+            for(size_t sample = 0; sample < nr_samples; ++sample, entry += size) {
+               *entry = static_cast< T >(low + static_cast< T >(distribution(gen)));
+            }
+            break;
+         }
+         case box_bound_kind::bounded: {
+            // [A, B]
+            uniform_distribution distribution{low, high};
+            for(size_t sample = 0; sample < nr_samples; ++sample, entry += size) {
+               *entry = static_cast< T >(distribution(gen));
+            }
+            break;
+         }
+      }
+   }
+}
+
+}  // namespace force
+
+#endif  // REINFORCE_FIXED_BOX_HPP
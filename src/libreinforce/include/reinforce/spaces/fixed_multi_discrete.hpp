@@ -0,0 +1,225 @@
+#ifndef REINFORCE_FIXED_MULTI_DISCRETE_HPP
+#define REINFORCE_FIXED_MULTI_DISCRETE_HPP
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "reinforce/spaces/concepts.hpp"
+#include "reinforce/spaces/space.hpp"
+#include "reinforce/utils/bounds.hpp"
+#include "reinforce/utils/random.hpp"
+#include "reinforce/utils/xarray_formatter.hpp"
+#include "reinforce/utils/xtensor_typedefs.hpp"
+
+namespace force {
+
+/// @brief A MultiDiscrete space whose shape is part of its type.
+///
+/// Every element e takes the values start[e], ..., end[e] - 1. Samples are `xtensor_fixed` arrays
+/// of shape (Shape...) and batches of n samples `xtensor`s of shape (n, Shape...), so that single
+/// samples need no allocation. Element masks are only supported by the dynamically shaped
+/// MultiDiscreteSpace.
+template < typename T, size_t... Shape >
+   requires multidiscrete_reqs< T > and (sizeof...(Shape) > 0)
+class FixedMultiDiscreteSpace: public Space<
+                                  xstacktensor< T, Shape... >,
+                                  FixedMultiDiscreteSpace< T, Shape... >,
+                                  xtensor< T, sizeof...(Shape) + 1 > > {
+  public:
+   friend class Space<
+      xstacktensor< T, Shape... >,
+      FixedMultiDiscreteSpace,
+      xtensor< T, sizeof...(Shape) + 1 > >;
+   using base = Space<
+      xstacktensor< T, Shape... >,
+      FixedMultiDiscreteSpace,
+      xtensor< T, sizeof...(Shape) + 1 > >;
+   using data_type = T;
+   using typename base::value_type;
+   using typename base::batch_value_type;
+   using base::shape;
+   using base::rng;
+
+   static constexpr size_t rank = sizeof...(Shape);
+   /// the number of elements of a single sample
+   static constexpr size_t size = (Shape * ...);
+   static constexpr std::array< size_t, rank > static_shape{Shape...};
+
+   FixedMultiDiscreteSpace(
+      value_type start,
+      value_type end,
+      std::optional< size_t > seed = std::nullopt
+   );
+
+   explicit FixedMultiDiscreteSpace(value_type end, std::optional< size_t > seed = std::nullopt)
+       : FixedMultiDiscreteSpace(_zeros(), std::move(end), seed)
+   {
+   }
+
+   bool operator==(const FixedMultiDiscreteSpace& rhs) const
+   {
+      return m_start == rhs.m_start and m_end == rhs.m_end;
+   }
+
+   [[nodiscard]] std::string repr() const
+   {
+      return fmt::format("FixedMultiDiscrete({}, start={})", m_end, m_start);
+   }
+
+   const auto& start() const { return m_start; }
+   const auto& end() const { return m_end; }
+
+  private:
+   value_type m_start;
+   value_type m_end;
+   /// the number of values of every element
+   std::array< uint64_t, size > m_bounds{};
+
+   static value_type _zeros()
+   {
+      value_type zeros;
+      zeros.fill(T{0});
+      return zeros;
+   }
+
+   [[nodiscard]] value_type _sample(std::nullopt_t /**/ = std::nullopt) const
+   {
+      value_type sample;
+      _fill(std::span< T, size >{sample.data(), size}, 1);
+      return sample;
+   }
+
+   void _sample_into(value_type& out, std::nullopt_t /**/ = std::nullopt) const
+   {
+      _fill(std::span< T, size >{out.data(), size}, 1);
+   }
+
+   [[nodiscard]] batch_value_type
+   _sample(size_t batch_size, std::nullopt_t /**/ = std::nullopt) const
+   {
+      batch_value_type samples;
+      _sample_into(batch_size, samples);
+      return samples;
+   }
+
+   void
+   _sample_into(size_t batch_size, batch_value_type& out, std::nullopt_t /**/ = std::nullopt)
+      const
+   {
+      // resizing keeps the buffer whenever the number of elements does not change
+      out.resize({batch_size, Shape...});
+      _fill(std::span< T >{out.data(), out.size()}, batch_size);
+   }
+
+   value_type _batch_to_value_type(const batch_value_type& batch) const
+   {
+      value_type value;
+      std::copy_n(batch.data(), size, value.data());
+      return value;
+   }
+
+   [[nodiscard]] bool _contains(const value_type& value) const
+   {
+      return detail::all_in_bounds< true, false, T >(
+         std::span{value.data(), size}, _bounds_span(m_start), _bounds_span(m_end)
+      );
+   }
+
+   [[nodiscard]] bool _contains(const batch_value_type& batch) const
+   {
+      return _has_sample_shape(batch)
+             and detail::all_in_bounds< true, false, T >(
+                std::span{batch.data(), batch.size()},
+                _bounds_span(m_start),
+                _bounds_span(m_end)
+             );
+   }
+
+   [[nodiscard]] xarray< bool > _contains_batch(const batch_value_type& batch) const
+   {
+      if(not _has_sample_shape(batch)) {
+         throw std::invalid_argument(
+            "The batch has to be of the shape of the space with a leading batch dimension."
+         );
+      }
+      xarray< bool > valid = xarray< bool >::from_shape({batch.shape()[0]});
+      detail::rows_in_bounds< true, false, T >(
+         std::span< const T >{batch.data(), batch.size()},
+         _bounds_span(m_start),
+         _bounds_span(m_end),
+         std::span{valid.data(), valid.size()}
+      );
+      return valid;
+   }
+
+   [[nodiscard]] bool _contains_all(const batch_value_type& batch) const
+   {
+      return _contains(batch);
+   }
+
+   static std::span< const T > _bounds_span(const value_type& bounds)
+   {
+      return {bounds.data(), size};
+   }
+
+   static bool _has_sample_shape(const batch_value_type& batch)
+   {
+      return std::equal(static_shape.begin(), static_shape.end(), batch.shape().begin() + 1);
+   }
+
+   /// Fill the `nr_samples` consecutive samples of `out` in row-major order.
+   template < size_t extent >
+   void _fill(std::span< T, extent > out, size_t nr_samples) const
+   {
+      auto& gen = rng();
+      T* entry = out.data();
+      for(size_t sample = 0; sample < nr_samples; ++sample) {
+         // a compile-time trip count, so that the element loop can be unrolled
+         for(size_t i = 0; i < size; ++i, ++entry) {
+            *entry = static_cast< T >(
+               m_start.data_element(i) + static_cast< T >(detail::uniform_below(gen, m_bounds[i]))
+            );
+         }
+      }
+   }
+};
+
+template < typename T, size_t... Shape >
+   requires multidiscrete_reqs< T > and (sizeof...(Shape) > 0)
+FixedMultiDiscreteSpace< T, Shape... >::FixedMultiDiscreteSpace(
+   value_type start,
+   value_type end,
+   std::optional< size_t > seed
+)
+    : base(xt::svector< int >{static_cast< int >(Shape)...}, seed),
+      m_start(std::move(start)),
+      m_end(std::move(end))
+{
+   for(size_t i = 0; i < size; ++i) {
+      const T start_value = m_start.data_element(i);
+      const T end_value = m_end.data_element(i);
+      if(end_value <= start_value) {
+         throw std::invalid_argument(fmt::format(
+            "'High' bounds have to be greater than 'Low' bounds. Given low {} and high {} at flat "
+            "index {}.",
+            start_value,
+            end_value,
+            i
+         ));
+      }
+      m_bounds[i] = static_cast< uint64_t >(end_value - start_value);
+   }
+}
+
+}  // namespace force
+
+#endif  // REINFORCE_FIXED_MULTI_DISCRETE_HPP
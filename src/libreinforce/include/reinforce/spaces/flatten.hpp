@@ -0,0 +1,918 @@
+#ifndef REINFORCE_SPACES_FLATTEN_HPP
+#define REINFORCE_SPACES_FLATTEN_HPP
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <numeric>
+#include <span>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <xtensor/xadapt.hpp>
+
+#include "reinforce/spaces/box.hpp"
+#include "reinforce/spaces/dict.hpp"
+#include "reinforce/spaces/discrete.hpp"
+#include "reinforce/spaces/fixed_box.hpp"
+#include "reinforce/spaces/fixed_multi_discrete.hpp"
+#include "reinforce/spaces/multi_binary.hpp"
+#include "reinforce/spaces/multi_discrete.hpp"
+#include "reinforce/spaces/tuple.hpp"
+#include "reinforce/utils/type_traits.hpp"
+#include "reinforce/utils/xtensor_typedefs.hpp"
+
+namespace force {
+
+namespace detail {
+
+template < typename Shape >
+size_t flat_size(const Shape& shape)
+{
+   return std::accumulate(
+      shape.begin(), shape.end(), size_t{1}, [](size_t acc, auto dim) {
+         return acc * static_cast< size_t >(dim);
+      }
+   );
+}
+
+/// Copy `size` values, converting them only if the types differ (otherwise this is a memcpy).
+template < typename From, typename To >
+void copy_cast(const From* in, size_t size, To* out)
+{
+   if constexpr(std::same_as< std::remove_const_t< From >, To >) {
+      std::copy_n(in, size, out);
+   } else {
+      std::transform(in, in + size, out, [](From value) { return static_cast< To >(value); });
+   }
+}
+
+/// Write the one-hot encoding of `index` among `size` entries.
+template < typename F >
+void one_hot(size_t index, size_t size, F* out)
+{
+   if(index >= size) {
+      throw std::invalid_argument(
+         fmt::format("Cannot one-hot encode index {} among {} entries.", index, size)
+      );
+   }
+   std::fill_n(out, size, F{0});
+   out[index] = F{1};
+}
+
+/// The position of the first non-zero entry of a one-hot encoding.
+template < typename F >
+size_t one_hot_index(const F* in, size_t size)
+{
+   const auto* hot = std::find_if(in, in + size, [](F value) { return value != F{0}; });
+   if(hot == in + size) {
+      throw std::invalid_argument("A one-hot encoded value needs a non-zero entry.");
+   }
+   return static_cast< size_t >(hot - in);
+}
+
+/// The first axis of an array batch is the batch dimension.
+template < typename Array >
+size_t leading_dim(const Array& batch)
+{
+   return batch.dimension() == 0 ? 0 : batch.shape()[0];
+}
+
+/// spaces whose shape is part of their type, such as FixedBoxSpace
+template < typename Space >
+concept statically_shaped = requires {
+   Space::static_shape;
+   { Space::size } -> std::convertible_to< size_t >;
+};
+
+/// An uninitialized sample of the shape of the space.
+template < typename Space >
+value_t< Space > empty_value(const Space& space)
+{
+   if constexpr(statically_shaped< Space >) {
+      return value_t< Space >{};
+   } else {
+      return value_t< Space >::from_shape(space.shape());
+   }
+}
+
+}  // namespace detail
+
+/// @brief Flattening of space samples into vectors (as gymnasium's `flatten` utilities).
+///
+/// Box and MultiBinary samples are copied, Discrete and MultiDiscrete samples one-hot encoded and
+/// tuples concatenate the flat vectors of their subspaces. Every specialization provides:
+///   - `flatdim(space)`: the length of the flat vector,
+///   - `flatten(space, value, out)` and `flatten_batch(space, batch, out, stride)`: write one
+///     sample or a batch of samples (row r starting at `out + r * stride`),
+///   - `batch_size(space, batch)`,
+///   - `unflatten(space, in)` and `unflatten_view(space, in)`: the latter aliases `in` wherever the
+///     flat type matches the data type of the space,
+///   - `bounds(space, low, high)`: the bounds of the flat vector.
+template < typename Space >
+struct flattener;
+
+template < typename Space >
+concept flattenable_space = requires(const Space& space) {
+   { flattener< Space >::flatdim(space) } -> std::convertible_to< size_t >;
+};
+
+/// A flattener bound to one space, see below.
+template < flattenable_space Space >
+class Flattener;
+
+namespace detail {
+
+/// spaces whose flat dimension follows from their type, their flattener exposes it as a constant
+template < typename Space >
+concept constant_flatdim = requires {
+   { flattener< Space >::static_flatdim } -> std::convertible_to< size_t >;
+};
+
+/// The offsets of the subspaces of a tuple, known at compile time if all flat dimensions are.
+template < typename... Spaces >
+struct static_tuple_layout {};
+
+template < typename... Spaces >
+   requires(constant_flatdim< Spaces > and ...)
+struct static_tuple_layout< Spaces... > {
+   static constexpr std::array< size_t, sizeof...(Spaces) + 1 > static_offsets = [] {
+      std::array< size_t, sizeof...(Spaces) + 1 > offsets{};
+      size_t i = 0;
+      ((offsets[i + 1] = offsets[i] + flattener< Spaces >::static_flatdim, ++i), ...);
+      return offsets;
+   }();
+   static constexpr size_t static_flatdim = static_offsets.back();
+};
+
+}  // namespace detail
+
+namespace detail {
+
+/// The flattener of spaces over arrays whose values are copied as they are.
+template < typename Space >
+struct copy_flattener {
+   using space_type = Space;
+   using data_type = typename Space::data_type;
+   using value_type = detail::value_t< Space >;
+   using batch_value_type = detail::batch_value_t< Space >;
+
+   static constexpr size_t flatdim(const space_type& space)
+   {
+      if constexpr(statically_shaped< Space >) {
+         return Space::size;
+      } else {
+         return flat_size(space.shape());
+      }
+   }
+
+   template < typename F >
+   static void flatten(const space_type& space, const value_type& value, F* out)
+   {
+      const size_t dim = flatdim(space);
+      if(value.size() != dim) {
+         throw std::invalid_argument(fmt::format(
+            "Expected a sample with {} elements to flatten, got {}.", dim, value.size()
+         ));
+      }
+      copy_cast(value.data(), dim, out);
+   }
+
+   static size_t batch_size(const space_type& /*space*/, const batch_value_type& batch)
+   {
+      return leading_dim(batch);
+   }
+
+   template < typename F >
+   static void
+   flatten_batch(const space_type& space, const batch_value_type& batch, F* out, size_t stride)
+   {
+      const size_t dim = flatdim(space);
+      const size_t nr_rows = batch_size(space, batch);
+      if(batch.size() != nr_rows * dim) {
+         throw std::invalid_argument(fmt::format(
+            "Expected a batch of {} samples with {} elements each, got {} elements.",
+            nr_rows,
+            dim,
+            batch.size()
+         ));
+      }
+      if(stride == dim) {
+         // the rows are back to back in both buffers
+         copy_cast(batch.data(), nr_rows * dim, out);
+         return;
+      }
+      for(size_t row = 0; row < nr_rows; ++row) {
+         copy_cast(batch.data() + row * dim, dim, out + row * stride);
+      }
+   }
+
+   template < typename F >
+   static value_type unflatten(const space_type& space, const F* in)
+   {
+      auto value = empty_value(space);
+      copy_cast(in, value.size(), value.data());
+      return value;
+   }
+
+   template < typename F >
+   static auto unflatten_view(const space_type& space, F* in)
+   {
+      if constexpr(std::same_as< std::remove_const_t< F >, data_type >
+                   and statically_shaped< Space >) {
+         return xt::adapt(in, typename value_type::shape_type{});
+      } else if constexpr(std::same_as< std::remove_const_t< F >, data_type >) {
+         const auto& shape = space.shape();
+         return xt::adapt(
+            in,
+            flatdim(space),
+            xt::no_ownership(),
+            xt::svector< size_t >(shape.begin(), shape.end())
+         );
+      } else {
+         return unflatten(space, in);
+      }
+   }
+};
+
+}  // namespace detail
+
+template < typename T >
+struct flattener< BoxSpace< T > >: detail::copy_flattener< BoxSpace< T > > {
+   template < typename F >
+   static void bounds(const BoxSpace< T >& space, F* low, F* high)
+   {
+      detail::copy_cast(space.low().data(), space.low().size(), low);
+      detail::copy_cast(space.high().data(), space.high().size(), high);
+   }
+};
+
+template < typename T, size_t... Shape >
+struct flattener< FixedBoxSpace< T, Shape... > >:
+    detail::copy_flattener< FixedBoxSpace< T, Shape... > > {
+   static constexpr size_t static_flatdim = FixedBoxSpace< T, Shape... >::size;
+
+   template < typename F >
+   static void bounds(const FixedBoxSpace< T, Shape... >& space, F* low, F* high)
+   {
+      detail::copy_cast(space.low().data(), space.size, low);
+      detail::copy_cast(space.high().data(), space.size, high);
+   }
+};
+
+template <>
+struct flattener< MultiBinarySpace >: detail::copy_flattener< MultiBinarySpace > {
+   template < typename F >
+   static void bounds(const MultiBinarySpace& space, F* low, F* high)
+   {
+      std::fill_n(low, flatdim(space), F{0});
+      std::fill_n(high, flatdim(space), F{1});
+   }
+};
+
+template < typename T >
+struct flattener< DiscreteSpace< T > > {
+   using space_type = DiscreteSpace< T >;
+   using batch_value_type = typename space_type::batch_value_type;
+
+   static size_t flatdim(const space_type& space) { return static_cast< size_t >(space.n()); }
+
+   template < typename F >
+   static void flatten(const space_type& space, T value, F* out)
+   {
+      detail::one_hot(static_cast< size_t >(value - space.start()), flatdim(space), out);
+   }
+
+   static size_t batch_size(const space_type& /*space*/, const batch_value_type& batch)
+   {
+      return batch.size();
+   }
+
+   template < typename F >
+   static void
+   flatten_batch(const space_type& space, const batch_value_type& batch, F* out, size_t stride)
+   {
+      for(size_t row = 0; row < batch.size(); ++row) {
+         flatten(space, batch.data()[row], out + row * stride);
+      }
+   }
+
+   template < typename F >
+   static T unflatten(const space_type& space, const F* in)
+   {
+      const auto index = detail::one_hot_index(in, flatdim(space));
+      return static_cast< T >(space.start() + static_cast< T >(index));
+   }
+
+   template < typename F >
+   static T unflatten_view(const space_type& space, F* in)
+   {
+      return unflatten(space, in);
+   }
+
+   template < typename F >
+   static void bounds(const space_type& space, F* low, F* high)
+   {
+      std::fill_n(low, flatdim(space), F{0});
+      std::fill_n(high, flatdim(space), F{1});
+   }
+};
+
+namespace detail {
+
+/// Every element is one-hot encoded over its own range, the encodings follow each other.
+template < typename Space >
+struct one_hot_flattener {
+   using space_type = Space;
+   using T = typename Space::data_type;
+   using value_type = typename space_type::value_type;
+   using batch_value_type = typename space_type::batch_value_type;
+
+   static size_t flatdim(const space_type& space)
+   {
+      size_t dim = 0;
+      for(size_t i = 0; i < space.start().size(); ++i) {
+         dim += _range_size(space, i);
+      }
+      return dim;
+   }
+
+   template < typename F >
+   static void flatten(const space_type& space, const value_type& value, F* out)
+   {
+      if(value.size() != space.start().size()) {
+         throw std::invalid_argument(fmt::format(
+            "Expected a sample with {} elements to flatten, got {}.",
+            space.start().size(),
+            value.size()
+         ));
+      }
+      _flatten_row(space, value.data(), out);
+   }
+
+   static size_t batch_size(const space_type& /*space*/, const batch_value_type& batch)
+   {
+      return leading_dim(batch);
+   }
+
+   template < typename F >
+   static void
+   flatten_batch(const space_type& space, const batch_value_type& batch, F* out, size_t stride)
+   {
+      const size_t nr_elements = space.start().size();
+      const size_t nr_rows = batch_size(space, batch);
+      if(batch.size() != nr_rows * nr_elements) {
+         throw std::invalid_argument(fmt::format(
+            "Expected a batch of {} samples with {} elements each, got {} elements.",
+            nr_rows,
+            nr_elements,
+            batch.size()
+         ));
+      }
+      for(size_t row = 0; row < nr_rows; ++row) {
+         _flatten_row(space, batch.data() + row * nr_elements, out + row * stride);
+      }
+   }
+
+   template < typename F >
+   static value_type unflatten(const space_type& space, const F* in)
+   {
+      auto value = empty_value(space);
+      for(size_t i = 0; i < value.size(); ++i) {
+         const size_t range_size = _range_size(space, i);
+         value.data()[i] = static_cast< T >(
+            space.start().data()[i] + static_cast< T >(one_hot_index(in, range_size))
+         );
+         in += range_size;
+      }
+      return value;
+   }
+
+   template < typename F >
+   static value_type unflatten_view(const space_type& space, F* in)
+   {
+      return unflatten(space, in);
+   }
+
+   template < typename F >
+   static void bounds(const space_type& space, F* low, F* high)
+   {
+      std::fill_n(low, flatdim(space), F{0});
+      std::fill_n(high, flatdim(space), F{1});
+   }
+
+  private:
+   static size_t _range_size(const space_type& space, size_t element)
+   {
+      return static_cast< size_t >(space.end().data()[element] - space.start().data()[element]);
+   }
+
+   template < typename F >
+   static void _flatten_row(const space_type& space, const T* values, F* out)
+   {
+      const T* start = space.start().data();
+      for(size_t i = 0; i < space.start().size(); ++i) {
+         const size_t range_size = _range_size(space, i);
+         one_hot(static_cast< size_t >(values[i] - start[i]), range_size, out);
+         out += range_size;
+      }
+   }
+};
+
+}  // namespace detail
+
+template < typename T >
+struct flattener< MultiDiscreteSpace< T > >:
+    detail::one_hot_flattener< MultiDiscreteSpace< T > > {};
+
+template < typename T, size_t... Shape >
+struct flattener< FixedMultiDiscreteSpace< T, Shape... > >:
+    detail::one_hot_flattener< FixedMultiDiscreteSpace< T, Shape... > > {};
+
+/// @brief Tuples place the flat vector of subspace I at offset `offsets(space)[I]`.
+///
+/// If every subspace has a constant flat dimension, the offsets are the compile-time constants
+/// `static_offsets`. Otherwise they follow from the flat dimensions of the subspaces, which each of
+/// the functions below derives anew; a `Flattener` of the tuple derives them once.
+template < typename... Spaces >
+   requires(flattenable_space< Spaces > and ...)
+struct flattener< TupleSpace< Spaces... > >: detail::static_tuple_layout< Spaces... > {
+   using space_type = TupleSpace< Spaces... >;
+   using value_type = typename space_type::value_type;
+   using batch_value_type = typename space_type::batch_value_type;
+   using offsets_type = std::array< size_t, sizeof...(Spaces) + 1 >;
+
+   static offsets_type offsets(const space_type& space)
+   {
+      if constexpr(detail::constant_flatdim< space_type >) {
+         return detail::static_tuple_layout< Spaces... >::static_offsets;
+      } else {
+         return Flattener< space_type >{space}.offsets();
+      }
+   }
+
+   static size_t flatdim(const space_type& space) { return offsets(space).back(); }
+
+   template < typename F >
+   static void flatten(const space_type& space, const value_type& value, F* out)
+   {
+      Flattener< space_type >{space}.flatten(value, out);
+   }
+
+   static size_t batch_size(const space_type& space, const batch_value_type& batch)
+   {
+      return Flattener< space_type >{space}.batch_size(batch);
+   }
+
+   template < typename F >
+   static void
+   flatten_batch(const space_type& space, const batch_value_type& batch, F* out, size_t stride)
+   {
+      Flattener< space_type >{space}.flatten_batch(batch, out, stride);
+   }
+
+   template < typename F >
+   static value_type unflatten(const space_type& space, const F* in)
+   {
+      return Flattener< space_type >{space}.unflatten(in);
+   }
+
+   template < typename F >
+   static auto unflatten_view(const space_type& space, F* in)
+   {
+      return Flattener< space_type >{space}.unflatten_view(in);
+   }
+
+   template < typename F >
+   static void bounds(const space_type& space, F* low, F* high)
+   {
+      Flattener< space_type >{space}.bounds(low, high);
+   }
+};
+
+/// Dicts flatten as the tuple of their subspaces in declaration order.
+template < typename... Entries >
+   requires(flattenable_space< typename Entries::space_type > and ...)
+struct flattener< DictSpace< Entries... > >:
+    detail::static_tuple_layout< typename Entries::space_type... > {
+   using space_type = DictSpace< Entries... >;
+   using value_type = typename space_type::value_type;
+   using batch_value_type = typename space_type::batch_value_type;
+   using tuple_flattener = flattener< typename space_type::tuple_space_type >;
+
+   static auto offsets(const space_type& space) { return tuple_flattener::offsets(space.spaces()); }
+
+   static size_t flatdim(const space_type& space)
+   {
+      return tuple_flattener::flatdim(space.spaces());
+   }
+
+   template < typename F >
+   static void flatten(const space_type& space, const value_type& value, F* out)
+   {
+      Flattener< space_type >{space}.flatten(value, out);
+   }
+
+   static size_t batch_size(const space_type& space, const batch_value_type& batch)
+   {
+      return Flattener< space_type >{space}.batch_size(batch);
+   }
+
+   template < typename F >
+   static void
+   flatten_batch(const space_type& space, const batch_value_type& batch, F* out, size_t stride)
+   {
+      Flattener< space_type >{space}.flatten_batch(batch, out, stride);
+   }
+
+   template < typename F >
+   static value_type unflatten(const space_type& space, const F* in)
+   {
+      return Flattener< space_type >{space}.unflatten(in);
+   }
+
+   template < typename F >
+   static auto unflatten_view(const space_type& space, F* in)
+   {
+      return Flattener< space_type >{space}.unflatten_view(in);
+   }
+
+   template < typename F >
+   static void bounds(const space_type& space, F* low, F* high)
+   {
+      Flattener< space_type >{space}.bounds(low, high);
+   }
+};
+
+/// @brief A flattener that computes the flat dimension of its space once, at construction.
+///
+/// It refers to the space, which has to outlive it and must keep its shape and bounds meanwhile.
+/// Flattening many samples of one space through a Flattener spares the repeated layout
+/// computations of the free functions, e.g. the one-hot widths of a MultiDiscreteSpace.
+template < flattenable_space Space >
+class Flattener {
+  public:
+   using space_type = Space;
+   using value_type = detail::value_t< Space >;
+   using batch_value_type = detail::batch_value_t< Space >;
+
+   explicit Flattener(const Space& space)
+       : m_space(&space), m_flatdim(flattener< Space >::flatdim(space))
+   {
+   }
+
+   [[nodiscard]] const space_type& space() const { return *m_space; }
+
+   [[nodiscard]] size_t flatdim() const { return m_flatdim; }
+
+   template < typename F >
+   void flatten(const value_type& value, F* out) const
+   {
+      flattener< Space >::flatten(*m_space, value, out);
+   }
+
+   [[nodiscard]] size_t batch_size(const batch_value_type& batch) const
+   {
+      return flattener< Space >::batch_size(*m_space, batch);
+   }
+
+   template < typename F >
+   void flatten_batch(const batch_value_type& batch, F* out, size_t stride) const
+   {
+      flattener< Space >::flatten_batch(*m_space, batch, out, stride);
+   }
+
+   template < typename F >
+   value_type unflatten(const F* in) const
+   {
+      return flattener< Space >::unflatten(*m_space, in);
+   }
+
+   template < typename F >
+   auto unflatten_view(F* in) const
+   {
+      return flattener< Space >::unflatten_view(*m_space, in);
+   }
+
+   template < typename F >
+   void bounds(F* low, F* high) const
+   {
+      flattener< Space >::bounds(*m_space, low, high);
+   }
+
+  private:
+   const space_type* m_space;
+   size_t m_flatdim;
+};
+
+/// Tuples keep a Flattener of every subspace and the offsets of their flat vectors.
+template < typename... Spaces >
+   requires(flattenable_space< Spaces > and ...)
+class Flattener< TupleSpace< Spaces... > > {
+  public:
+   using space_type = TupleSpace< Spaces... >;
+   using value_type = typename space_type::value_type;
+   using batch_value_type = typename space_type::batch_value_type;
+   using offsets_type = typename flattener< space_type >::offsets_type;
+
+   explicit Flattener(const space_type& space)
+       : m_flatteners([&]< size_t... Is >(std::index_sequence< Is... >) {
+            return std::tuple{Flattener< Spaces >{space.template get< Is >()}...};
+         }(spaces_idx_seq))
+   {
+      if constexpr(detail::constant_flatdim< space_type >) {
+         m_offsets = flattener< space_type >::static_offsets;
+      } else {
+         [&]< size_t... Is >(std::index_sequence< Is... >) {
+            ((m_offsets[Is + 1] = m_offsets[Is] + std::get< Is >(m_flatteners).flatdim()), ...);
+         }(spaces_idx_seq);
+      }
+   }
+
+   [[nodiscard]] const offsets_type& offsets() const { return m_offsets; }
+
+   [[nodiscard]] size_t flatdim() const { return m_offsets.back(); }
+
+   template < typename F >
+   void flatten(const value_type& value, F* out) const
+   {
+      [&]< size_t... Is >(std::index_sequence< Is... >) {
+         (std::get< Is >(m_flatteners).flatten(std::get< Is >(value), out + m_offsets[Is]), ...);
+      }(spaces_idx_seq);
+   }
+
+   [[nodiscard]] size_t batch_size(const batch_value_type& batch) const
+   {
+      const auto sizes = [&]< size_t... Is >(std::index_sequence< Is... >) {
+         return std::array{std::get< Is >(m_flatteners).batch_size(std::get< Is >(batch))...};
+      }(spaces_idx_seq);
+      if(std::ranges::adjacent_find(sizes, std::not_equal_to{}) != sizes.end()) {
+         throw std::invalid_argument("The sub-batches of a tuple batch differ in size.");
+      }
+      return sizes[0];
+   }
+
+   template < typename F >
+   void flatten_batch(const batch_value_type& batch, F* out, size_t stride) const
+   {
+      [&]< size_t... Is >(std::index_sequence< Is... >) {
+         (std::get< Is >(m_flatteners)
+             .flatten_batch(std::get< Is >(batch), out + m_offsets[Is], stride),
+          ...);
+      }(spaces_idx_seq);
+   }
+
+   template < typename F >
+   value_type unflatten(const F* in) const
+   {
+      return [&]< size_t... Is >(std::index_sequence< Is... >) {
+         return value_type{std::get< Is >(m_flatteners).unflatten(in + m_offsets[Is])...};
+      }(spaces_idx_seq);
+   }
+
+   template < typename F >
+   auto unflatten_view(F* in) const
+   {
+      return [&]< size_t... Is >(std::index_sequence< Is... >) {
+         return std::tuple{std::get< Is >(m_flatteners).unflatten_view(in + m_offsets[Is])...};
+      }(spaces_idx_seq);
+   }
+
+   template < typename F >
+   void bounds(F* low, F* high) const
+   {
+      [&]< size_t... Is >(std::index_sequence< Is... >) {
+         (std::get< Is >(m_flatteners).bounds(low + m_offsets[Is], high + m_offsets[Is]), ...);
+      }(spaces_idx_seq);
+   }
+
+  private:
+   static constexpr auto spaces_idx_seq = std::index_sequence_for< Spaces... >{};
+
+   std::tuple< Flattener< Spaces >... > m_flatteners;
+   offsets_type m_offsets{};
+};
+
+/// Dicts keep the Flattener of the tuple of their subspaces.
+template < typename... Entries >
+   requires(flattenable_space< typename Entries::space_type > and ...)
+class Flattener< DictSpace< Entries... > > {
+  public:
+   using space_type = DictSpace< Entries... >;
+   using value_type = typename space_type::value_type;
+   using batch_value_type = typename space_type::batch_value_type;
+   using tuple_flattener_type = Flattener< typename space_type::tuple_space_type >;
+
+   explicit Flattener(const space_type& space) : m_tuple_flattener(space.spaces()) {}
+
+   [[nodiscard]] const auto& offsets() const { return m_tuple_flattener.offsets(); }
+
+   [[nodiscard]] size_t flatdim() const { return m_tuple_flattener.flatdim(); }
+
+   template < typename F >
+   void flatten(const value_type& value, F* out) const
+   {
+      m_tuple_flattener.flatten(value.as_tuple(), out);
+   }
+
+   [[nodiscard]] size_t batch_size(const batch_value_type& batch) const
+   {
+      return m_tuple_flattener.batch_size(batch.as_tuple());
+   }
+
+   template < typename F >
+   void flatten_batch(const batch_value_type& batch, F* out, size_t stride) const
+   {
+      m_tuple_flattener.flatten_batch(batch.as_tuple(), out, stride);
+   }
+
+   template < typename F >
+   value_type unflatten(const F* in) const
+   {
+      return value_type{m_tuple_flattener.unflatten(in)};
+   }
+
+   template < typename F >
+   auto unflatten_view(F* in) const
+   {
+      return std::apply(
+         []< typename... Views >(Views&&... views) {
+            return Dict< typename space_type::keys, std::remove_cvref_t< Views >... >{
+               std::move(views)...
+            };
+         },
+         m_tuple_flattener.unflatten_view(in)
+      );
+   }
+
+   template < typename F >
+   void bounds(F* low, F* high) const
+   {
+      m_tuple_flattener.bounds(low, high);
+   }
+
+  private:
+   tuple_flattener_type m_tuple_flattener;
+};
+
+/// The length of the flat vector of a sample.
+template < flattenable_space Space >
+size_t flatdim(const Space& space)
+{
+   return flattener< Space >::flatdim(space);
+}
+
+/// Flatten a sample into the first `flatdim()` entries of `out`.
+template < typename F, flattenable_space Space >
+void flatten(
+   const Flattener< Space >& space_flattener,
+   const detail::value_t< Space >& value,
+   std::span< F > out
+)
+{
+   if(out.size() < space_flattener.flatdim()) {
+      throw std::invalid_argument(fmt::format(
+         "The output buffer holds {} values, but the flat sample needs {}.",
+         out.size(),
+         space_flattener.flatdim()
+      ));
+   }
+   space_flattener.flatten(value, out.data());
+}
+
+template < typename F, flattenable_space Space >
+void flatten(const Space& space, const detail::value_t< Space >& value, std::span< F > out)
+{
+   flatten(Flattener< Space >{space}, value, out);
+}
+
+template < typename F = double, flattenable_space Space >
+xarray< F >
+flatten(const Flattener< Space >& space_flattener, const detail::value_t< Space >& value)
+{
+   auto flat = xarray< F >::from_shape({space_flattener.flatdim()});
+   space_flattener.flatten(value, flat.data());
+   return flat;
+}
+
+template < typename F = double, flattenable_space Space >
+xarray< F > flatten(const Space& space, const detail::value_t< Space >& value)
+{
+   return flatten< F >(Flattener< Space >{space}, value);
+}
+
+/// Flatten a batch of n samples into the n rows of the row-major (n x flatdim) buffer `out`.
+template < typename F, flattenable_space Space >
+void flatten_batch(
+   const Flattener< Space >& space_flattener,
+   const detail::batch_value_t< Space >& batch,
+   std::span< F > out
+)
+{
+   const size_t dim = space_flattener.flatdim();
+   const size_t nr_samples = space_flattener.batch_size(batch);
+   if(out.size() < nr_samples * dim) {
+      throw std::invalid_argument(fmt::format(
+         "The output buffer holds {} values, but {} flat samples need {}.",
+         out.size(),
+         nr_samples,
+         nr_samples * dim
+      ));
+   }
+   space_flattener.flatten_batch(batch, out.data(), dim);
+}
+
+template < typename F, flattenable_space Space >
+void flatten_batch(
+   const Space& space,
+   const detail::batch_value_t< Space >& batch,
+   std::span< F > out
+)
+{
+   flatten_batch(Flattener< Space >{space}, batch, out);
+}
+
+template < typename F = double, flattenable_space Space >
+xarray< F > flatten_batch(
+   const Flattener< Space >& space_flattener,
+   const detail::batch_value_t< Space >& batch
+)
+{
+   auto flat = xarray< F >::from_shape(
+      {space_flattener.batch_size(batch), space_flattener.flatdim()}
+   );
+   flatten_batch(space_flattener, batch, std::span{flat.data(), flat.size()});
+   return flat;
+}
+
+template < typename F = double, flattenable_space Space >
+xarray< F > flatten_batch(const Space& space, const detail::batch_value_t< Space >& batch)
+{
+   return flatten_batch< F >(Flattener< Space >{space}, batch);
+}
+
+/// Restore a sample from its flat vector.
+template < typename F, flattenable_space Space >
+detail::value_t< Space >
+unflatten(const Flattener< Space >& space_flattener, std::span< const F > flat)
+{
+   if(flat.size() < space_flattener.flatdim()) {
+      throw std::invalid_argument(fmt::format(
+         "The flat vector holds {} values, but the space needs {}.",
+         flat.size(),
+         space_flattener.flatdim()
+      ));
+   }
+   return space_flattener.unflatten(flat.data());
+}
+
+template < typename F, flattenable_space Space >
+detail::value_t< Space > unflatten(const Space& space, std::span< const F > flat)
+{
+   return unflatten(Flattener< Space >{space}, flat);
+}
+
+/// @brief Restore a sample from its flat vector, aliasing the vector wherever possible.
+///
+/// Box and MultiBinary (sub)samples whose data type matches F are returned as xtensor adaptors
+/// over `flat`, so writes through them land in the flat buffer and `flat` has to outlive them. All
+/// other (sub)samples are decoded into values.
+template < typename F, flattenable_space Space >
+auto unflatten_view(const Flattener< Space >& space_flattener, std::span< F > flat)
+{
+   if(flat.size() < space_flattener.flatdim()) {
+      throw std::invalid_argument(fmt::format(
+         "The flat vector holds {} values, but the space needs {}.",
+         flat.size(),
+         space_flattener.flatdim()
+      ));
+   }
+   return space_flattener.unflatten_view(flat.data());
+}
+
+template < typename F, flattenable_space Space >
+auto unflatten_view(const Space& space, std::span< F > flat)
+{
+   return unflatten_view(Flattener< Space >{space}, flat);
+}
+
+/// The Box space of the flat vectors of a space's samples.
+template < typename F = double, flattenable_space Space >
+BoxSpace< F > flatten_space(const Space& space)
+{
+   const Flattener< Space > space_flattener{space};
+   const size_t dim = space_flattener.flatdim();
+   auto low = xarray< F >::from_shape({dim});
+   auto high = xarray< F >::from_shape({dim});
+   space_flattener.bounds(low.data(), high.data());
+   return BoxSpace< F >{std::move(low), std::move(high)};
+}
+
+}  // namespace force
+
+#endif  // REINFORCE_SPACES_FLATTEN_HPP
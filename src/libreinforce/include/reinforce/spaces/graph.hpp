@@ -2,9 +2,14 @@
 #ifndef REINFORCE_GRAPH_HPP
 #define REINFORCE_GRAPH_HPP
 
+#include <algorithm>
 #include <cstddef>
 #include <optional>
+#include <span>
 #include <string>
+#include <vector>
+#include <xtensor/xnoalias.hpp>
+#include <xtensor/xstrided_view.hpp>
 
 #include "reinforce/fwd.hpp"
 #include "reinforce/spaces/space.hpp"
@@ -31,6 +36,195 @@ struct GraphInstance {
    /// An (m x 2) sized array of ints.
    idx_xarray edge_links;
 };
+
+/// @brief The arrays of one graph of a PackedGraphBatch as views, see `PackedGraphBatch::view`.
+template < typename Nodes, typename Edges, typename EdgeLinks >
+struct GraphInstanceView {
+   Nodes nodes;
+   Edges edges;
+   EdgeLinks edge_links;
+};
+
+/// @brief A batch of graphs packed into contiguous arrays (as PyTorch Geometric's `Batch`).
+///
+/// The nodes and edges of all graphs are concatenated along the first axis. Graph g owns the rows
+/// [node_offsets[g], node_offsets[g + 1]) of `nodes` and [edge_offsets[g], edge_offsets[g + 1])
+/// of `edges` and `edge_links`. The edge links are global row indices into `nodes`, i.e. shifted
+/// by the node offset of their graph. `graph_ids` maps every node to the graph it belongs to.
+template < typename DTypeNode, typename DTypeEdge >
+struct PackedGraphBatch {
+   using instance_type = GraphInstance< DTypeNode, DTypeEdge >;
+
+   xarray< DTypeNode > nodes = xarray< DTypeNode >::from_shape({0});
+   xarray< DTypeEdge > edges = xarray< DTypeEdge >::from_shape({0});
+   /// An (M x 2) sized array of global node indices.
+   idx_xarray edge_links = idx_xarray::from_shape({0, 2});
+   std::vector< size_t > node_offsets{0};
+   std::vector< size_t > edge_offsets{0};
+   std::vector< size_t > graph_ids{};
+
+   [[nodiscard]] size_t size() const { return node_offsets.size() - 1; }
+
+   /// the node features of graph `index` as a view into `nodes`
+   [[nodiscard]] auto nodes_of(size_t index) const
+   {
+      return xt::strided_view(
+         nodes, {xt::range(node_offsets[index], node_offsets[index + 1]), xt::ellipsis()}
+      );
+   }
+   /// the edge features of graph `index` as a view into `edges`
+   [[nodiscard]] auto edges_of(size_t index) const
+   {
+      return xt::strided_view(
+         edges, {xt::range(edge_offsets[index], edge_offsets[index + 1]), xt::ellipsis()}
+      );
+   }
+   /// the edge links of graph `index` with node indices local to the graph (lazily evaluated)
+   [[nodiscard]] auto edge_links_of(size_t index) const
+   {
+      return xt::strided_view(
+                edge_links, {xt::range(edge_offsets[index], edge_offsets[index + 1]), xt::all()}
+             )
+             - node_offsets[index];
+   }
+
+   /// graph `index` without copying, i.e. the views `nodes_of`, `edges_of` and `edge_links_of`
+   [[nodiscard]] auto view(size_t index) const
+   {
+      return GraphInstanceView<
+         decltype(nodes_of(index)),
+         decltype(edges_of(index)),
+         decltype(edge_links_of(index)) >{
+         nodes_of(index), edges_of(index), edge_links_of(index)
+      };
+   }
+
+   /// a copy of graph `index` as a standalone instance
+   [[nodiscard]] instance_type instance(size_t index) const
+   {
+      return instance_type{
+         .nodes = nodes_of(index), .edges = edges_of(index), .edge_links = edge_links_of(index)
+      };
+   }
+
+   [[nodiscard]] std::vector< instance_type > unpack() const
+   {
+      std::vector< instance_type > instances;
+      instances.reserve(size());
+      for(size_t index = 0; index < size(); ++index) {
+         instances.emplace_back(instance(index));
+      }
+      return instances;
+   }
+};
+
+/// How GraphSpace draws the edge links of a graph.
+struct EdgeSampling {
+   /// whether an edge may connect a node with itself
+   bool self_loops = true;
+   /// whether every (source, target) pair may appear at most once. Unique edges are emitted in
+   /// ascending (source, target) order.
+   bool unique = false;
+
+   bool operator==(const EdgeSampling&) const = default;
+};
+
+/// The endpoint by which an adjacency index groups the edges.
+enum class AdjacencyOrder {
+   /// compressed sparse rows: the outgoing edges of every node
+   by_source,
+   /// compressed sparse columns: the incoming edges of every node
+   by_target
+};
+
+/// @brief A compressed sparse adjacency index of a graph.
+///
+/// The neighbours of node v are `indices[offsets[v] .. offsets[v + 1])` in the order of the
+/// edges, i.e. the targets of v's outgoing edges (AdjacencyOrder::by_source) or the sources of its
+/// incoming edges (AdjacencyOrder::by_target). `edge_ids` holds the row of each entry in the
+/// edge links and edge features.
+struct GraphAdjacency {
+   std::vector< size_t > offsets{0};
+   std::vector< size_t > indices{};
+   std::vector< size_t > edge_ids{};
+
+   [[nodiscard]] size_t nr_nodes() const { return offsets.size() - 1; }
+   [[nodiscard]] size_t degree(size_t node) const { return offsets[node + 1] - offsets[node]; }
+
+   [[nodiscard]] std::span< const size_t > neighbours(size_t node) const
+   {
+      return std::span{indices}.subspan(offsets[node], degree(node));
+   }
+   [[nodiscard]] std::span< const size_t > edges_of(size_t node) const
+   {
+      return std::span{edge_ids}.subspan(offsets[node], degree(node));
+   }
+
+   bool operator==(const GraphAdjacency&) const = default;
+};
+
+/// Build the adjacency index of the (m x 2) `edge_links` between `nr_nodes` nodes by a counting
+/// sort in O(n + m).
+GraphAdjacency make_adjacency(
+   const idx_xarray& edge_links,
+   size_t nr_nodes,
+   AdjacencyOrder order = AdjacencyOrder::by_source
+);
+
+template < typename DTypeNode, typename DTypeEdge >
+GraphAdjacency make_adjacency(
+   const GraphInstance< DTypeNode, DTypeEdge >& graph,
+   AdjacencyOrder order = AdjacencyOrder::by_source
+)
+{
+   return make_adjacency(
+      graph.edge_links, graph.nodes.dimension() == 0 ? 0 : graph.nodes.shape()[0], order
+   );
+}
+
+template < typename DTypeNode, typename DTypeEdge >
+std::vector< GraphAdjacency > make_adjacency(
+   const std::vector< GraphInstance< DTypeNode, DTypeEdge > >& graphs,
+   AdjacencyOrder order = AdjacencyOrder::by_source
+)
+{
+   std::vector< GraphAdjacency > adjacencies;
+   adjacencies.reserve(graphs.size());
+   for(const auto& graph : graphs) {
+      adjacencies.emplace_back(make_adjacency(graph, order));
+   }
+   return adjacencies;
+}
+
+/// The adjacency of all graphs of the batch at once, indexed by the batch-global node indices.
+template < typename DTypeNode, typename DTypeEdge >
+GraphAdjacency make_adjacency(
+   const PackedGraphBatch< DTypeNode, DTypeEdge >& batch,
+   AdjacencyOrder order = AdjacencyOrder::by_source
+)
+{
+   return make_adjacency(batch.edge_links, batch.node_offsets.back(), order);
+}
+
+namespace detail {
+
+/// Write `nr_edges` (source, target) pairs between the nodes [node_offset, node_offset + nr_nodes)
+/// into `out`.
+///
+/// Every pair is drawn as one key from [0, nr_nodes * nr_targets). Excluding self loops shifts
+/// the targets past the source instead of rejecting draws. Unique edges are found by rejecting
+/// duplicates among the sorted keys (or, for dense graphs, by drawing the excluded keys instead).
+void sample_edge_links(
+   pcg64& gen,
+   size_t nr_nodes,
+   size_t nr_edges,
+   const EdgeSampling& sampling,
+   size_t node_offset,
+   size_t* out
+);
+
+}  // namespace detail
+
 }  // namespace force
 
 template < typename... Args >
@@ -106,6 +300,9 @@ class GraphSpace:
    using typename base::batch_value_type;
    using node_space_type = NodeSpace;
    using edge_space_type = EdgeSpace;
+   using packed_batch_type = PackedGraphBatch<
+      detail::dtype_selector_t< NodeSpace >,
+      detail::dtype_selector_t< EdgeSpace > >;
    using base::seed;
    using base::shape;
    using base::rng;
@@ -127,6 +324,24 @@ class GraphSpace:
 
    bool operator==(const GraphSpace& rhs) const = default;
 
+   void enable_thread_streams(size_t n_threads)
+   {
+      base::enable_thread_streams(n_threads);
+      m_node_space.enable_thread_streams(n_threads);
+      if(m_edge_space.has_value()) {
+         m_edge_space->enable_thread_streams(n_threads);
+      }
+   }
+
+   void disable_thread_streams()
+   {
+      base::disable_thread_streams();
+      m_node_space.disable_thread_streams();
+      if(m_edge_space.has_value()) {
+         m_edge_space->disable_thread_streams();
+      }
+   }
+
    [[nodiscard]] std::string repr() const
    {
       return fmt::format("Graph({}, {})", m_node_space, m_edge_space);
@@ -135,9 +350,41 @@ class GraphSpace:
    const auto& node_space() const { return m_node_space; }
    const auto& edge_space() const { return m_edge_space; }
 
+   [[nodiscard]] const EdgeSampling& edge_sampling() const { return m_edge_sampling; }
+   void set_edge_sampling(EdgeSampling sampling) { m_edge_sampling = sampling; }
+
+   /// @brief Sample a batch of graphs directly into the packed layout of PackedGraphBatch.
+   ///
+   /// The node and edge counts are specified as in `sample(batch_size, ...)`. All node (edge)
+   /// features are drawn in a single call of the node (edge) space.
+   template <
+      typename size_or_range_t = size_t,
+      typename optional_size_or_forwardrange_t = std::optional< size_t > >
+   [[nodiscard]] packed_batch_type sample_packed(
+      size_t batch_size,
+      size_or_range_t&& num_nodes = 10,
+      optional_size_or_forwardrange_t&& num_edges = std::nullopt
+   ) const
+   {
+      packed_batch_type batch;
+      sample_packed_into(batch_size, batch, FWD(num_nodes), FWD(num_edges));
+      return batch;
+   }
+
+   template <
+      typename size_or_range_t = size_t,
+      typename optional_size_or_forwardrange_t = std::optional< size_t > >
+   void sample_packed_into(
+      size_t batch_size,
+      packed_batch_type& out,
+      size_or_range_t&& num_nodes = 10,
+      optional_size_or_forwardrange_t&& num_edges = std::nullopt
+   ) const;
+
   private:
    NodeSpace m_node_space;
    std::optional< EdgeSpace > m_edge_space;
+   EdgeSampling m_edge_sampling{};
 
    /// internal tag-dispatch helpers
    struct node_tag {};
@@ -189,12 +436,51 @@ class GraphSpace:
       return _sample(batch_size, std::tuple{mask, mask}, FWD(args)...);
    }
 
+   void _sample_into(
+      value_type& out,
+      std::nullopt_t = std::nullopt,
+      size_t num_nodes = 10,
+      std::optional< size_t > num_edges = std::nullopt
+   ) const
+   {
+      _fill_instance(out, num_nodes, num_edges);
+   }
+
+   template <
+      typename size_or_range_t = size_t,
+      typename optional_size_or_forwardrange_t = std::optional< size_t > >
+   void _sample_into(
+      size_t batch_size,
+      batch_value_type& out,
+      std::nullopt_t = std::nullopt,
+      size_or_range_t&& num_nodes = 10,
+      optional_size_or_forwardrange_t&& num_edges = std::nullopt
+   ) const;
+
+   /// Fills a single graph instance in place, reusing the buffers it already holds wherever the
+   /// subspaces can sample into them. Without an edge space or a number of edges the instance has
+   /// no edges, as in `_sample`.
+   void
+   _fill_instance(value_type& instance, size_t num_nodes, std::optional< size_t > num_edges) const;
+
+   template < typename FeatureSpace, typename ArrayType, typename Tag >
+   void _sample_features_into(const FeatureSpace& space, size_t n, ArrayType& out, Tag tag) const
+   {
+      if constexpr(std::same_as< detail::batch_value_t< FeatureSpace >, ArrayType >) {
+         space.sample_into(n, out);
+      } else {
+         out = _slice_batch< ArrayType >(space.sample(n), 0, n, tag);
+      }
+   }
+
    [[nodiscard]] idx_xarray _sample_edge_links(size_t num_nodes, size_t num_edges) const
    {
       if(num_edges == 0) {
          return idx_xarray::from_shape({0});
       }
-      return xt::random::randint< size_t >({num_edges, 2ul}, size_t{0}, num_nodes, rng());
+      auto links = idx_xarray::from_shape({num_edges, 2ul});
+      detail::sample_edge_links(rng(), num_nodes, num_edges, m_edge_sampling, 0, links.data());
+      return links;
    }
 
    template < typename size_or_forwardrange_t >
@@ -252,7 +538,9 @@ GraphSpace< NodeSpace, EdgeSpace >::value_type GraphSpace< NodeSpace, EdgeSpace
             );
          }
       }),
-      .edge_links = _sample_edge_links(num_nodes, num_edges.value_or(0))
+      .edge_links = m_edge_space.has_value()
+                       ? _sample_edge_links(num_nodes, num_edges.value_or(0))
+                       : default_construct< idx_xarray >()
    };
 }
 
@@ -357,6 +645,110 @@ auto GraphSpace< NodeSpace, EdgeSpace >::_sample(
    }
 }
 
+template < typename NodeSpace, typename EdgeSpace >
+template < typename size_or_range_t, typename optional_size_or_forwardrange_t >
+void GraphSpace< NodeSpace, EdgeSpace >::_sample_into(
+   size_t batch_size,
+   batch_value_type& out,
+   std::nullopt_t,
+   size_or_range_t&& num_nodes,
+   optional_size_or_forwardrange_t&& num_edges
+) const
+{
+   out.resize(batch_size);
+   if(batch_size == 0) {
+      return;
+   }
+   auto [num_nodes_view, num_nodes_view_size] = _make_num_nodes_view(batch_size, FWD(num_nodes));
+   std::vector num_edges_vec = _make_num_edges_vec(batch_size, num_nodes_view, FWD(num_edges));
+   for(auto&& [instance, n_nodes, n_edges] : ranges::views::zip(out, num_nodes_view, num_edges_vec)
+   ) {
+      _fill_instance(instance, n_nodes, n_edges);
+   }
+}
+
+template < typename NodeSpace, typename EdgeSpace >
+template < typename size_or_range_t, typename optional_size_or_forwardrange_t >
+void GraphSpace< NodeSpace, EdgeSpace >::sample_packed_into(
+   size_t batch_size,
+   packed_batch_type& out,
+   size_or_range_t&& num_nodes,
+   optional_size_or_forwardrange_t&& num_edges
+) const
+{
+   const bool has_edge_space = m_edge_space.has_value();
+   out.node_offsets.assign(1, 0);
+   out.edge_offsets.assign(1, 0);
+   if(batch_size > 0) {
+      auto [num_nodes_view, num_nodes_view_size] = _make_num_nodes_view(
+         batch_size, FWD(num_nodes)
+      );
+      std::vector num_edges_vec = _make_num_edges_vec(batch_size, num_nodes_view, FWD(num_edges));
+      out.node_offsets.reserve(batch_size + 1);
+      out.edge_offsets.reserve(batch_size + 1);
+      for(auto&& [n_nodes, n_edges] : ranges::views::zip(num_nodes_view, num_edges_vec)) {
+         out.node_offsets.emplace_back(out.node_offsets.back() + n_nodes);
+         out.edge_offsets.emplace_back(out.edge_offsets.back() + (has_edge_space ? n_edges : 0));
+      }
+   }
+   const size_t total_nodes = out.node_offsets.back();
+   const size_t total_edges = out.edge_offsets.back();
+
+   out.graph_ids.resize(total_nodes);
+   for(size_t graph = 0; graph < out.size(); ++graph) {
+      std::fill(
+         std::next(out.graph_ids.begin(), static_cast< long >(out.node_offsets[graph])),
+         std::next(out.graph_ids.begin(), static_cast< long >(out.node_offsets[graph + 1])),
+         graph
+      );
+   }
+
+   _sample_features_into(m_node_space, total_nodes, out.nodes, node_tag{});
+   if(has_edge_space) {
+      _sample_features_into(*m_edge_space, total_edges, out.edges, edge_tag{});
+   } else {
+      out.edges = default_construct< typename packed_batch_type::instance_type::edge_array_type >();
+   }
+
+   out.edge_links.resize({total_edges, 2});
+   for(size_t graph = 0; graph < out.size(); ++graph) {
+      const size_t node_offset = out.node_offsets[graph];
+      detail::sample_edge_links(
+         rng(),
+         out.node_offsets[graph + 1] - node_offset,
+         out.edge_offsets[graph + 1] - out.edge_offsets[graph],
+         m_edge_sampling,
+         node_offset,
+         out.edge_links.data() + 2 * out.edge_offsets[graph]
+      );
+   }
+}
+
+template < typename NodeSpace, typename EdgeSpace >
+void GraphSpace< NodeSpace, EdgeSpace >::_fill_instance(
+   value_type& instance,
+   size_t num_nodes,
+   std::optional< size_t > num_edges
+) const
+{
+   _sample_features_into(m_node_space, num_nodes, instance.nodes, node_tag{});
+   if(not m_edge_space.has_value() or not num_edges.has_value()) {
+      instance.edges = default_construct< typename value_type::edge_array_type >();
+      instance.edge_links = default_construct< idx_xarray >();
+      return;
+   }
+   const size_t n_edges = *num_edges;
+   _sample_features_into(*m_edge_space, n_edges, instance.edges, edge_tag{});
+   if(n_edges == 0) {
+      instance.edge_links = idx_xarray::from_shape({0});
+   } else {
+      instance.edge_links.resize({n_edges, 2ul});
+      detail::sample_edge_links(
+         rng(), num_nodes, n_edges, m_edge_sampling, 0, instance.edge_links.data()
+      );
+   }
+}
+
 template < typename NodeSpace, typename EdgeSpace >
 template < typename ReturnType, typename BatchType, typename Tag >
 ReturnType GraphSpace< NodeSpace, EdgeSpace >::_slice_batch(
@@ -6,6 +6,7 @@
 #include <fmt/ranges.h>
 #include <spdlog/spdlog.h>
 
+#include <array>
 #include <concepts>
 #include <cstddef>
 #include <cstdint>
@@ -15,10 +16,12 @@
 #include <random>
 #include <range/v3/all.hpp>
 #include <ranges>
+#include <span>
 #include <stdexcept>
 #include <string>
 #include <tuple>
 #include <utility>
+#include <vector>
 #include <xtensor/xarray.hpp>
 #include <xtensor/xoperation.hpp>
 #include <xtensor/xrandom.hpp>
@@ -33,6 +36,57 @@
 
 namespace force {
 
+/// @brief A bit-packed batch of MultiBinarySpace values.
+///
+/// The entries of all samples are stored as one contiguous bit stream in row-major order, i.e.
+/// entry i of sample b is bit (b * bits_per_sample() + i) of the stream, and bit k of the stream
+/// is bit k % 64 of word k / 64. Bits past the end of the stream are zero.
+/// This takes an eighth of the memory of the int8 representation.
+class PackedMultiBinary {
+  public:
+   using word_type = uint64_t;
+   static constexpr size_t word_bits = 64;
+
+   PackedMultiBinary() = default;
+   /// A zeroed batch of `batch_size` samples of the given shape.
+   PackedMultiBinary(xt::svector< int > sample_shape, size_t batch_size);
+
+   /// Pack an array of zeros and ones (any non-zero entry counts as one). The array either has
+   /// `sample_shape` itself or a leading batch dimension in front of it.
+   [[nodiscard]] static PackedMultiBinary
+   pack(const xarray< int8_t >& values, xt::svector< int > sample_shape);
+
+   /// Unpack to the int8 representation. As with MultiBinarySpace::sample, a batch of one sample
+   /// has no leading batch dimension.
+   [[nodiscard]] xarray< int8_t > unpack() const;
+   void unpack_into(xarray< int8_t >& out) const;
+
+   void resize(xt::svector< int > sample_shape, size_t batch_size);
+
+   [[nodiscard]] const auto& sample_shape() const { return m_sample_shape; }
+   [[nodiscard]] size_t batch_size() const { return m_batch_size; }
+   [[nodiscard]] size_t bits_per_sample() const { return m_bits_per_sample; }
+   /// the total number of bits in the stream
+   [[nodiscard]] size_t size() const { return m_batch_size * m_bits_per_sample; }
+
+   [[nodiscard]] std::span< word_type > words() { return m_words; }
+   [[nodiscard]] std::span< const word_type > words() const { return m_words; }
+
+   [[nodiscard]] bool test(size_t batch_index, size_t flat_index) const
+   {
+      const size_t pos = batch_index * m_bits_per_sample + flat_index;
+      return (m_words[pos / word_bits] >> (pos % word_bits)) & word_type{1};
+   }
+
+   bool operator==(const PackedMultiBinary& rhs) const = default;
+
+  private:
+   xt::svector< int > m_sample_shape{};
+   size_t m_batch_size = 0;
+   size_t m_bits_per_sample = 0;
+   std::vector< word_type > m_words{};
+};
+
 class MultiBinarySpace: public Space< xarray< int8_t >, MultiBinarySpace > {
   public:
    friend class Space;
@@ -80,8 +134,46 @@ class MultiBinarySpace: public Space< xarray< int8_t >, MultiBinarySpace > {
 
    [[nodiscard]] std::string repr() const { return fmt::format("MultiBinary({})", shape()); }
 
+   /// @brief Sample `batch_size` values in bit-packed form.
+   ///
+   /// Every 64-bit draw of the generator provides 64 entries. Masks follow the convention of
+   /// `sample`: 0 and 1 fix an entry to that value, 2 leaves it random.
+   [[nodiscard]] PackedMultiBinary sample_packed(size_t batch_size = 1) const
+   {
+      PackedMultiBinary out;
+      sample_packed_into(batch_size, out);
+      return out;
+   }
+   [[nodiscard]] PackedMultiBinary sample_packed(size_t batch_size, const value_type& mask) const
+   {
+      PackedMultiBinary out;
+      sample_packed_into(batch_size, out, mask);
+      return out;
+   }
+
+   void sample_packed_into(size_t batch_size, PackedMultiBinary& out) const;
+   void sample_packed_into(size_t batch_size, PackedMultiBinary& out, const value_type& mask) const;
+
+   /// Pack a single value or a batch of values of this space.
+   [[nodiscard]] PackedMultiBinary pack(const value_type& values) const
+   {
+      return PackedMultiBinary::pack(values, shape());
+   }
+
   private:
-   [[nodiscard]] xt::svector< int > samples_shape(size_t batch_size) const;
+   /// The per-word masks a sample mask imposes on the bit stream. Since every sample occupies the
+   /// same number of bits, the masks repeat after lcm(bits per sample, 64) bits.
+   struct stream_mask {
+      /// the bits which are drawn randomly
+      std::vector< uint64_t > free;
+      /// the bits which are fixed to one
+      std::vector< uint64_t > ones;
+   };
+
+   [[nodiscard]] stream_mask _stream_mask(const value_type& mask) const;
+
+   /// Fill the bit stream of `out` with random bits, restricted by the optional mask.
+   void _fill_stream(PackedMultiBinary& out, const stream_mask* mask) const;
 
    [[nodiscard]] batch_value_type _sample(size_t batch_size, std::nullopt_t = std::nullopt) const;
 
@@ -93,6 +185,17 @@ class MultiBinarySpace: public Space< xarray< int8_t >, MultiBinarySpace > {
    }
    [[nodiscard]] batch_value_type _sample(const value_type& mask) const { return _sample(1, mask); }
 
+   void _sample_into(size_t batch_size, value_type& out, std::nullopt_t = std::nullopt) const;
+
+   void _sample_into(size_t batch_size, value_type& out, const value_type& mask) const;
+
+   void _sample_into(value_type& out, std::nullopt_t = std::nullopt) const
+   {
+      _sample_into(1, out);
+   }
+
+   void _sample_into(value_type& out, const value_type& mask) const { _sample_into(1, out, mask); }
+
    [[nodiscard]] bool _contains(const value_type& value) const
    {
       const auto& incoming_shape = value.shape();
@@ -109,8 +212,23 @@ class MultiBinarySpace: public Space< xarray< int8_t >, MultiBinarySpace > {
                 ),
                 [](auto pair) { return std::cmp_equal(std::get< 0 >(pair), std::get< 1 >(pair)); }
              )
-             and xt::all(xt::equal(value, 1) or xt::equal(value, 0));
+             and detail::all_in_bounds< true, true, data_type >(
+                std::span{value.data(), value.size()}, LOW, HIGH
+             );
+   }
+
+   [[nodiscard]] xarray< bool > _contains_batch(const value_type& batch) const
+   {
+      return base::_rows_in_shape_and_bounds(batch, LOW, HIGH);
    }
+
+   [[nodiscard]] bool _contains_all(const value_type& batch) const
+   {
+      return batch.dimension() == shape().size() + 1 and _contains(batch);
+   }
+
+   static constexpr std::array< data_type, 1 > LOW{0};
+   static constexpr std::array< data_type, 1 > HIGH{1};
 };
 
 }  // namespace force
@@ -6,23 +6,31 @@
 #include <fmt/ranges.h>
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
 #include <concepts>
+#include <cstdint>
 #include <iterator>
+#include <limits>
+#include <memory>
 #include <optional>
 #include <random>
 #include <range/v3/all.hpp>
 #include <ranges>
+#include <span>
 #include <stdexcept>
 #include <string>
 #include <tuple>
 #include <utility>
+#include <vector>
 #include <xtensor/xarray.hpp>
 #include <xtensor/xrandom.hpp>
 #include <xtensor/xstorage.hpp>
 
 #include "reinforce/spaces/concepts.hpp"
 #include "reinforce/spaces/space.hpp"
+#include "reinforce/utils/alias_table.hpp"
 #include "reinforce/utils/macro.hpp"
+#include "reinforce/utils/random.hpp"
 #include "reinforce/utils/type_traits.hpp"
 #include "reinforce/utils/utils.hpp"
 #include "reinforce/utils/xarray_formatter.hpp"
@@ -62,11 +70,38 @@ auto build_xarray(Array&& arr)
    return new_xarray;
 }
 
+/// Per-element masks are either boolean masks of the allowed values or (unnormalized)
+/// probabilities of every value.
+template < typename T >
+inline constexpr bool is_element_mask_v = false;
+
+template < typename U >
+   requires(std::same_as< U, bool > or std::floating_point< U >)
+inline constexpr bool is_element_mask_v< std::optional< xarray< U > > > = true;
+
 template < typename Rng >
 concept is_mask_range = std::ranges::range< Rng >
-                        and std::same_as<
-                           std::ranges::range_value_t< Rng >,
-                           std::optional< xarray< bool > > >;
+                        and is_element_mask_v< std::ranges::range_value_t< Rng > >;
+
+/// The per-element parameters of the flat MultiDiscreteSpace sampling kernel.
+///
+/// Every element draws an index uniformly below `bound`. Unmasked elements map it to
+/// `start + index`, boolean masks to the index-th allowed value and probability masks resolve it
+/// through their alias table first.
+template < typename T >
+struct multi_discrete_element {
+   T start;
+   uint64_t bound;
+   /// the rejection threshold of a 32-bit multiply-high reduction by `bound`
+   uint32_t threshold;
+   std::span< const T > values{};
+   const AliasTable* table = nullptr;
+};
+
+template < typename Rng >
+concept is_probability_mask_range = is_mask_range< Rng >
+                                    and std::floating_point< typename std::ranges::range_value_t<
+                                       Rng >::value_type::value_type >;
 
 }  // namespace detail
 
@@ -148,8 +183,14 @@ class MultiDiscreteSpace: public Space< xarray< T >, MultiDiscreteSpace< T > > {
    const auto& end() const { return m_end; }
 
   private:
+   using element_type = detail::multi_discrete_element< T >;
+
    value_type m_start;
    value_type m_end;
+   /// the unmasked sampling parameters of every element in row-major order
+   std::vector< element_type > m_elements;
+   /// whether every element's range fits into 32 bits, so that one draw serves two elements
+   bool m_ranges_fit_32bit = true;
 
    template < typename MaskRange = std::array< std::optional< xarray< bool > >, 0 > >
       requires detail::is_mask_range< MaskRange >
@@ -166,9 +207,68 @@ class MultiDiscreteSpace: public Space< xarray< T >, MultiDiscreteSpace< T > > {
       return _sample(batch_size);
    }
 
+   template < typename MaskRange = std::array< std::optional< xarray< bool > >, 0 > >
+      requires detail::is_mask_range< MaskRange >
+   void _sample_into(value_type& out, const MaskRange& mask_range = {}) const;
+
+   void _sample_into(value_type& out, std::nullopt_t /**/) const { _sample_into(out); }
+
+   template < typename MaskRange = std::array< std::optional< xarray< bool > >, 0 > >
+      requires detail::is_mask_range< MaskRange >
+   void _sample_into(size_t batch_size, value_type& out, const MaskRange& mask_range = {}) const;
+
+   void _sample_into(size_t batch_size, value_type& out, std::nullopt_t /**/) const
+   {
+      _sample_into(batch_size, out);
+   }
+
+   using bounds_tag = std::pair< typename base::InclusiveTag, typename base::ExclusiveTag >;
+
    [[nodiscard]] bool _contains(const value_type& value) const
    {
-      return base::_isin_shape_and_bounds(value, m_start, m_end);
+      return base::_isin_shape_and_bounds(value, m_start, m_end, bounds_tag{});
+   }
+
+   [[nodiscard]] xarray< bool > _contains_batch(const value_type& batch) const
+   {
+      return base::_rows_in_shape_and_bounds(batch, m_start, m_end, bounds_tag{});
+   }
+
+   [[nodiscard]] bool _contains_all(const value_type& batch) const
+   {
+      return batch.dimension() == shape().size() + 1 and _contains(batch);
+   }
+
+   /// Fill `out` linearly with consecutive samples of all elements in row-major order.
+   template < bool masked >
+   void _fill(std::span< T > out, std::span< const element_type > elements) const;
+
+   /// Apply the given per-element masks to a copy of the unmasked element parameters. The allowed
+   /// values and alias tables referenced by the masked elements are kept alive by the buffers.
+   template < typename MaskRange >
+   [[nodiscard]] std::vector< element_type > _masked_elements(
+      const MaskRange& mask_range,
+      std::vector< std::vector< T > >& values_buffer,
+      std::vector< std::shared_ptr< const AliasTable > >& table_buffer
+   ) const;
+
+   template < typename MaskRange >
+   void _sample_flat(std::span< T > out, const MaskRange& mask_range) const;
+
+   /// the (per-thread cached) alias table of the probability mask of one element
+   template < std::floating_point U >
+   [[nodiscard]] static std::shared_ptr< const AliasTable >
+   _alias_table(const xarray< U >& probabilities, T start, T end)
+   {
+      const auto n_values = static_cast< size_t >(end - start);
+      if(probabilities.size() != n_values) {
+         throw std::invalid_argument(fmt::format(
+            "Mask size ({}) does not match the number of elements ({})",
+            probabilities.size(),
+            n_values
+         ));
+      }
+      return detail::cached_alias_table(std::span{probabilities.data(), probabilities.size()});
    }
 };
 
@@ -216,6 +316,28 @@ MultiDiscreteSpace< T >::MultiDiscreteSpace(
          end_shape
       ));
    }
+   m_elements.reserve(m_start.size());
+   for(size_t i = 0; i < m_start.size(); ++i) {
+      const T start = m_start.data_element(i);
+      const T end = m_end.data_element(i);
+      if(end <= start) {
+         throw std::invalid_argument(fmt::format(
+            "'High' bounds have to be greater than 'Low' bounds. Given low {} and high {} at flat "
+            "index {}.",
+            start,
+            end,
+            i
+         ));
+      }
+      const auto bound = static_cast< uint64_t >(end - start);
+      m_ranges_fit_32bit = m_ranges_fit_32bit and bound <= std::numeric_limits< uint32_t >::max();
+      const auto bound32 = static_cast< uint32_t >(bound);
+      m_elements.push_back(
+         {.start = start,
+          .bound = bound,
+          .threshold = bound32 == 0 ? 0 : static_cast< uint32_t >((0u - bound32) % bound32)}
+      );
+   }
    SPDLOG_DEBUG(fmt::format("Bounds:\n{}", std::invoke([&] {
                                xarray< std::string > bounds = xt::empty< std::string >(shape());
                                for(auto [i, bound_string] : ranges::views::enumerate(
@@ -243,43 +365,30 @@ template < typename MaskRange >
 auto MultiDiscreteSpace< T >::_sample(size_t batch_size, const MaskRange& mask_range) const
    -> value_type
 {
-   switch(batch_size) {
-      case 0: {
-         return xt::empty< T >({0});
-      }
-      case 1: {
-         return xt::expand_dims(_sample(mask_range), 0);
-      }
-      default: {
-         xarray< T > samples = xt::empty< T >(prepend(shape(), static_cast< int >(batch_size)));
-         SPDLOG_DEBUG(fmt::format("Samples shape: {}", samples.shape()));
-
-         auto mask_iter = std::ranges::begin(mask_range),
-              mask_iter_end = std::ranges::end(mask_range);
-         for(auto&& [i, bounds] : ranges::views::enumerate(ranges::views::zip(m_start, m_end))) {
-            auto&& [start, end] = FWD(bounds);
-            // convert the flat index i to an indexing list for the given shape
-            auto coordinates = xt::unravel_index(static_cast< int >(i), shape());
-            // add all entries of the variate's access in the shape
-            // add all the sampling indices as if samples[:, ...] on a numpy array so that they can
-            // be emplaced all at once
-            auto index_stride = prepend(
-               xt::xstrided_slice_vector(coordinates.begin(), coordinates.end()), xt::all()
-            );
-            SPDLOG_DEBUG(fmt::format("Strides: {}", index_stride));
-            auto&& view = xt::strided_view(samples, index_stride);
-            if(mask_iter != mask_iter_end and mask_iter->has_value()) {
-               view = xt::random::choice(
-                  xt::eval(xt::filter(xt::arange(start, end), **mask_iter)), batch_size, true, rng()
-               );
-            } else {
-               view = xt::random::randint({batch_size}, start, end, rng());
-            }
-            std::ranges::advance(mask_iter, 1, mask_iter_end);
-         }
-         return samples;
-      }
+   value_type samples;
+   _sample_into(batch_size, samples, mask_range);
+   return samples;
+}
+
+template < typename T >
+   requires multidiscrete_reqs< T >
+template < typename MaskRange >
+   requires detail::is_mask_range< MaskRange >
+void MultiDiscreteSpace< T >::_sample_into(
+   size_t batch_size,
+   value_type& samples,
+   const MaskRange& mask_range
+) const
+{
+   if(batch_size == 0) {
+      samples = xt::empty< T >({0});
+      return;
    }
+   // resizing keeps the buffer whenever the number of elements does not change
+   samples.resize(prepend(shape(), static_cast< int >(batch_size)));
+   SPDLOG_DEBUG(fmt::format("Samples shape: {}", samples.shape()));
+   // the batch is row-major, so the samples are simply consecutive in memory
+   _sample_flat(std::span{samples.data(), samples.size()}, mask_range);
 }
 
 template < typename T >
@@ -288,25 +397,143 @@ template < typename MaskRange >
    requires detail::is_mask_range< MaskRange >
 auto MultiDiscreteSpace< T >::_sample(const MaskRange& mask_range) const -> value_type
 {
-   xarray< T > samples = xt::empty< T >(shape());
+   value_type samples;
+   _sample_into(samples, mask_range);
+   return samples;
+}
+
+template < typename T >
+   requires multidiscrete_reqs< T >
+template < typename MaskRange >
+   requires detail::is_mask_range< MaskRange >
+void MultiDiscreteSpace< T >::_sample_into(value_type& samples, const MaskRange& mask_range) const
+{
+   samples.resize(shape());
    SPDLOG_DEBUG(fmt::format("Samples shape: {}", samples.shape()));
+   _sample_flat(std::span{samples.data(), samples.size()}, mask_range);
+}
+
+template < typename T >
+   requires multidiscrete_reqs< T >
+template < typename MaskRange >
+void MultiDiscreteSpace< T >::_sample_flat(std::span< T > out, const MaskRange& mask_range) const
+{
+   if(std::ranges::empty(mask_range)) {
+      _fill< false >(out, m_elements);
+      return;
+   }
+   std::vector< std::vector< T > > values_buffer;
+   std::vector< std::shared_ptr< const AliasTable > > table_buffer;
+   _fill< true >(out, _masked_elements(mask_range, values_buffer, table_buffer));
+}
+
+template < typename T >
+   requires multidiscrete_reqs< T >
+template < typename MaskRange >
+auto MultiDiscreteSpace< T >::_masked_elements(
+   const MaskRange& mask_range,
+   std::vector< std::vector< T > >& values_buffer,
+   std::vector< std::shared_ptr< const AliasTable > >& table_buffer
+) const -> std::vector< element_type >
+{
+   auto elements = m_elements;
+   // no reallocation may happen after the spans into the buffer have been taken
+   values_buffer.reserve(elements.size());
+   auto mask_iter = std::ranges::begin(mask_range);
+   auto mask_end = std::ranges::end(mask_range);
+   for(size_t i = 0; i < elements.size() and mask_iter != mask_end; ++i, ++mask_iter) {
+      if(not mask_iter->has_value()) {
+         continue;
+      }
+      auto& element = elements[i];
+      const auto& mask = **mask_iter;
+      if constexpr(detail::is_probability_mask_range< MaskRange >) {
+         const auto& table = table_buffer.emplace_back(
+            _alias_table(mask, element.start, static_cast< T >(element.start + element.bound))
+         );
+         element.table = table.get();
+      } else {
+         if(mask.size() != static_cast< size_t >(element.bound)) {
+            throw std::invalid_argument(fmt::format(
+               "Mask size ({}) does not match the number of elements ({})",
+               mask.size(),
+               element.bound
+            ));
+         }
+         auto& values = values_buffer.emplace_back();
+         for(size_t index = 0; index < mask.size(); ++index) {
+            if(mask.data_element(index)) {
+               values.emplace_back(static_cast< T >(element.start + static_cast< T >(index)));
+            }
+         }
+         if(values.empty()) {
+            // nothing is allowed, so the element is fixed to its start value (as in gymnasium)
+            values.emplace_back(element.start);
+         }
+         element.values = values;
+         element.bound = values.size();
+      }
+      const auto bound32 = static_cast< uint32_t >(element.bound);
+      element.threshold = static_cast< uint32_t >((0u - bound32) % bound32);
+   }
+   return elements;
+}
 
-   auto mask_iter = std::ranges::begin(mask_range), mask_iter_end = std::ranges::end(mask_range);
-   for(auto&& [i, bounds] : ranges::views::enumerate(ranges::views::zip(m_start, m_end))) {
-      auto&& [start, end] = FWD(bounds);
-      samples.data_element(i) = std::invoke([&] {
-         if(mask_iter != mask_iter_end and mask_iter->has_value()) {
-            return xt::random::choice(
-                      xt::eval(xt::filter(xt::arange(start, end), **mask_iter)), 1, true, rng()
-            )
-               .unchecked(0);
-         } else {
-            return xt::random::randint({1}, start, end, rng()).unchecked(0);
+template < typename T >
+   requires multidiscrete_reqs< T >
+template < bool masked >
+void MultiDiscreteSpace< T >::_fill(std::span< T > out, std::span< const element_type > elements)
+   const
+{
+   auto& gen = rng();
+   const auto to_value = [&](const element_type& element, uint64_t index) -> T {
+      if constexpr(masked) {
+         if(element.table != nullptr) {
+            const auto resolved = element.table->resolve(gen, static_cast< size_t >(index));
+            return static_cast< T >(element.start + static_cast< T >(resolved));
          }
-      });
-      std::ranges::advance(mask_iter, 1, mask_iter_end);
+         if(not element.values.empty()) {
+            return element.values[index];
+         }
+      }
+      return static_cast< T >(element.start + static_cast< T >(index));
+   };
+
+   const size_t n_elements = elements.size();
+   if(not m_ranges_fit_32bit) {
+      for(size_t pos = 0; pos < out.size(); ++pos) {
+         const auto& element = elements[pos % n_elements];
+         out[pos] = to_value(element, detail::uniform_below(gen, element.bound));
+      }
+      return;
+   }
+   // Every 64-bit draw is split into two 32-bit halves, each of which is reduced to its element's
+   // range by a multiply-high. The rare biased draws are redrawn with the 64-bit reduction.
+   const auto draw_index = [&](const element_type& element, uint32_t bits) -> uint64_t {
+      const uint64_t product = uint64_t{bits} * element.bound;
+      if(static_cast< uint32_t >(product) < element.threshold) [[unlikely]] {
+         return detail::uniform_below(gen, element.bound);
+      }
+      return product >> 32;
+   };
+   size_t element_index = 0;
+   const auto next_element = [&]() -> const element_type& {
+      const auto& element = elements[element_index];
+      element_index = element_index + 1 == n_elements ? 0 : element_index + 1;
+      return element;
+   };
+   size_t pos = 0;
+   for(; pos + 1 < out.size(); pos += 2) {
+      const uint64_t bits = gen();
+      const auto& first = next_element();
+      const auto& second = next_element();
+      out[pos] = to_value(first, draw_index(first, static_cast< uint32_t >(bits)));
+      out[pos + 1] = to_value(second, draw_index(second, static_cast< uint32_t >(bits >> 32)));
+   }
+   if(pos < out.size()) {
+      const auto& last = next_element();
+      out[pos] = to_value(last, draw_index(last, static_cast< uint32_t >(gen())));
    }
-   return samples;
 }
 
 }  // namespace force
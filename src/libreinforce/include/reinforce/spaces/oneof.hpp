@@ -4,19 +4,119 @@
 
 #include <spdlog/spdlog.h>
 
+#include <array>
 #include <concepts>
 #include <cstddef>
+#include <cstdint>
 #include <reinforce/utils/tuple_utils.hpp>
+#include <span>
 #include <tuple>
 #include <variant>
-#include <xtensor/xaxis_iterator.hpp>
-#include <xtensor/xhistogram.hpp>
-#include <xtensor/xrandom.hpp>
+#include <vector>
+#include <xtensor/xstorage.hpp>
+#include <xtensor/xstrided_view.hpp>
 
 #include "reinforce/spaces/space.hpp"
+#include "reinforce/utils/indexed_iterator.hpp"
 #include "reinforce/utils/macro.hpp"
+#include "reinforce/utils/random.hpp"
 namespace force {
 
+namespace detail {
+
+/// Copy entry `index` of a batch sampled from a space with value type `Value`.
+template < typename Value, typename Batch >
+Value batch_entry(const Batch& batch, size_t index)
+{
+   if constexpr(is_xarray< Batch >) {
+      if constexpr(is_xarray< Value >) {
+         return xt::strided_view(batch, {index, xt::ellipsis()});
+      } else {
+         // the batch xarray merely holds the values like a std::vector would
+         return batch.flat(index);
+      }
+   } else {
+      return *std::next(std::ranges::begin(batch), static_cast< std::ptrdiff_t >(index));
+   }
+}
+
+/// Restore the leading axis of a batch of `count` samples of `space`.
+///
+/// Some spaces (e.g. MultiBinarySpace) return a batch of one sample without its batch axis, which
+/// `batch_entry` would otherwise index into as if it were there.
+template < typename Batch, typename SpaceT >
+void keep_batch_axis(Batch& batch, size_t count, const SpaceT& space)
+{
+   if constexpr(is_xarray< Batch > and is_xarray< value_t< SpaceT > >) {
+      const auto& value_shape = space.shape();
+      if(batch.dimension() != value_shape.size()) {
+         return;
+      }
+      xt::svector< size_t > batch_shape{count};
+      for(auto extent : value_shape) {
+         batch_shape.push_back(static_cast< size_t >(extent));
+      }
+      batch.reshape(batch_shape);
+   }
+}
+
+}  // namespace detail
+
+/// @brief A columnar batch of a OneOfSpace.
+///
+/// Every subspace keeps its samples in its own native batch. Sample i of the batch is entry
+/// `indices[i]` of the batch of subspace `tags[i]`. Elements are only assembled into the
+/// `std::pair< size_t, std::variant< ... > >` value type of the space when accessed.
+template < typename... Spaces >
+struct OneOfBatch {
+   using tag_type = std::conditional_t< (sizeof...(Spaces) <= 256), uint8_t, uint16_t >;
+   using value_type = std::pair< size_t, std::variant< detail::value_t< Spaces >... > >;
+   using const_iterator = detail::indexed_iterator< OneOfBatch >;
+
+   std::tuple< detail::batch_value_t< Spaces >... > batches{};
+   std::vector< tag_type > tags{};
+   std::vector< size_t > indices{};
+
+   [[nodiscard]] size_t size() const { return tags.size(); }
+   [[nodiscard]] bool empty() const { return tags.empty(); }
+
+   [[nodiscard]] value_type operator[](size_t index) const
+   {
+      return _entry_at< sizeof...(Spaces) - 1 >(tags[index], indices[index]);
+   }
+
+   [[nodiscard]] const_iterator begin() const { return {this, 0}; }
+   [[nodiscard]] const_iterator end() const { return {this, size()}; }
+
+   /// The batch as the vector of pairs that `OneOfSpace::sample(n)` returns.
+   [[nodiscard]] std::vector< value_type > unpack() const
+   {
+      return std::vector< value_type >(begin(), end());
+   }
+
+  private:
+   template < size_t I >
+   value_type _entry_at(size_t tag, size_t index) const
+   {
+      if(tag == I) {
+         using variant_type = std::variant_alternative_t< 1, value_type >;
+         using entry_type = std::variant_alternative_t< I, variant_type >;
+         return value_type{
+            I,
+            variant_type{
+               std::in_place_index< I >,
+               detail::batch_entry< entry_type >(std::get< I >(batches), index)
+            }
+         };
+      }
+      if constexpr(I == 0) {
+         throw std::runtime_error("Invalid space index");
+      } else {
+         return _entry_at< I - 1 >(tag, index);
+      }
+   }
+};
+
 template < typename... Spaces >
 class OneOfSpace:
     public Space<
@@ -34,6 +134,7 @@ class OneOfSpace:
       std::vector< std::pair< size_t, std::variant< detail::value_t< Spaces >... > > > >;
    using data_type = std::variant< typename Spaces::data_type... >;
    using value_variant_type = std::variant< detail::value_t< Spaces >... >;
+   using columnar_batch_type = OneOfBatch< Spaces... >;
    using typename base::value_type;
    using typename base::batch_value_type;
    using base::seed;
@@ -79,6 +180,18 @@ class OneOfSpace:
       );
    }
 
+   void enable_thread_streams(size_t n_threads)
+   {
+      base::enable_thread_streams(n_threads);
+      std::apply([&](auto&... spaces) { (spaces.enable_thread_streams(n_threads), ...); }, m_spaces);
+   }
+
+   void disable_thread_streams()
+   {
+      base::disable_thread_streams();
+      std::apply([](auto&... spaces) { (spaces.disable_thread_streams(), ...); }, m_spaces);
+   }
+
    bool operator==(const OneOfSpace& other) const
    {
       return std::invoke(
@@ -109,35 +222,65 @@ class OneOfSpace:
 
    [[nodiscard]] constexpr size_t size() const { return std::tuple_size_v< value_type >; }
 
-  private:
+   /// @brief Sample a batch without assembling the samples into pairs of index and variant.
+   ///
+   /// The subspace of every sample is drawn first, then each subspace samples all of its entries
+   /// in one batch with its mask of the mask tuple.
    template < typename MaskTuple >
       requires detail::is_specialization_v< detail::raw_t< MaskTuple >, std::tuple >
                and (std::tuple_size_v< detail::raw_t< MaskTuple > > == sizeof...(Spaces))
-   [[nodiscard]] batch_value_type _sample(size_t batch_size, MaskTuple&& mask_tuple) const
+   [[nodiscard]] columnar_batch_type
+   sample_columnar(size_t batch_size, MaskTuple&& mask_tuple) const
    {
-      // generate how many samples we need from each space
-      auto batch_size_per_space = xt::bincount(
-         xt::random::randint< size_t >({batch_size}, 0, sizeof...(Spaces), rng())
-      );
-      // sample now from each space with the corresponding mask as many times as the bincount says
-      // and stack the results together.
-      batch_value_type result;
-      result.reserve(batch_size);
+      columnar_batch_type out;
+      sample_columnar_into(batch_size, out, FWD(mask_tuple));
+      return out;
+   }
+   [[nodiscard]] columnar_batch_type sample_columnar(size_t batch_size) const
+   {
+      return sample_columnar(batch_size, create_tuple< sizeof...(Spaces) >(std::nullopt));
+   }
+
+   template < typename MaskTuple >
+      requires detail::is_specialization_v< detail::raw_t< MaskTuple >, std::tuple >
+               and (std::tuple_size_v< detail::raw_t< MaskTuple > > == sizeof...(Spaces))
+   void sample_columnar_into(size_t batch_size, columnar_batch_type& out, MaskTuple&& mask_tuple)
+      const
+   {
+      out.tags.resize(batch_size);
+      out.indices.resize(batch_size);
+      detail::uniform_below_fill(rng(), sizeof...(Spaces), std::span{out.tags});
+      // the position of every sample within the batch of its subspace
+      std::array< size_t, sizeof...(Spaces) > counts{};
+      for(size_t i = 0; i < batch_size; ++i) {
+         out.indices[i] = counts[out.tags[i]]++;
+      }
       std::invoke(
          [&]< size_t... Is >(std::index_sequence< Is... >) {
-            (static_cast< void >(_append_samples< Is >(
-                result,
-                std::get< Is >(m_spaces).sample(
-                   batch_size_per_space.at(Is), std::get< Is >(mask_tuple)
-                )
-             )),
+            ((std::get< Is >(out.batches) =
+                 std::get< Is >(m_spaces).sample(counts[Is], std::get< Is >(mask_tuple)),
+              detail::keep_batch_axis(
+                 std::get< Is >(out.batches), counts[Is], std::get< Is >(m_spaces)
+              )),
              ...);
          },
          spaces_idx_seq{}
       );
-      // shuffle the result vector to ensure that the individual samples are not grouped by space
-      ranges::shuffle(result, rng());
-      return result;
+   }
+   void sample_columnar_into(size_t batch_size, columnar_batch_type& out) const
+   {
+      sample_columnar_into(batch_size, out, create_tuple< sizeof...(Spaces) >(std::nullopt));
+   }
+
+  private:
+   template < typename MaskTuple >
+      requires detail::is_specialization_v< detail::raw_t< MaskTuple >, std::tuple >
+               and (std::tuple_size_v< detail::raw_t< MaskTuple > > == sizeof...(Spaces))
+   [[nodiscard]] batch_value_type _sample(size_t batch_size, MaskTuple&& mask_tuple) const
+   {
+      // the subspaces are drawn per sample, so the entries come out in random order without any
+      // shuffling
+      return sample_columnar(batch_size, FWD(mask_tuple)).unpack();
    }
 
    template < typename... MaskTs >
@@ -193,59 +336,77 @@ class OneOfSpace:
       return _sample(create_tuple< sizeof...(Spaces) >(std::nullopt));
    }
 
-   [[nodiscard]] bool _contains(const value_type& value) const
+   void _sample_into(value_type& out, std::nullopt_t = std::nullopt) const
    {
-      auto&& [space_idx, value_of_space] = value;
-      return visit(m_spaces, space_idx, [&]< typename SpaceT >(const SpaceT& space) {
-         return space.contains(value_of_space);
-      });
+      size_t space_idx = std::uniform_int_distribution< size_t >{0, sizeof...(Spaces) - 1}(rng());
+      _sample_into_space_at< sizeof...(Spaces) - 1 >(space_idx, out);
    }
 
-   decltype(auto) visit(auto&&... args) const
+   /// Each sample of the batch draws its own space, so no grouping and shuffling is necessary and
+   /// every element reuses the storage of the alternative it held before whenever possible.
+   void _sample_into(size_t batch_size, batch_value_type& out, std::nullopt_t = std::nullopt) const
    {
-#ifndef NDEBUG
-      return visit_at(FWD(args)...);
-#else
-      return visit_at_unchecked(FWD(args)...);
-#endif
+      out.resize(batch_size);
+      for(auto& sample : out) {
+         _sample_into(sample);
+      }
    }
 
-   template < size_t space_idx >
-   void _append_sample(batch_value_type& result, auto&& entry) const
+   template < size_t I >
+   void _sample_into_space_at(size_t space_idx, value_type& out) const
    {
-      result.emplace_back(
-         space_idx, value_variant_type{std::in_place_index< space_idx >, std::move(entry)}
-      );
-   };
-
-   template < size_t space_idx, typename Container >
-   void _append_samples(batch_value_type& result, Container&& samples) const
-   {
-      if constexpr(detail::is_xarray< detail::raw_t< Container > >) {
-         if constexpr(not detail::is_xarray< detail::value_t<
-                         std::tuple_element_t< space_idx, decltype(m_spaces) > > >) {
-            // if the space's value_type is not an xarray, but the batch_type is, then the batch
-            // xarray container is merely a holder like a std::vector would. We can thus disregard
-            // any nested xarray shapes we would preserve were we to sample according to e.g. the
-            // 0th axis. If we didn't do this we would get errors of impossible conversions from
-            // xt::strided_view to whatever the space's value type is, since axis_begin iterators
-            // would wrap contained values in a view type of shape {1}.
-            for(auto&& entry : FWD(samples)) {
-               _append_sample< space_idx >(result, FWD(entry));
-            }
-         } else {
-            for(auto entry_iter = xt::axis_begin(samples, 0);
-                entry_iter != xt::axis_end(samples, 0);
-                entry_iter++) {
-               _append_sample< space_idx >(result, *entry_iter);
-            }
+      if(space_idx == I) {
+         out.first = I;
+         if(out.second.index() != I) {
+            out.second.template emplace< I >();
          }
+         std::get< I >(m_spaces).sample_into(std::get< I >(out.second));
+         return;
+      }
+      if constexpr(I == 0) {
+         throw std::runtime_error("Invalid space index");
       } else {
-         for(auto&& entry : FWD(samples)) {
-            _append_sample< space_idx >(result, std::move(entry));
-         }
+         _sample_into_space_at< I - 1 >(space_idx, out);
+      }
+   }
+
+   [[nodiscard]] bool _contains(const value_type& value) const
+   {
+      return _contains_at< sizeof...(Spaces) - 1 >(value.first, value.second);
+   }
+
+   template < size_t I >
+   [[nodiscard]] bool _contains_at(size_t space_idx, const value_variant_type& value) const
+   {
+      if(space_idx == I) {
+         return value.index() == I and std::get< I >(m_spaces).contains(std::get< I >(value));
       }
-   };
+      if constexpr(I == 0) {
+         return false;
+      } else {
+         return _contains_at< I - 1 >(space_idx, value);
+      }
+   }
+
+   /// every subspace checks its sub-batch as a whole, the results are then gathered per sample
+   [[nodiscard]] xarray< bool > _contains_batch(const columnar_batch_type& batch) const
+   {
+      auto sub_batch_valid = std::invoke(
+         [&]< size_t... Is >(std::index_sequence< Is... >) {
+            return std::array< xarray< bool >, sizeof...(Spaces) >{
+               std::get< Is >(m_spaces).contains_batch(std::get< Is >(batch.batches))...
+            };
+         },
+         spaces_idx_seq{}
+      );
+      xarray< bool > valid = xarray< bool >::from_shape({batch.size()});
+      for(size_t i = 0; i < batch.size(); ++i) {
+         const size_t tag = batch.tags[i];
+         valid(i) = tag < sizeof...(Spaces) and batch.indices[i] < sub_batch_valid[tag].size()
+                    and sub_batch_valid[tag].flat(batch.indices[i]);
+      }
+      return valid;
+   }
 };
 
 }  // namespace force
@@ -4,6 +4,7 @@
 #include <fmt/core.h>
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
 #include <concepts>
 #include <cstddef>
 #include <cstdint>
@@ -28,6 +29,7 @@
 #include <xtensor/xrandom.hpp>
 #include <xtensor/xset_operation.hpp>
 #include <xtensor/xstorage.hpp>
+#include <xtensor/xstrided_view.hpp>
 
 #include "reinforce/spaces/space.hpp"
 #include "reinforce/utils/macro.hpp"
@@ -49,6 +51,106 @@ using stacked_value_type = std::conditional_t<
 
 }  // namespace detail
 
+/// @brief A batch of variable-length sequences stored as one flat buffer (a ragged array).
+///
+/// `values` is a single batch of the feature space holding the elements of all sequences back to
+/// back. Sequence i is formed by the entries [offsets[i], offsets[i + 1]) along its first axis.
+/// Values may be an xarray (sliced along axis 0) or a random-access container.
+template < typename Values >
+struct RaggedArray {
+   Values values{};
+   std::vector< size_t > offsets{0};
+
+   /// Pack a batch of separately stored sequences.
+   static RaggedArray pack(const std::vector< Values >& sequences)
+   {
+      RaggedArray ragged;
+      ragged.offsets.reserve(sequences.size() + 1);
+      for(const auto& sequence : sequences) {
+         ragged.offsets.emplace_back(ragged.offsets.back() + _length(sequence));
+      }
+      if constexpr(detail::is_xarray< Values >) {
+         if(not sequences.empty()) {
+            // empty sequences may come without their feature axes (e.g. of shape {0})
+            auto non_empty = std::ranges::find_if(sequences, [](const Values& sequence) {
+               return _length(sequence) > 0;
+            });
+            auto shape = (non_empty != sequences.end() ? *non_empty : sequences.front()).shape();
+            shape[0] = ragged.offsets.back();
+            ragged.values = Values::from_shape(shape);
+            for(size_t index = 0; index < sequences.size(); ++index) {
+               if(ragged.length(index) > 0) {
+                  ragged.row(index) = sequences[index];
+               }
+            }
+         }
+      } else {
+         ragged.values.reserve(ragged.offsets.back());
+         for(const auto& sequence : sequences) {
+            ragged.values.insert(ragged.values.end(), sequence.begin(), sequence.end());
+         }
+      }
+      return ragged;
+   }
+
+   [[nodiscard]] size_t size() const { return offsets.size() - 1; }
+   [[nodiscard]] size_t length(size_t index) const { return offsets[index + 1] - offsets[index]; }
+
+   /// A view of sequence `index` without copying.
+   [[nodiscard]] auto row(size_t index) const { return _row(values, index); }
+   [[nodiscard]] auto row(size_t index) { return _row(values, index); }
+
+   /// Copy sequence `index` into its own batch of the feature space.
+   [[nodiscard]] Values sequence(size_t index) const
+   {
+      if constexpr(detail::is_xarray< Values >) {
+         return row(index);
+      } else {
+         auto view = row(index);
+         return Values(view.begin(), view.end());
+      }
+   }
+
+   /// The batch of separately stored sequences, as `SequenceSpace::sample(n)` returns it.
+   [[nodiscard]] std::vector< Values > unpack() const
+   {
+      std::vector< Values > sequences;
+      sequences.reserve(size());
+      for(size_t index = 0; index < size(); ++index) {
+         sequences.emplace_back(sequence(index));
+      }
+      return sequences;
+   }
+
+   bool operator==(const RaggedArray& rhs) const = default;
+
+  private:
+   static size_t _length(const Values& sequence)
+   {
+      if constexpr(detail::is_xarray< Values >) {
+         return sequence.dimension() == 0 ? 0 : sequence.shape()[0];
+      } else {
+         return std::ranges::size(sequence);
+      }
+   }
+
+   template < typename Self >
+   auto _row(Self& self_values, size_t index) const
+   {
+      if constexpr(detail::is_xarray< Values >) {
+         return xt::strided_view(
+            self_values, {xt::range(offsets[index], offsets[index + 1]), xt::ellipsis()}
+         );
+      } else {
+         auto first = std::ranges::begin(self_values);
+         return std::ranges::subrange(
+            first + static_cast< std::ptrdiff_t >(offsets[index]),
+            first + static_cast< std::ptrdiff_t >(offsets[index + 1])
+         );
+      }
+   }
+};
+
 template < typename FeatureSpace, bool stacked = true >
 class SequenceSpace:
     public Space<
@@ -60,6 +162,11 @@ class SequenceSpace:
    static constexpr internal_tag_t internal_tag{};
 
    static constexpr bool _is_composite_space = true;
+   /// whether a single sequence has the type of a batch of the feature space and can therefore be
+   /// sampled in one call
+   static constexpr bool _is_feature_batch = std::same_as<
+      detail::stacked_value_type< FeatureSpace, stacked >,
+      typename FeatureSpace::batch_value_type >;
 
   public:
    friend class Space<
@@ -74,6 +181,7 @@ class SequenceSpace:
    using data_type = typename feature_space_type::data_type;
    using typename base::value_type;
    using typename base::batch_value_type;
+   using ragged_batch_type = RaggedArray< typename FeatureSpace::batch_value_type >;
    using base::seed;
    using base::shape;
    using base::rng;
@@ -115,6 +223,18 @@ class SequenceSpace:
       m_feature_space.seed(value);
    }
 
+   void enable_thread_streams(size_t n_threads)
+   {
+      base::enable_thread_streams(n_threads);
+      m_feature_space.enable_thread_streams(n_threads);
+   }
+
+   void disable_thread_streams()
+   {
+      base::disable_thread_streams();
+      m_feature_space.disable_thread_streams();
+   }
+
    bool operator==(const SequenceSpace& rhs) const = default;
 
    [[nodiscard]] std::string repr() const
@@ -124,6 +244,39 @@ class SequenceSpace:
 
    auto& feature_space() const { return m_feature_space; }
 
+   /// @brief Sample a batch of sequences into one flat buffer of feature elements.
+   ///
+   /// All lengths are drawn first, then the elements of every sequence come from a single batch
+   /// sample of the feature space. The mask tuple is the same as for `sample(batch_size, mask)`.
+   template < typename MaskT1 = std::nullopt_t, typename MaskT2 = std::nullopt_t >
+   [[nodiscard]] ragged_batch_type sample_ragged(
+      size_t batch_size,
+      const std::tuple< MaskT1, MaskT2 >& mask_tuple = std::tuple{std::nullopt, std::nullopt}
+   ) const
+   {
+      ragged_batch_type out;
+      sample_ragged_into(batch_size, out, mask_tuple);
+      return out;
+   }
+
+   template < typename MaskT1 = std::nullopt_t, typename MaskT2 = std::nullopt_t >
+   void sample_ragged_into(
+      size_t batch_size,
+      ragged_batch_type& out,
+      const std::tuple< MaskT1, MaskT2 >& mask_tuple = std::tuple{std::nullopt, std::nullopt}
+   ) const
+   {
+      auto&& [length_rng, feature_mask] = mask_tuple;
+      out.offsets.resize(batch_size + 1);
+      out.offsets[0] = 0;
+      size_t row = 0;
+      for(auto length : _lengths_sampler(batch_size, length_rng)) {
+         out.offsets[row + 1] = out.offsets[row] + static_cast< size_t >(length);
+         ++row;
+      }
+      out.values = m_feature_space.sample(out.offsets.back(), feature_mask);
+   }
+
   private:
    FeatureSpace m_feature_space;
    static constexpr double DEFAULT_GEOMETRIC_PROBABILITY = 0.25;
@@ -154,11 +307,77 @@ class SequenceSpace:
       return _sample(batch_size, std::tuple{std::nullopt, std::nullopt});
    }
 
+   void _sample_into(value_type& out, std::nullopt_t /*unused*/ = std::nullopt) const
+      requires(_is_feature_batch)
+   {
+      const size_t length = std::geometric_distribution< size_t >{m_geometric_prob}(rng());
+      m_feature_space.sample_into(length, out);
+      _keep_sequence_axis(out, length);
+   }
+
+   /// unstacked sequences are filled element-wise, reusing the storage of each element
+   void _sample_into(value_type& out, std::nullopt_t /*unused*/ = std::nullopt) const
+      requires(not stacked and not _is_feature_batch)
+   {
+      out.resize(std::geometric_distribution< size_t >{m_geometric_prob}(rng()));
+      for(auto& elem : out) {
+         m_feature_space.sample_into(elem);
+      }
+   }
+
+   void _sample_into(
+      size_t batch_size,
+      batch_value_type& out,
+      std::nullopt_t /*unused*/ = std::nullopt
+   ) const
+   {
+      out.resize(batch_size);
+      std::geometric_distribution< size_t > dist{m_geometric_prob};
+      for(auto& sub_batch : out) {
+         const size_t length = dist(rng());
+         m_feature_space.sample_into(length, sub_batch);
+         _keep_sequence_axis(sub_batch, length);
+      }
+   }
+
+   /// Some feature spaces (e.g. MultiBinarySpace) return a batch of one sample without its batch
+   /// axis and an empty batch as a flat array. A sequence keeps its sequence axis nonetheless.
+   template < typename Elements >
+   void _keep_sequence_axis(Elements& elements, size_t length) const
+   {
+      if constexpr(xt::is_xexpression< typename FeatureSpace::value_type >::value
+                   and xt::is_xexpression< Elements >::value) {
+         const auto& feature_shape = m_feature_space.shape();
+         if(elements.dimension() == feature_shape.size() + 1) {
+            return;
+         }
+         xt::svector< size_t > sequence_shape{length};
+         for(int extent : feature_shape) {
+            sequence_shape.push_back(static_cast< size_t >(extent));
+         }
+         elements.reshape(sequence_shape);
+      }
+   }
+
    [[nodiscard]] bool _contains(const value_type& value) const
    {
       return m_feature_space.contains(value);
    }
 
+   /// the elements of all sequences are checked in one batch of the feature space
+   [[nodiscard]] xarray< bool > _contains_batch(const ragged_batch_type& batch) const
+   {
+      const xarray< bool > element_valid = m_feature_space.contains_batch(batch.values);
+      xarray< bool > valid = xarray< bool >::from_shape({batch.size()});
+      const bool* flags = element_valid.data();
+      for(size_t row = 0; row < batch.size(); ++row) {
+         valid(row) = std::all_of(
+            flags + batch.offsets[row], flags + batch.offsets[row + 1], std::identity{}
+         );
+      }
+      return valid;
+   }
+
    template < typename Range >
    [[nodiscard]] auto _lengths_sampler(size_t batch_size, Range&& lengths_mask_range) const;
 };
@@ -168,13 +387,21 @@ auto SequenceSpace< FeatureSpace, stacked >::_sample(const std::tuple< MaskT1, M
 ) const -> value_type
 {
    auto&& [length_rng, feature_mask] = mask_tuple;
-   size_t minibatch_size = std::geometric_distribution< size_t >{m_geometric_prob}(rng());
-   constexpr auto concat = concatenate< feature_space_type >{};
-   return concat(
-      m_feature_space,
-      std::views::iota(0UL, minibatch_size)  //
-         | std::views::transform([&](auto) { return m_feature_space.sample(feature_mask); })
-   );
+   auto lengths = _lengths_sampler(1, length_rng);
+   const auto length = static_cast< size_t >(*ranges::begin(lengths));
+   if constexpr(_is_feature_batch) {
+      // the stacked sequence is exactly one batch of the feature space
+      auto elements = m_feature_space.sample(length, feature_mask);
+      _keep_sequence_axis(elements, length);
+      return elements;
+   } else {
+      constexpr auto concat = concatenate< feature_space_type >{};
+      return concat(
+         m_feature_space,
+         std::views::iota(0UL, length)  //
+            | std::views::transform([&](auto) { return m_feature_space.sample(feature_mask); })
+      );
+   }
 }
 
 // template implementations
@@ -199,7 +426,9 @@ auto SequenceSpace< FeatureSpace, stacked >::_sample(
    auto&& [length_rng, feature_mask] = mask_tuple;
    return _lengths_sampler(batch_size, FWD(length_rng))  //
           | ranges::views::transform([&](auto sub_batch_size) {
-               return m_feature_space.sample(sub_batch_size, feature_mask);
+               auto sub_batch = m_feature_space.sample(sub_batch_size, feature_mask);
+               _keep_sequence_axis(sub_batch, static_cast< size_t >(sub_batch_size));
+               return sub_batch;
             })
           | ranges::to_vector;
 }
@@ -232,10 +461,13 @@ auto SequenceSpace< FeatureSpace, stacked >::_lengths_sampler(
    } else {
       auto len_vec = ranges::to_vector(FWD(lengths_mask_range));
       size_t n = len_vec.size();
+      if(n == 0) {
+         throw std::invalid_argument("Expecting a non-empty range of lengths to sample from.");
+      }
       // sample with replacement from the length vector
       return ranges::views::indices(0ul, batch_size)
              | ranges::views::transform([&,
-                                         dist = std::uniform_int_distribution< size_t >{0, n},
+                                         dist = std::uniform_int_distribution< size_t >{0, n - 1},
                                          lens = std::move(len_vec)](auto&&) mutable {
                   return lens[dist(rng())];
                });
@@ -3,15 +3,21 @@
 
 #include <fmt/core.h>
 
+#include <algorithm>
 #include <concepts>
 #include <cstddef>
 #include <optional>
 #include <random>
+#include <span>
+#include <stdexcept>
 #include <tuple>
 #include <utility>
 #include <vector>
 #include <xtensor/xarray.hpp>
 
+#include "reinforce/utils/alias_table.hpp"
+#include "reinforce/utils/bitmask.hpp"
+#include "reinforce/utils/bounds.hpp"
 #include "reinforce/utils/exceptions.hpp"
 #include "reinforce/utils/macro.hpp"
 #include "reinforce/utils/type_traits.hpp"
@@ -69,7 +75,8 @@ class Space: public detail::rng_mixin {
    }
 
    template < typename MaskType = std::nullopt_t, typename... OtherArgs >
-   value_type sample(internal_tag_t, MaskType mask_arg = std::nullopt, OtherArgs&... args) const
+   value_type
+   sample(internal_tag_t, const MaskType& mask_arg = std::nullopt, OtherArgs&... args) const
    {
       if constexpr(requires(Derived derived) { derived._sample(mask_arg, FWD(args)...); }) {
          // derived has the necessary sample function, so call it
@@ -104,6 +111,18 @@ class Space: public detail::rng_mixin {
    // Randomly sample an element of this space
    value_type sample() const { return sample(internal_tag); }
 
+   /// @brief Sample with a caller-supplied generator instead of the space's own.
+   ///
+   /// The generator is used for the duration of the call by this space and all of its subspaces,
+   /// so a single const space can be shared between threads that each bring their own generator.
+   /// The remaining arguments are forwarded to the regular `sample` overloads.
+   template < typename... Args >
+   decltype(auto) sample(pcg64& generator, Args&&... args) const
+   {
+      detail::rng_override_guard guard{generator};
+      return sample(FWD(args)...);
+   }
+
    template < typename... OtherArgs >
    value_type sample(std::nullopt_t, OtherArgs&&... extra_args) const
    {
@@ -125,6 +144,18 @@ class Space: public detail::rng_mixin {
       return sample(internal_tag, mask, FWD(extra_args)...);
    }
 
+   template < typename... OtherArgs >
+   value_type sample(const BitMask& mask, OtherArgs&&... extra_args) const
+   {
+      return sample(internal_tag, mask, FWD(extra_args)...);
+   }
+
+   template < typename... OtherArgs >
+   value_type sample(const AliasTable& probabilities, OtherArgs&&... extra_args) const
+   {
+      return sample(internal_tag, probabilities, FWD(extra_args)...);
+   }
+
    template < typename U, typename... OtherArgs >
    value_type sample(
       const std::vector< std::optional< xarray< U > > >& mask_vec,
@@ -175,6 +206,17 @@ class Space: public detail::rng_mixin {
    {
       return sample(internal_tag, nr, mask, FWD(extra_args)...);
    }
+   template < typename... ExtraArgs >
+   batch_value_type sample(size_t nr, const BitMask& mask, ExtraArgs&&... extra_args) const
+   {
+      return sample(internal_tag, nr, mask, FWD(extra_args)...);
+   }
+   template < typename... ExtraArgs >
+   batch_value_type
+   sample(size_t nr, const AliasTable& probabilities, ExtraArgs&&... extra_args) const
+   {
+      return sample(internal_tag, nr, probabilities, FWD(extra_args)...);
+   }
    template < typename... TupleArgs, typename... ExtraArgs >
    batch_value_type
    sample(size_t nr, const std::tuple< TupleArgs... >& mask_tuple, ExtraArgs&&... extra_args) const
@@ -206,6 +248,46 @@ class Space: public detail::rng_mixin {
       return sample(internal_tag, nr, std::nullopt, FWD(extra_args)...);
    }
 
+   /// @brief Sample a single value into caller-provided storage.
+   ///
+   /// Spaces implementing `_sample_into` reuse the memory held by `out` and only reallocate if it
+   /// cannot hold the sample. All other spaces fall back to assigning a freshly sampled value.
+   /// Any further arguments (e.g. masks) are forwarded as in `sample`.
+   template < typename... Args >
+      requires(sizeof...(Args) == 0
+               or not std::same_as<
+                  batch_value_type,
+                  detail::raw_t< std::tuple_element_t< 0, std::tuple< Args... > > > >)
+   void sample_into(value_type& out, Args&&... args) const
+   {
+      if constexpr(requires(Derived derived) { derived._sample_into(out, FWD(args)...); }) {
+         derived()._sample_into(out, FWD(args)...);
+      } else {
+         out = sample(FWD(args)...);
+      }
+   }
+
+   /// @brief Sample a batch of `batch_size` values into caller-provided storage.
+   template < typename... Args >
+   void sample_into(size_t batch_size, batch_value_type& out, Args&&... args) const
+   {
+      if constexpr(requires(Derived derived) {
+                      derived._sample_into(batch_size, out, FWD(args)...);
+                   }) {
+         derived()._sample_into(batch_size, out, FWD(args)...);
+      } else {
+         out = sample(batch_size, FWD(args)...);
+      }
+   }
+
+   /// `sample_into` with a caller-supplied generator, see `sample(pcg64&, ...)`.
+   template < typename... Args >
+   void sample_into(pcg64& generator, Args&&... args) const
+   {
+      detail::rng_override_guard guard{generator};
+      sample_into(FWD(args)...);
+   }
+
    // Check if the value is a valid member of this space
    template < typename T >
    bool contains(const T& value) const
@@ -216,6 +298,41 @@ class Space: public detail::rng_mixin {
       return false;
    }
 
+   /// @brief Check every sample of a batch for membership.
+   ///
+   /// Returns one flag per sample (per entry of the first axis for array batches). Spaces over
+   /// arrays check the whole buffer in one sweep against the bounds, batches which are containers
+   /// of values are checked value by value.
+   template < typename T >
+   xarray< bool > contains_batch(const T& batch) const
+   {
+      if constexpr(requires(const Derived derived) { derived._contains_batch(batch); }) {
+         return derived()._contains_batch(batch);
+      } else if constexpr(not detail::is_xarray< T > and std::ranges::sized_range< const T >) {
+         xarray< bool > valid = xarray< bool >::from_shape({std::ranges::size(batch)});
+         size_t index = 0;
+         for(const auto& value : batch) {
+            valid(index++) = contains(value);
+         }
+         return valid;
+      } else {
+         static_assert(detail::always_false_v< T >, "No 'contains_batch' for this batch type.");
+      }
+   }
+
+   /// Whether all samples of the batch are members of the space, stopping at the first invalid one.
+   template < typename T >
+   bool contains_all(const T& batch) const
+   {
+      if constexpr(requires(const Derived derived) { derived._contains_all(batch); }) {
+         return derived()._contains_all(batch);
+      } else if constexpr(not detail::is_xarray< T > and std::ranges::sized_range< const T >) {
+         return std::ranges::all_of(batch, [&](const auto& value) { return contains(value); });
+      } else {
+         return xt::all(contains_batch(batch));
+      }
+   }
+
    template < typename BatchValueT >
       requires std::same_as< batch_value_type, detail::raw_t< BatchValueT > >
    value_type batch_to_value_type(BatchValueT&& batch) const
@@ -286,6 +403,58 @@ class Space: public detail::rng_mixin {
       BoundaryTag /*boundary_tag*/ = {}
    ) const;
 
+   /// @brief The per-sample counterpart of `_isin_shape_and_bounds` for a batch of shape (n, ...).
+   ///
+   /// @throws std::invalid_argument if the batch is not of the shape of the space prefixed by the
+   /// batch dimension.
+   template <
+      typename DType,
+      std::ranges::range Rng1 = std::initializer_list< DType >,
+      std::ranges::range Rng2 = std::initializer_list< DType >,
+      typename BoundaryTag = InclusiveTag >
+      requires(std::floating_point< DType > or std::integral< DType >)
+   xarray< bool > _rows_in_shape_and_bounds(
+      const xarray< DType >& batch,
+      const Rng1& low_boundary,
+      const Rng2& high_boundary,
+      BoundaryTag /*boundary_tag*/ = {}
+   ) const;
+
+   /// whether the lower (end = 0) or upper (end = 1) boundary is included under the tag
+   template < typename BoundaryTag, size_t end >
+   static constexpr bool _is_inclusive()
+   {
+      using namespace detail;
+      if constexpr(std::same_as< BoundaryTag, InclusiveTag >) {
+         return true;
+      } else if constexpr(std::same_as< BoundaryTag, ExclusiveTag >) {
+         return false;
+      } else {
+         static_assert(
+            is_any_v< std::tuple_element_t< 0, BoundaryTag >, InclusiveTag, ExclusiveTag >
+               and is_any_v< std::tuple_element_t< 1, BoundaryTag >, InclusiveTag, ExclusiveTag >,
+            "Boundary Tag has to be either ExlcusiveTag, InclusiveTag, or a 2-arity pair-like of "
+            "these."
+         );
+         return std::same_as< std::tuple_element_t< end, BoundaryTag >, InclusiveTag >;
+      }
+   }
+
+   /// A contiguous view of the boundaries, copied into `storage` only if they are not contiguous
+   /// values of the right type already.
+   template < typename DType, typename Rng >
+   static std::span< const DType > _bounds_span(const Rng& bounds, std::vector< DType >& storage)
+   {
+      if constexpr(requires {
+                      { std::ranges::data(bounds) } -> std::convertible_to< const DType* >;
+                   }) {
+         return {std::ranges::data(bounds), std::ranges::size(bounds)};
+      } else {
+         storage.assign(std::ranges::begin(bounds), std::ranges::end(bounds));
+         return storage;
+      }
+   }
+
   private:
    xt::svector< int > m_shape;
 
@@ -303,83 +472,56 @@ bool Space< Value, Derived, BatchValue, runtime_sample_throw >::_isin_shape_and_
    BoundaryTag
 ) const
 {
-   using namespace ranges;
-   using namespace detail;
-   if constexpr(is_none_v< BoundaryTag, InclusiveTag, ExclusiveTag >) {
-      static_assert(
-         is_any_v< std::tuple_element_t< 0, BoundaryTag >, InclusiveTag, ExclusiveTag >
-            and is_any_v< std::tuple_element_t< 1, BoundaryTag >, InclusiveTag, ExclusiveTag >,
-         "Boundary Tag has to be either ExlcusiveTag, InclusiveTag, or a 2-arity pair-like of "
-         "these."
-      );
-   }
    const auto& incoming_shape = values.shape();
-   const auto& incoming_dim = incoming_shape.size();
+   const auto incoming_dim = incoming_shape.size();
    const auto space_dim = shape().size();
 
    if(incoming_dim < space_dim or space_dim + 1 < incoming_dim) {
       return false;
    }
-
-   auto enum_bounds_view = views::enumerate(views::zip(low_boundary, high_boundary));
-   if(incoming_dim == space_dim + 1) {
-      // first dim assumed a batch size
-      if(not ranges::equal(shape(), incoming_shape | ranges::views::drop(1))) {
-         return false;
-      }
-      return ranges::any_of(enum_bounds_view, [&](const auto& idx_low_high) {
-         const auto& [i, low_high] = idx_low_high;
-         const auto& [low, high] = low_high;
-         auto coordinates = xt::unravel_index(static_cast< int >(i), shape());
-         const auto& vals = xt::strided_view(
-            values,
-            prepend(xt::xstrided_slice_vector(coordinates.begin(), coordinates.end()), xt::all())
-         );
-         constexpr auto compare =
-            []< typename Comp, typename CompEq >(Comp cmp, CompEq cmp_eq, auto&&... args) {
-               if constexpr(std::same_as< BoundaryTag, InclusiveTag >) {
-                  return cmp_eq(FWD(args)...);
-               } else if constexpr(std::same_as< BoundaryTag, ExclusiveTag >) {
-                  return cmp(FWD(args)...);
-               } else if constexpr(std::same_as<
-                                      std::tuple_element_t< 0, BoundaryTag >,
-                                      InclusiveTag >) {
-                  return cmp_eq(FWD(args)...);
-               } else {
-                  return cmp(FWD(args)...);
-               }
-            };
-         return xt::all(
-            compare(AS_LAMBDA(xt::greater), AS_LAMBDA(xt::greater_equal), vals, low)
-            and compare(AS_LAMBDA(xt::less), AS_LAMBDA(xt::less_equal), vals, high)
-         );
-      });
-   }
-   // we now know that shape().size() == incoming_shape.size()
-   if(not ranges::equal(shape(), incoming_shape)) {
+   // with one more dimension than the space, the first one is the batch size
+   if(not ranges::equal(shape(), incoming_shape | ranges::views::drop(incoming_dim - space_dim))) {
       return false;
    }
-   return ranges::any_of(enum_bounds_view, [&](const auto& idx_low_high) {
-      const auto& [i, low_high] = idx_low_high;
-      const auto& [low, high] = low_high;
-      auto coordinates = xt::unravel_index(static_cast< int >(i), shape());
-      const auto& val = values.element(coordinates.begin(), coordinates.end());
-      constexpr auto compare = []< typename Cmp, typename CmpEq >(
-                                  Cmp cmp, CmpEq cmp_eq, auto&&... args
-                               ) {
-         if constexpr(std::same_as< BoundaryTag, InclusiveTag >) {
-            return cmp_eq(FWD(args)...);
-         } else if constexpr(std::same_as< BoundaryTag, ExclusiveTag >) {
-            return cmp(FWD(args)...);
-         } else if constexpr(std::same_as< std::tuple_element_t< 0, BoundaryTag >, InclusiveTag >) {
-            return cmp_eq(FWD(args)...);
-         } else {
-            return cmp(FWD(args)...);
-         }
-      };
-      return compare(std::greater{}, std::greater_equal{}, val, low)
-             and compare(std::less{}, std::less_equal{}, val, high);
-   });
+   std::vector< DType > low_storage;
+   std::vector< DType > high_storage;
+   return detail::all_in_bounds<
+      _is_inclusive< BoundaryTag, 0 >(),
+      _is_inclusive< BoundaryTag, 1 >(),
+      DType >(
+      std::span{values.data(), values.size()},
+      _bounds_span(low_boundary, low_storage),
+      _bounds_span(high_boundary, high_storage)
+   );
+}
+
+template < typename Value, typename Derived, typename BatchValue, bool runtime_sample_throw >
+template < typename DType, std::ranges::range Rng1, std::ranges::range Rng2, typename BoundaryTag >
+   requires(std::floating_point< DType > or std::integral< DType >)
+xarray< bool > Space< Value, Derived, BatchValue, runtime_sample_throw >::_rows_in_shape_and_bounds(
+   const xarray< DType >& batch,
+   const Rng1& low_boundary,
+   const Rng2& high_boundary,
+   BoundaryTag
+) const
+{
+   const auto& batch_shape = batch.shape();
+   if(batch_shape.size() != shape().size() + 1
+      or not ranges::equal(shape(), batch_shape | ranges::views::drop(1))) {
+      throw std::invalid_argument(
+         "The batch has to be of the shape of the space with a leading batch dimension."
+      );
+   }
+   xarray< bool > valid = xarray< bool >::from_shape({batch_shape[0]});
+   std::vector< DType > low_storage;
+   std::vector< DType > high_storage;
+   detail::rows_in_bounds< _is_inclusive< BoundaryTag, 0 >(), _is_inclusive< BoundaryTag, 1 >() >(
+      std::span< const DType >{batch.data(), batch.size()},
+      _bounds_span(low_boundary, low_storage),
+      _bounds_span(high_boundary, high_storage),
+      std::span{valid.data(), valid.size()}
+   );
+   return valid;
 }
 
 namespace detail {
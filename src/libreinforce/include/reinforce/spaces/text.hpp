@@ -5,6 +5,7 @@
 #include <fmt/core.h>
 #include <spdlog/spdlog.h>
 
+#include <compare>
 #include <concepts>
 #include <cstddef>
 #include <cstdint>
@@ -13,13 +14,14 @@
 #include <optional>
 #include <range/v3/all.hpp>
 #include <range/v3/iterator/traits.hpp>
+#include <ranges>
 #include <reinforce/utils/xtensor_extension.hpp>
+#include <span>
 #include <stdexcept>
 #include <string>
 #include <string_view>
 #include <tuple>
 #include <type_traits>
-#include <unordered_map>
 #include <variant>
 #include <vector>
 #include <xtensor/xadapt.hpp>
@@ -28,6 +30,8 @@
 #include <xtensor/xset_operation.hpp>
 #include <xtensor/xstorage.hpp>
 
+#include "reinforce/utils/charset.hpp"
+#include "reinforce/utils/indexed_iterator.hpp"
 #include "reinforce/utils/macro.hpp"
 #include "reinforce/utils/type_traits.hpp"
 #include "reinforce/utils/utils.hpp"
@@ -38,6 +42,82 @@
 
 namespace force {
 
+/// @brief A batch of strings stored in one contiguous character buffer (as in Apache Arrow).
+///
+/// String i spans the characters [offsets()[i], offsets()[i + 1]) of `chars()`. The strings are
+/// handed out as views into the buffer, so neither filling nor iterating a batch allocates once
+/// the buffers have grown to size.
+class TextBatch {
+  public:
+   using const_iterator = detail::indexed_iterator< TextBatch >;
+
+   TextBatch() = default;
+
+   template < std::ranges::input_range Rng >
+      requires std::convertible_to< std::ranges::range_reference_t< Rng >, std::string_view >
+   explicit TextBatch(const Rng& strings)
+   {
+      for(auto&& str : strings) {
+         push_back(str);
+      }
+   }
+
+   [[nodiscard]] size_t size() const { return m_offsets.size() - 1; }
+   [[nodiscard]] bool empty() const { return size() == 0; }
+
+   [[nodiscard]] std::string_view operator[](size_t index) const
+   {
+      return std::string_view{m_chars}.substr(
+         m_offsets[index], m_offsets[index + 1] - m_offsets[index]
+      );
+   }
+   [[nodiscard]] std::string_view at(size_t index) const
+   {
+      if(index >= size()) {
+         throw std::out_of_range(
+            fmt::format("Index {} out of range for a batch of size {}.", index, size())
+         );
+      }
+      return (*this)[index];
+   }
+
+   [[nodiscard]] const_iterator begin() const { return {this, 0}; }
+   [[nodiscard]] const_iterator end() const { return {this, size()}; }
+
+   void push_back(std::string_view str)
+   {
+      m_chars.append(str);
+      m_offsets.emplace_back(m_chars.size());
+   }
+   /// Remove all strings, keeping the allocated buffers.
+   void clear()
+   {
+      m_chars.clear();
+      m_offsets.resize(1);
+   }
+   void reserve(size_t nr_strings, size_t nr_chars)
+   {
+      m_offsets.reserve(nr_strings + 1);
+      m_chars.reserve(nr_chars);
+   }
+
+   [[nodiscard]] const std::string& chars() const { return m_chars; }
+   [[nodiscard]] std::span< const size_t > offsets() const { return m_offsets; }
+
+   [[nodiscard]] std::vector< std::string > to_strings() const
+   {
+      return std::vector< std::string >(begin(), end());
+   }
+
+   bool operator==(const TextBatch& rhs) const = default;
+
+  private:
+   friend class TextSpace;
+
+   std::string m_chars{};
+   std::vector< size_t > m_offsets{0};
+};
+
 class TextSpace: public Space< std::string, TextSpace, std::vector< std::string > > {
    /// Hidden Options class to allow for designated initializers simplifying the init of TextSpace.
    /// Without options there would be overlaps e.g. between seed and max/min-length parameters.
@@ -68,7 +148,7 @@ class TextSpace: public Space< std::string, TextSpace, std::vector< std::string
    {
       if(not opts.characters.empty()) {
          m_chars = xt::adapt(opts.characters, xt::svector{opts.characters.size()});
-         m_charmap = make_charmap(m_chars);
+         m_charset = CharsetTable{opts.characters};
       }
    }
    template < std::convertible_to< size_t > T >
@@ -89,17 +169,20 @@ class TextSpace: public Space< std::string, TextSpace, std::vector< std::string
    }
 
    [[nodiscard]] std::string_view characters() const { return {m_chars.begin(), m_chars.end()}; }
-   [[nodiscard]] long character_index(char chr) const
-   {
-      auto handle = m_charmap.find(chr);
-      bool is_contained = handle != m_charmap.end();
-      return -1 * static_cast< long >(not is_contained)
-             + static_cast< long >(handle->second) * static_cast< long >(is_contained);
-   }
+   [[nodiscard]] long character_index(char chr) const { return m_charset.index(chr); }
 
    [[nodiscard]] auto max_length() const { return m_max_length; }
    [[nodiscard]] auto min_length() const { return m_min_length; }
 
+   /// Sample `batch_size` strings into a single character buffer, see TextBatch.
+   [[nodiscard]] TextBatch sample_columnar(size_t batch_size) const
+   {
+      TextBatch batch;
+      sample_columnar_into(batch_size, batch);
+      return batch;
+   }
+   void sample_columnar_into(size_t batch_size, TextBatch& out) const;
+
   private:
    constexpr static char
       default_characters[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
@@ -107,7 +190,7 @@ class TextSpace: public Space< std::string, TextSpace, std::vector< std::string
    size_t m_max_length;
    size_t m_min_length = 1;
    xarray< char > m_chars = _default_chars();
-   std::unordered_map< char, size_t > m_charmap = _default_charmap();
+   CharsetTable m_charset = _default_charset();
 
    struct internal_tag_t {};
    static constexpr internal_tag_t internal_tag{};
@@ -147,20 +230,45 @@ class TextSpace: public Space< std::string, TextSpace, std::vector< std::string
       return _sample(internal_tag, batch_size, {});
    }
 
-   [[nodiscard]] bool _contains(const value_type& value) const
+   value_type _sample(std::nullopt_t = std::nullopt) const
+   {
+      value_type sample;
+      _sample_into(sample);
+      return sample;
+   }
+
+   /// Fills the string in place. Its capacity is reused, so repeated sampling into the same string
+   /// only allocates when a longer sample than any before is drawn.
+   void _sample_into(value_type& out, std::nullopt_t = std::nullopt) const;
+
+   /// Fills the batch in place, reusing both the vector and the capacity of each contained string.
+   void _sample_into(size_t batch_size, batch_value_type& out, std::nullopt_t = std::nullopt) const;
+
+   /// std::string values are checked through their conversion to std::string_view
+   [[nodiscard]] bool _contains(std::string_view value) const
    {
       return value.size() >= m_min_length and value.size() <= m_max_length
-             and ranges::all_of(value, [&](char chr) { return ranges::contains(m_chars, chr); });
+             and m_charset.contains_all(value);
+   }
+   [[nodiscard]] bool _contains_all(const TextBatch& batch) const { return _contains(batch); }
+   [[nodiscard]] bool _contains(const TextBatch& batch) const
+   {
+      // the characters are validated in one pass over the whole buffer
+      return std::ranges::all_of(
+                batch,
+                [&](std::string_view str) {
+                   return str.size() >= m_min_length and str.size() <= m_max_length;
+                }
+             )
+             and m_charset.contains_all(batch.chars());
    }
 
    template < typename SizeOrRangeT >
    [[nodiscard]] xarray< size_t >
    _compute_lengths(size_t batch_size, const SizeOrRangeT* lengths_ptr) const;
 
-   static std::unordered_map< char, size_t > make_charmap(const xarray< char >& chars);
-
    static const xarray< char >& _default_chars();
-   static const std::unordered_map< char, size_t >& _default_charmap();
+   static const CharsetTable& _default_charset();
 };
 
 // template implementations
@@ -79,6 +79,18 @@ class TupleSpace:
       );
    }
 
+   void enable_thread_streams(size_t n_threads)
+   {
+      base::enable_thread_streams(n_threads);
+      std::apply([&](auto&... spaces) { (spaces.enable_thread_streams(n_threads), ...); }, m_spaces);
+   }
+
+   void disable_thread_streams()
+   {
+      base::disable_thread_streams();
+      std::apply([](auto&... spaces) { (spaces.disable_thread_streams(), ...); }, m_spaces);
+   }
+
    bool operator==(const TupleSpace& other) const
    {
       return std::invoke(
@@ -175,6 +187,59 @@ class TupleSpace:
       return _sample(create_tuple< sizeof...(Spaces) >(std::nullopt));
    }
 
+   /// the subspaces fill their entries of the output tuple in place
+   template < typename MaskTuple >
+      requires detail::is_specialization_v< detail::raw_t< MaskTuple >, std::tuple >
+               and (std::tuple_size_v< detail::raw_t< MaskTuple > > == sizeof...(Spaces))
+   void _sample_into(value_type& out, MaskTuple&& mask_tuple) const
+   {
+      std::invoke(
+         [&]< size_t... Is >(std::index_sequence< Is... >) {
+            (std::get< Is >(m_spaces).sample_into(
+                std::get< Is >(out), std::get< Is >(FWD(mask_tuple))
+             ),
+             ...);
+         },
+         spaces_idx_seq{}
+      );
+   }
+
+   void _sample_into(value_type& out, std::nullopt_t = std::nullopt) const
+   {
+      std::invoke(
+         [&]< size_t... Is >(std::index_sequence< Is... >) {
+            (std::get< Is >(m_spaces).sample_into(std::get< Is >(out)), ...);
+         },
+         spaces_idx_seq{}
+      );
+   }
+
+   template < typename MaskTuple >
+      requires detail::is_specialization_v< detail::raw_t< MaskTuple >, std::tuple >
+               and (std::tuple_size_v< detail::raw_t< MaskTuple > > == sizeof...(Spaces))
+   void _sample_into(size_t batch_size, batch_value_type& out, MaskTuple&& mask_tuple) const
+   {
+      std::invoke(
+         [&]< size_t... Is >(std::index_sequence< Is... >) {
+            (std::get< Is >(m_spaces).sample_into(
+                batch_size, std::get< Is >(out), std::get< Is >(FWD(mask_tuple))
+             ),
+             ...);
+         },
+         spaces_idx_seq{}
+      );
+   }
+
+   void _sample_into(size_t batch_size, batch_value_type& out, std::nullopt_t = std::nullopt) const
+   {
+      std::invoke(
+         [&]< size_t... Is >(std::index_sequence< Is... >) {
+            (std::get< Is >(m_spaces).sample_into(batch_size, std::get< Is >(out)), ...);
+         },
+         spaces_idx_seq{}
+      );
+   }
+
    [[nodiscard]] bool _contains(const value_type& value) const
    {
       return std::invoke(
@@ -184,6 +249,27 @@ class TupleSpace:
          spaces_idx_seq{}
       );
    }
+
+   /// a sample of the batch is valid if its entry in every sub-batch is
+   [[nodiscard]] xarray< bool > _contains_batch(const batch_value_type& batch) const
+   {
+      return std::invoke(
+         [&]< size_t... Is >(std::index_sequence< Is... >) -> xarray< bool > {
+            return (std::get< Is >(m_spaces).contains_batch(std::get< Is >(batch)) && ...);
+         },
+         spaces_idx_seq{}
+      );
+   }
+
+   [[nodiscard]] bool _contains_all(const batch_value_type& batch) const
+   {
+      return std::invoke(
+         [&]< size_t... Is >(std::index_sequence< Is... >) {
+            return (std::get< Is >(m_spaces).contains_all(std::get< Is >(batch)) && ...);
+         },
+         spaces_idx_seq{}
+      );
+   }
 };
 
 }  // namespace force
@@ -0,0 +1,109 @@
+#ifndef REINFORCE_UTILS_ALIAS_TABLE_HPP
+#define REINFORCE_UTILS_ALIAS_TABLE_HPP
+
+#include <fmt/format.h>
+
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "reinforce/utils/random.hpp"
+
+namespace force {
+
+/// @brief Vose's alias table for drawing indices from a fixed discrete distribution.
+///
+/// Construction is O(n). Every draw afterwards costs two random numbers: one picks a column
+/// uniformly, the other decides between the column and its alias.
+/// Probabilities need not be normalized, but have to be finite, non-negative and sum to a positive
+/// value. Indices with zero probability are never drawn.
+class AliasTable {
+  public:
+   AliasTable() = default;
+
+   template < std::ranges::forward_range Rng >
+      requires std::floating_point< std::ranges::range_value_t< Rng > >
+   explicit AliasTable(const Rng& probabilities)
+   {
+      std::vector< double > weights;
+      if constexpr(std::ranges::sized_range< Rng >) {
+         weights.reserve(std::ranges::size(probabilities));
+      }
+      for(auto prob : probabilities) {
+         weights.emplace_back(static_cast< double >(prob));
+      }
+      _build(weights);
+   }
+
+   [[nodiscard]] size_t size() const { return m_threshold.size(); }
+
+   template < detail::full_range_64bit_generator Generator >
+   [[nodiscard]] size_t sample(Generator& gen) const
+   {
+      return resolve(gen, static_cast< size_t >(detail::uniform_below(gen, size())));
+   }
+
+   /// The second half of a draw: decide between a uniformly drawn `column` and its alias.
+   template < detail::full_range_64bit_generator Generator >
+   [[nodiscard]] size_t resolve(Generator& gen, size_t column) const
+   {
+      return gen() < m_threshold[column] ? column : m_alias[column];
+   }
+
+   /// Fill `out` with `offset + index` for independently drawn indices.
+   template < detail::full_range_64bit_generator Generator, typename T >
+   void sample_fill(Generator& gen, std::span< T > out, T offset = T{0}) const
+   {
+      // draw all columns in bulk first, then resolve the aliases
+      detail::uniform_below_fill(gen, size(), out, T{0});
+      for(auto& value : out) {
+         const auto column = static_cast< size_t >(value);
+         value = static_cast< T >(offset + static_cast< T >(resolve(gen, column)));
+      }
+   }
+
+   bool operator==(const AliasTable& rhs) const = default;
+
+  private:
+   /// the acceptance probability of each column, scaled to [0, 2^64)
+   std::vector< uint64_t > m_threshold{};
+   std::vector< size_t > m_alias{};
+
+   void _build(std::span< const double > weights);
+};
+
+namespace detail {
+
+/// @brief The alias table for the given probabilities from a small thread-local cache.
+///
+/// Entries are keyed by a hash of the probabilities and verified against an exact copy, so a
+/// policy sampling repeatedly with the same distribution builds the table only once per thread.
+std::shared_ptr< const AliasTable > cached_alias_table(std::span< const double > probabilities);
+
+template < std::ranges::contiguous_range Rng >
+   requires std::floating_point< std::ranges::range_value_t< Rng > >
+std::shared_ptr< const AliasTable > cached_alias_table(const Rng& probabilities)
+{
+   if constexpr(std::same_as< std::ranges::range_value_t< Rng >, double >) {
+      return cached_alias_table(
+         std::span< const double >{std::ranges::data(probabilities), std::ranges::size(probabilities)}
+      );
+   } else {
+      thread_local std::vector< double > converted;
+      converted.assign(std::ranges::begin(probabilities), std::ranges::end(probabilities));
+      return cached_alias_table(std::span< const double >{converted});
+   }
+}
+
+}  // namespace detail
+
+}  // namespace force
+
+#endif  // REINFORCE_UTILS_ALIAS_TABLE_HPP
@@ -0,0 +1,152 @@
+#ifndef REINFORCE_UTILS_BITMASK_HPP
+#define REINFORCE_UTILS_BITMASK_HPP
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#if defined(__BMI2__)
+   #include <immintrin.h>
+#endif
+
+#include "reinforce/utils/type_traits.hpp"
+#include "reinforce/utils/xtensor_typedefs.hpp"
+
+namespace force {
+
+namespace detail {
+
+/// Position of the k-th (0-based) set bit of `word`. `k` has to be smaller than popcount(word).
+inline unsigned select_in_word(uint64_t word, unsigned k)
+{
+#if defined(__BMI2__)
+   return static_cast< unsigned >(std::countr_zero(_pdep_u64(uint64_t{1} << k, word)));
+#else
+   unsigned offset = 0;
+   // skip whole bytes first, then clear the remaining lower set bits
+   for(auto byte_count = static_cast< unsigned >(std::popcount(word & 0xFFu)); k >= byte_count;
+       byte_count = static_cast< unsigned >(std::popcount(word & 0xFFu))) {
+      k -= byte_count;
+      word >>= 8;
+      offset += 8;
+   }
+   for(; k > 0; --k) {
+      word &= word - 1;
+   }
+   return offset + static_cast< unsigned >(std::countr_zero(word));
+#endif
+}
+
+}  // namespace detail
+
+/// @brief A packed bitset mask over the values of a discrete set.
+///
+/// Alongside the bits the mask keeps the cumulative popcount of the words preceding each word.
+/// This makes `rank` a constant time operation and `select` (the position of the k-th set bit) a
+/// binary search over size / 64 entries plus an in-word select. Drawing uniformly among the
+/// allowed values therefore costs one bounded random number and one `select`.
+class BitMask {
+  public:
+   using word_type = uint64_t;
+   static constexpr size_t word_bits = 64;
+
+   BitMask() = default;
+   explicit BitMask(size_t size, bool value = false);
+
+   /// Fast conversion from byte-sized masks, e.g. xarray<bool> or xarray<int8_t>. Every non-zero
+   /// entry sets its bit.
+   template < std::integral T >
+      requires(sizeof(T) == 1)
+   explicit BitMask(const xarray< T >& mask)
+       : BitMask(from_bytes(reinterpret_cast< const uint8_t* >(mask.data()), mask.size()))
+   {
+   }
+
+   /// Conversion from any sized range of values convertible to bool.
+   template < std::ranges::input_range Rng >
+      requires std::convertible_to< std::ranges::range_reference_t< Rng >, bool >
+   [[nodiscard]] static BitMask from_range(Rng&& range);
+
+   [[nodiscard]] static BitMask from_bytes(const uint8_t* data, size_t size);
+
+   [[nodiscard]] size_t size() const { return m_size; }
+   [[nodiscard]] size_t count() const { return m_cumulative.back(); }
+   [[nodiscard]] bool none() const { return count() == 0; }
+   [[nodiscard]] bool all() const { return count() == m_size; }
+
+   [[nodiscard]] bool test(size_t pos) const
+   {
+      return (m_words[pos / word_bits] >> (pos % word_bits)) & word_type{1};
+   }
+   [[nodiscard]] bool operator[](size_t pos) const { return test(pos); }
+
+   void set(size_t pos, bool value = true);
+   void reset(size_t pos) { set(pos, false); }
+
+   /// the number of set bits in [0, pos)
+   [[nodiscard]] size_t rank(size_t pos) const
+   {
+      const size_t word = pos / word_bits;
+      const size_t bit = pos % word_bits;
+      if(bit == 0) {
+         return m_cumulative[word];
+      }
+      return m_cumulative[word]
+             + static_cast< size_t >(std::popcount(m_words[word] << (word_bits - bit)));
+   }
+
+   /// the position of the k-th (0-based) set bit. `k` has to be smaller than `count()`.
+   [[nodiscard]] size_t select(size_t k) const
+   {
+      auto word_iter = std::upper_bound(m_cumulative.begin(), m_cumulative.end(), k) - 1;
+      auto word = static_cast< size_t >(std::distance(m_cumulative.begin(), word_iter));
+      return word * word_bits
+             + detail::select_in_word(m_words[word], static_cast< unsigned >(k - *word_iter));
+   }
+
+   [[nodiscard]] std::span< const word_type > words() const { return m_words; }
+
+   bool operator==(const BitMask& rhs) const
+   {
+      return m_size == rhs.m_size and m_words == rhs.m_words;
+   }
+
+  private:
+   size_t m_size = 0;
+   std::vector< word_type > m_words{};
+   /// m_cumulative[w] holds the number of set bits in all words before word w
+   std::vector< size_t > m_cumulative{0};
+
+   void _build_directory();
+};
+
+template < std::ranges::input_range Rng >
+   requires std::convertible_to< std::ranges::range_reference_t< Rng >, bool >
+BitMask BitMask::from_range(Rng&& range)
+{
+   BitMask mask;
+   size_t pos = 0;
+   for(auto&& value : range) {
+      if(pos % word_bits == 0) {
+         mask.m_words.emplace_back(0);
+      }
+      mask.m_words.back() |= static_cast< word_type >(static_cast< bool >(value))
+                             << (pos % word_bits);
+      ++pos;
+   }
+   mask.m_size = pos;
+   mask._build_directory();
+   return mask;
+}
+
+}  // namespace force
+
+#endif  // REINFORCE_UTILS_BITMASK_HPP
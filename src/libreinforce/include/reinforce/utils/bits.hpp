@@ -0,0 +1,83 @@
+#ifndef REINFORCE_UTILS_BITS_HPP
+#define REINFORCE_UTILS_BITS_HPP
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__BMI2__)
+   #include <immintrin.h>
+#endif
+
+namespace force::detail {
+
+/// Pack 8 bytes into 8 bits, bit i being set iff byte i is non-zero.
+inline uint8_t pack_8_bytes(uint64_t bytes)
+{
+   constexpr uint64_t lsb_per_byte = 0x0101010101010101u;
+   // fold every byte onto its lowest bit. Bits shifted in from the next byte only land in
+   // positions which are never folded back into bit 0.
+   bytes |= bytes >> 4;
+   bytes |= bytes >> 2;
+   bytes |= bytes >> 1;
+   bytes &= lsb_per_byte;
+#if defined(__BMI2__)
+   return static_cast< uint8_t >(_pext_u64(bytes, lsb_per_byte));
+#else
+   // the multiplication moves bit 8i to bit 56 + i without any carries
+   return static_cast< uint8_t >((bytes * 0x0102040810204080u) >> 56);
+#endif
+}
+
+/// Expand 8 bits into 8 bytes, byte i being 1 iff bit i is set and 0 otherwise.
+inline uint64_t unpack_8_bits(uint8_t bits)
+{
+   constexpr uint64_t lsb_per_byte = 0x0101010101010101u;
+#if defined(__BMI2__)
+   return _pdep_u64(bits, lsb_per_byte);
+#else
+   // broadcast the bits to every byte, keep bit i in byte i and move it down to bit 0. The
+   // addition cannot carry across bytes since every byte holds at most 0x80.
+   const uint64_t isolated = (bits * lsb_per_byte) & 0x8040201008040201u;
+   return ((isolated + 0x7F7F7F7F7F7F7F7Fu) >> 7) & lsb_per_byte;
+#endif
+}
+
+/// Pack `size` bytes into the bits of `words`, which have to be zeroed and hold at least `size`
+/// bits. Bit i of the stream lands in bit i % 64 of word i / 64.
+inline void pack_bytes(const uint8_t* data, size_t size, uint64_t* words)
+{
+   size_t pos = 0;
+   for(; pos + 8 <= size; pos += 8) {
+      uint64_t bytes = 0;
+      std::memcpy(&bytes, data + pos, sizeof(bytes));
+      if constexpr(std::endian::native == std::endian::big) {
+         bytes = __builtin_bswap64(bytes);
+      }
+      words[pos / 64] |= uint64_t{pack_8_bytes(bytes)} << (pos % 64);
+   }
+   for(; pos < size; ++pos) {
+      words[pos / 64] |= uint64_t{data[pos] != 0} << (pos % 64);
+   }
+}
+
+/// The inverse of `pack_bytes`: write the first `size` bits of `words` as bytes of 0 or 1.
+inline void unpack_bits(const uint64_t* words, size_t size, uint8_t* data)
+{
+   size_t pos = 0;
+   for(; pos + 8 <= size; pos += 8) {
+      uint64_t bytes = unpack_8_bits(static_cast< uint8_t >(words[pos / 64] >> (pos % 64)));
+      if constexpr(std::endian::native == std::endian::big) {
+         bytes = __builtin_bswap64(bytes);
+      }
+      std::memcpy(data + pos, &bytes, sizeof(bytes));
+   }
+   for(; pos < size; ++pos) {
+      data[pos] = static_cast< uint8_t >((words[pos / 64] >> (pos % 64)) & 1u);
+   }
+}
+
+}  // namespace force::detail
+
+#endif  // REINFORCE_UTILS_BITS_HPP
@@ -0,0 +1,101 @@
+#ifndef REINFORCE_UTILS_BOUNDS_HPP
+#define REINFORCE_UTILS_BOUNDS_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <span>
+
+namespace force::detail {
+
+template < bool low_inclusive, bool high_inclusive, typename T >
+inline bool in_bounds(T value, T low, T high)
+{
+   // non-short-circuiting, so that loops over these checks stay branch free and vectorize
+   bool above = low_inclusive ? value >= low : value > low;
+   bool below = high_inclusive ? value <= high : value < high;
+   return above & below;
+}
+
+/// @brief Check the rows of a row-major array against element-wise bounds.
+///
+/// `values` holds `out.size()` rows of equal length. `low` and `high` hold either one bound per
+/// element of a row or a single bound shared by all elements. `out[r]` is set to whether every
+/// element of row r lies within its bounds. NaNs are never within bounds.
+template < bool low_inclusive, bool high_inclusive, typename T >
+void rows_in_bounds(
+   std::span< const T > values,
+   std::span< const T > low,
+   std::span< const T > high,
+   std::span< bool > out
+)
+{
+   const size_t nr_rows = out.size();
+   if(nr_rows == 0) {
+      return;
+   }
+   const size_t row_size = values.size() / nr_rows;
+   if(row_size == 1) {
+      const T lo = low[0];
+      const T hi = high[0];
+      for(size_t row = 0; row < nr_rows; ++row) {
+         out[row] = in_bounds< low_inclusive, high_inclusive >(values[row], lo, hi);
+      }
+      return;
+   }
+   const bool shared_bounds = low.size() == 1;
+   for(size_t row = 0; row < nr_rows; ++row) {
+      const T* row_values = values.data() + row * row_size;
+      bool valid = true;
+      if(shared_bounds) {
+         for(size_t elem = 0; elem < row_size; ++elem) {
+            valid &= in_bounds< low_inclusive, high_inclusive >(row_values[elem], low[0], high[0]);
+         }
+      } else {
+         for(size_t elem = 0; elem < row_size; ++elem) {
+            valid &= in_bounds< low_inclusive, high_inclusive >(
+               row_values[elem], low[elem], high[elem]
+            );
+         }
+      }
+      out[row] = valid;
+   }
+}
+
+/// @brief Whether all values lie within the (element-wise or shared) bounds.
+///
+/// `values` is a sequence of rows of `low.size()` elements, or of arbitrary elements if the bounds
+/// are shared. The sweep runs in branch free blocks and stops after the first block holding an
+/// invalid value.
+template < bool low_inclusive, bool high_inclusive, typename T >
+bool all_in_bounds(std::span< const T > values, std::span< const T > low, std::span< const T > high)
+{
+   constexpr size_t block_size = 1024;
+   const size_t row_size = low.size();
+   // blocks consist of whole rows, so that every block starts at the first bound
+   const size_t block = row_size >= block_size ? row_size : block_size / row_size * row_size;
+   for(size_t start = 0; start < values.size(); start += block) {
+      const size_t end = std::min(values.size(), start + block);
+      bool valid = true;
+      if(row_size == 1) {
+         for(size_t pos = start; pos < end; ++pos) {
+            valid &= in_bounds< low_inclusive, high_inclusive >(values[pos], low[0], high[0]);
+         }
+      } else {
+         for(size_t row = start; row < end; row += row_size) {
+            for(size_t elem = 0; elem < row_size; ++elem) {
+               valid &= in_bounds< low_inclusive, high_inclusive >(
+                  values[row + elem], low[elem], high[elem]
+               );
+            }
+         }
+      }
+      if(not valid) {
+         return false;
+      }
+   }
+   return true;
+}
+
+}  // namespace force::detail
+
+#endif  // REINFORCE_UTILS_BOUNDS_HPP
@@ -0,0 +1,45 @@
+#ifndef REINFORCE_UTILS_CHARSET_HPP
+#define REINFORCE_UTILS_CHARSET_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace force {
+
+/// @brief Constant time membership and index lookup for a set of characters.
+///
+/// A 256-entry table maps every byte value to the position of its first occurrence in the
+/// character list (or -1). For validating whole strings the set is additionally stored as a
+/// nibble-indexed bitmap, which lets SSSE3/AVX2 builds check 16 or 32 characters per step with
+/// byte shuffles.
+class CharsetTable {
+  public:
+   CharsetTable() { m_index.fill(-1); }
+   explicit CharsetTable(std::string_view characters);
+
+   [[nodiscard]] bool contains(char chr) const { return m_index[_byte(chr)] >= 0; }
+   /// the position of `chr` in the character list or -1 if it is not part of the set
+   [[nodiscard]] long index(char chr) const { return m_index[_byte(chr)]; }
+
+   /// whether every character of `text` is part of the set
+   [[nodiscard]] bool contains_all(std::string_view text) const;
+
+   bool operator==(const CharsetTable& rhs) const = default;
+
+  private:
+   std::array< int32_t, 256 > m_index{};
+   /// bit h of entry l is set iff the character (h << 4) | l is in the set, for h < 8
+   std::array< uint8_t, 16 > m_lower_rows{};
+   /// the same for the upper half of byte values, i.e. bit h - 8 for h >= 8
+   std::array< uint8_t, 16 > m_upper_rows{};
+
+   static size_t _byte(char chr) { return static_cast< unsigned char >(chr); }
+
+   [[nodiscard]] bool _contains_all_scalar(std::string_view text) const;
+};
+
+}  // namespace force
+
+#endif  // REINFORCE_UTILS_CHARSET_HPP
@@ -5,6 +5,10 @@
 #include <array>
 #include <concepts>
 #include <cstddef>
+#include <functional>
+#include <ranges>
+#include <tuple>
+#include <utility>
 #include <vector>
 #include <xtensor/xarray.hpp>
 #include <xtensor/xslice.hpp>
@@ -134,14 +138,7 @@ struct concatenate< Space > {
 /// Concatenates range of tuples to a single tuple with individually
 /// concatenated value types as concatenation goes for each subspace
 template < typename Space >
-   requires(detail::is_space_like< Space >
-            and requires(Space space) {
-                   Space::is_composite_space;  // has this member
-                   requires Space::is_composite_space;  // member must be true
-                   typename Space::spaces_tuple_type;  // has this member
-                }
-            and std::same_as< Space, TupleSpace< typename Space::spaces_tuple_type > >
-   )
+   requires(detail::is_space_like< Space > and detail::is_specialization_v< Space, TupleSpace >)
 struct concatenate< Space > {
    using space_type = Space;
    using value_type = detail::value_t< Space >;
@@ -159,11 +156,11 @@ struct concatenate< Space > {
                   value_type >
    batch_value_type operator()(const space_type& space, ValueRange&& items) const
    {
-      constexpr auto concat = concatenate{};
+      constexpr auto concat = concatenate< void >{};
       return std::invoke(
          [&]< size_t... Is >(std::index_sequence< Is... >) {
-            return std::tuple{
-               concat(std::get< Is >(space.m_spaces), std::views::elements< Is >(items))...
+            return batch_value_type{
+               concat(space.template get< Is >(), std::views::elements< Is >(items))...
             };
          },
          spaces_idx_seq
@@ -174,17 +171,43 @@ struct concatenate< Space > {
    batch_value_type& operator()(const space_type& space, ValueRange&& items, batch_value_type& out)
       const
    {
-      constexpr auto concat = concatenate{};
-      return std::invoke(
+      constexpr auto concat = concatenate< void >{};
+      std::invoke(
          [&]< size_t... Is >(std::index_sequence< Is... >) {
-            return std::tuple{concat(
-               std::get< Is >(space.m_spaces),
-               std::views::elements< Is >(items),
-               std::get< Is >(out)
-            )...};
+            (concat(
+                space.template get< Is >(), std::views::elements< Is >(items), std::get< Is >(out)
+             ),
+             ...);
          },
          spaces_idx_seq
       );
+      return out;
+   }
+};
+
+/// @brief Specialization for DictSpace.
+///
+/// Concatenates the subspaces' values as for the underlying TupleSpace and keys the result.
+template < typename Space >
+   requires(detail::is_space_like< Space > and detail::is_specialization_v< Space, DictSpace >)
+struct concatenate< Space > {
+   using space_type = Space;
+   using value_type = detail::value_t< Space >;
+   using batch_value_type = detail::batch_value_t< Space >;
+   using data_type = detail::data_t< Space >;
+   using result_type = batch_value_type;
+
+   template < std::ranges::sized_range ValueRange >
+   batch_value_type operator()(const space_type& space, ValueRange&& items) const
+   {
+      return batch_value_type{concatenate< void >{}(space.spaces(), FWD(items))};
+   }
+   template < std::ranges::sized_range ValueRange >
+   batch_value_type& operator()(const space_type& space, ValueRange&& items, batch_value_type& out)
+      const
+   {
+      concatenate< void >{}(space.spaces(), FWD(items), out.as_tuple());
+      return out;
    }
 };
 
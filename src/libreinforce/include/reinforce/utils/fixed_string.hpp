@@ -0,0 +1,87 @@
+#ifndef REINFORCE_UTILS_FIXED_STRING_HPP
+#define REINFORCE_UTILS_FIXED_STRING_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <string_view>
+#include <utility>
+
+namespace force {
+
+/// @brief A string literal usable as a template argument, e.g. `entry< "position" >(space)`.
+template < size_t N >
+struct fixed_string {
+   char value[N]{};
+
+   constexpr fixed_string(const char (&str)[N]) { std::copy_n(str, N, value); }
+
+   [[nodiscard]] constexpr size_t size() const { return N - 1; }
+   [[nodiscard]] constexpr std::string_view view() const { return {value, N - 1}; }
+   constexpr operator std::string_view() const { return view(); }
+
+   template < size_t M >
+   constexpr bool operator==(const fixed_string< M >& other) const
+   {
+      return view() == other.view();
+   }
+};
+
+/// @brief A compile-time list of distinct keys.
+///
+/// The index of a key is resolved at compile time with `index_of< key >`. For keys only known at
+/// runtime (e.g. names coming from bindings) `find` searches a table of the keys sorted at compile
+/// time.
+template < fixed_string... Keys >
+struct key_list {
+   static constexpr size_t size = sizeof...(Keys);
+   static constexpr std::array< std::string_view, size > names{Keys.view()...};
+
+  private:
+   static constexpr auto _sorted_table()
+   {
+      std::array< std::pair< std::string_view, size_t >, size > table{};
+      for(size_t i = 0; i < size; ++i) {
+         table[i] = {names[i], i};
+      }
+      std::ranges::sort(table);
+      return table;
+   }
+
+  public:
+   /// (name, index) pairs sorted by name
+   static constexpr auto sorted_table = _sorted_table();
+
+   static_assert(
+      std::ranges::adjacent_find(
+         sorted_table, [](const auto& lhs, const auto& rhs) { return lhs.first == rhs.first; }
+      )
+         == sorted_table.end(),
+      "The keys have to be unique."
+   );
+
+   template < fixed_string Key >
+   static constexpr bool contains = ((Key == Keys) or ...);
+
+   template < fixed_string Key >
+      requires contains< Key >
+   static constexpr auto index_of = static_cast< size_t >(
+      std::ranges::find(names, Key.view()) - names.begin()
+   );
+
+   static constexpr std::optional< size_t > find(std::string_view key)
+   {
+      const auto entry = std::ranges::lower_bound(
+         sorted_table, key, {}, [](const auto& pair) { return pair.first; }
+      );
+      if(entry == sorted_table.end() or entry->first != key) {
+         return std::nullopt;
+      }
+      return entry->second;
+   }
+};
+
+}  // namespace force
+
+#endif  // REINFORCE_UTILS_FIXED_STRING_HPP
@@ -0,0 +1,95 @@
+#ifndef REINFORCE_UTILS_INDEXED_ITERATOR_HPP
+#define REINFORCE_UTILS_INDEXED_ITERATOR_HPP
+
+#include <compare>
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+namespace force::detail {
+
+/// @brief A random access iterator yielding `container[index]` by value.
+///
+/// Used by the columnar batch types, whose elements are assembled on access from several buffers
+/// and therefore cannot be handed out by reference.
+template < typename Container >
+class indexed_iterator {
+  public:
+   using iterator_category = std::random_access_iterator_tag;
+   using reference = decltype(std::declval< const Container& >()[size_t{}]);
+   using value_type = std::remove_cvref_t< reference >;
+   using difference_type = std::ptrdiff_t;
+
+   indexed_iterator() = default;
+   indexed_iterator(const Container* container, size_t index)
+       : m_container(container), m_index(index)
+   {
+   }
+
+   reference operator*() const { return (*m_container)[m_index]; }
+   reference operator[](difference_type offset) const { return *(*this + offset); }
+
+   indexed_iterator& operator++()
+   {
+      ++m_index;
+      return *this;
+   }
+   indexed_iterator operator++(int)
+   {
+      auto copy = *this;
+      ++m_index;
+      return copy;
+   }
+   indexed_iterator& operator--()
+   {
+      --m_index;
+      return *this;
+   }
+   indexed_iterator operator--(int)
+   {
+      auto copy = *this;
+      --m_index;
+      return copy;
+   }
+   indexed_iterator& operator+=(difference_type offset)
+   {
+      m_index = static_cast< size_t >(static_cast< difference_type >(m_index) + offset);
+      return *this;
+   }
+   indexed_iterator& operator-=(difference_type offset) { return *this += -offset; }
+
+   friend indexed_iterator operator+(indexed_iterator iter, difference_type offset)
+   {
+      return iter += offset;
+   }
+   friend indexed_iterator operator+(difference_type offset, indexed_iterator iter)
+   {
+      return iter += offset;
+   }
+   friend indexed_iterator operator-(indexed_iterator iter, difference_type offset)
+   {
+      return iter -= offset;
+   }
+   friend difference_type operator-(const indexed_iterator& lhs, const indexed_iterator& rhs)
+   {
+      return static_cast< difference_type >(lhs.m_index)
+             - static_cast< difference_type >(rhs.m_index);
+   }
+   friend bool operator==(const indexed_iterator& lhs, const indexed_iterator& rhs)
+   {
+      return lhs.m_index == rhs.m_index;
+   }
+   friend auto operator<=>(const indexed_iterator& lhs, const indexed_iterator& rhs)
+   {
+      return lhs.m_index <=> rhs.m_index;
+   }
+
+  private:
+   const Container* m_container = nullptr;
+   size_t m_index = 0;
+};
+
+}  // namespace force::detail
+
+#endif  // REINFORCE_UTILS_INDEXED_ITERATOR_HPP
@@ -0,0 +1,107 @@
+#ifndef REINFORCE_UTILS_MPSC_QUEUE_HPP
+#define REINFORCE_UTILS_MPSC_QUEUE_HPP
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace force {
+
+/// @brief A bounded lock-free queue with many producers and a single consumer.
+///
+/// The cells form a ring, each with a sequence number telling whether it is free for the
+/// producer of a given position or filled for the consumer (Vyukov's bounded queue). Producers
+/// claim positions with a compare-exchange on the tail and publish the value by advancing the
+/// sequence of their cell. The consumer may block in `pop_wait` until a value is pushed.
+template < typename T >
+class MpscQueue {
+  public:
+   /// The capacity is rounded up to the next power of two.
+   explicit MpscQueue(size_t capacity)
+       : m_capacity(std::bit_ceil(capacity < 2 ? size_t{2} : capacity)),
+         m_mask(m_capacity - 1),
+         m_cells(std::make_unique< cell[] >(m_capacity))
+   {
+      for(size_t i = 0; i < m_capacity; ++i) {
+         m_cells[i].sequence.store(i, std::memory_order_relaxed);
+      }
+   }
+
+   MpscQueue(const MpscQueue&) = delete;
+   MpscQueue& operator=(const MpscQueue&) = delete;
+
+   /// Push from any thread. Returns false if the queue is full.
+   bool try_push(const T& value)
+   {
+      size_t position = m_tail.load(std::memory_order_relaxed);
+      cell* target = nullptr;
+      while(true) {
+         target = &m_cells[position & m_mask];
+         const size_t sequence = target->sequence.load(std::memory_order_acquire);
+         const auto diff = static_cast< std::ptrdiff_t >(sequence)
+                           - static_cast< std::ptrdiff_t >(position);
+         if(diff == 0) {
+            if(m_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+               break;
+            }
+         } else if(diff < 0) {
+            return false;
+         } else {
+            position = m_tail.load(std::memory_order_relaxed);
+         }
+      }
+      target->value = value;
+      target->sequence.store(position + 1, std::memory_order_release);
+      m_pushed.fetch_add(1, std::memory_order_release);
+      m_pushed.notify_one();
+      return true;
+   }
+
+   /// Pop on the consumer thread. Returns false if the queue is empty.
+   bool try_pop(T& out)
+   {
+      cell& source = m_cells[m_head & m_mask];
+      if(source.sequence.load(std::memory_order_acquire) != m_head + 1) {
+         return false;
+      }
+      out = source.value;
+      source.sequence.store(m_head + m_capacity, std::memory_order_release);
+      ++m_head;
+      return true;
+   }
+
+   /// Pop on the consumer thread, sleeping until a value is available.
+   void pop_wait(T& out)
+   {
+      while(true) {
+         // read the counter first, so that a push after the failed pop changes it and wakes us
+         const uint64_t pushed = m_pushed.load(std::memory_order_acquire);
+         if(try_pop(out)) {
+            return;
+         }
+         m_pushed.wait(pushed, std::memory_order_acquire);
+      }
+   }
+
+   [[nodiscard]] size_t capacity() const { return m_capacity; }
+
+  private:
+   struct cell {
+      std::atomic< size_t > sequence;
+      T value;
+   };
+
+   size_t m_capacity;
+   size_t m_mask;
+   std::unique_ptr< cell[] > m_cells;
+   /// producer and consumer positions on separate cache lines
+   alignas(64) std::atomic< size_t > m_tail{0};
+   alignas(64) size_t m_head = 0;
+   alignas(64) std::atomic< uint64_t > m_pushed{0};
+};
+
+}  // namespace force
+
+#endif  // REINFORCE_UTILS_MPSC_QUEUE_HPP
@@ -0,0 +1,38 @@
+#ifndef REINFORCE_UTILS_PROCESS_HPP
+#define REINFORCE_UTILS_PROCESS_HPP
+
+#include <functional>
+#include <optional>
+
+namespace force {
+
+/// @brief A forked child process.
+///
+/// The child runs `body` on a copy of the parent's memory and exits with its return value (1 if
+/// it throws) right after, without unwinding the stack or running the exit handlers it inherited.
+/// It is killed when the parent dies and, if still running, when the handle is destroyed.
+class ChildProcess {
+  public:
+   explicit ChildProcess(const std::function< int() >& body);
+   ~ChildProcess();
+
+   ChildProcess(const ChildProcess&) = delete;
+   ChildProcess& operator=(const ChildProcess&) = delete;
+   ChildProcess(ChildProcess&& other) noexcept;
+   ChildProcess& operator=(ChildProcess&& other) noexcept;
+
+   [[nodiscard]] int pid() const { return m_pid; }
+
+   /// Whether the child has not exited yet.
+   bool running();
+   /// Wait for the child to exit. Returns its exit status, or 128 + the signal that killed it.
+   int join();
+
+  private:
+   int m_pid = -1;
+   std::optional< int > m_status = std::nullopt;
+};
+
+}  // namespace force
+
+#endif  // REINFORCE_UTILS_PROCESS_HPP
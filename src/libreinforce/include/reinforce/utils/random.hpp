@@ -0,0 +1,96 @@
+#ifndef REINFORCE_UTILS_RANDOM_HPP
+#define REINFORCE_UTILS_RANDOM_HPP
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <span>
+
+namespace force::detail {
+
+template < typename Generator >
+concept full_range_64bit_generator = std::uniform_random_bit_generator< Generator >
+                                     and Generator::min() == 0
+                                     and Generator::max()
+                                            == std::numeric_limits< uint64_t >::max();
+
+/// @brief Draw uniformly from [0, bound) using Lemire's multiply-high range reduction.
+///
+/// The 64x64->128 bit multiplication replaces the division of a modulo reduction. The rejection
+/// step which removes the bias is taken with probability bound / 2^64 at most.
+/// `bound` has to be greater than 0.
+template < full_range_64bit_generator Generator >
+inline uint64_t uniform_below(Generator& gen, uint64_t bound)
+{
+   auto product = static_cast< __uint128_t >(gen()) * bound;
+   auto low = static_cast< uint64_t >(product);
+   if(low < bound) {
+      const uint64_t threshold = (0 - bound) % bound;
+      while(low < threshold) {
+         product = static_cast< __uint128_t >(gen()) * bound;
+         low = static_cast< uint64_t >(product);
+      }
+   }
+   return static_cast< uint64_t >(product >> 64);
+}
+
+/// @brief Fill `out` with `offset + r` where every r is drawn uniformly from [0, bound).
+///
+/// For bounds that fit into 32 bits every generator call provides two samples. The generator
+/// output is buffered in chunks so that the reduction loop is branch-free and can be vectorized
+/// by the compiler. Biased draws are flagged in that loop and redrawn afterwards.
+template < full_range_64bit_generator Generator, typename T >
+void uniform_below_fill(Generator& gen, uint64_t bound, std::span< T > out, T offset = T{0})
+{
+   if(bound > std::numeric_limits< uint32_t >::max()) {
+      for(auto& value : out) {
+         value = static_cast< T >(offset + static_cast< T >(uniform_below(gen, bound)));
+      }
+      return;
+   }
+   constexpr size_t chunk_size = 128;
+   const auto bound32 = static_cast< uint64_t >(bound);
+   const auto threshold = static_cast< uint32_t >((uint32_t{0} - static_cast< uint32_t >(bound))
+                                                  % static_cast< uint32_t >(bound));
+   std::array< uint64_t, chunk_size > raw{};
+   std::array< uint32_t, 2 * chunk_size > samples{};
+   std::array< uint32_t, 2 * chunk_size > low_bits{};
+
+   for(size_t begin = 0; begin < out.size(); begin += 2 * chunk_size) {
+      const size_t n_samples = std::min(2 * chunk_size, out.size() - begin);
+      const size_t n_words = (n_samples + 1) / 2;
+      for(size_t i = 0; i < n_words; ++i) {
+         raw[i] = gen();
+      }
+      bool any_rejected = false;
+      for(size_t i = 0; i < n_words; ++i) {
+         const uint64_t lower = (raw[i] & 0xFFFFFFFFu) * bound32;
+         const uint64_t upper = (raw[i] >> 32) * bound32;
+         samples[2 * i] = static_cast< uint32_t >(lower >> 32);
+         samples[2 * i + 1] = static_cast< uint32_t >(upper >> 32);
+         low_bits[2 * i] = static_cast< uint32_t >(lower);
+         low_bits[2 * i + 1] = static_cast< uint32_t >(upper);
+         any_rejected |= (static_cast< uint32_t >(lower) < threshold)
+                         | (static_cast< uint32_t >(upper) < threshold);
+      }
+      auto chunk = out.subspan(begin, n_samples);
+      for(size_t i = 0; i < n_samples; ++i) {
+         chunk[i] = static_cast< T >(offset + static_cast< T >(samples[i]));
+      }
+      if(any_rejected) {
+         for(size_t i = 0; i < n_samples; ++i) {
+            if(low_bits[i] < threshold) {
+               chunk[i] = static_cast< T >(offset + static_cast< T >(uniform_below(gen, bound)));
+            }
+         }
+      }
+   }
+}
+
+}  // namespace force::detail
+
+#endif  // REINFORCE_UTILS_RANDOM_HPP
@@ -0,0 +1,56 @@
+#ifndef REINFORCE_UTILS_SHARED_MEMORY_HPP
+#define REINFORCE_UTILS_SHARED_MEMORY_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace force {
+
+/// @brief An anonymous shared memory mapping.
+///
+/// The mapping stays shared with child processes forked after its creation and lives at the same
+/// address in them, so pointers into it are valid on both sides. The memory is zero-initialized.
+class SharedMemoryRegion {
+  public:
+   explicit SharedMemoryRegion(size_t size);
+   ~SharedMemoryRegion();
+
+   SharedMemoryRegion(const SharedMemoryRegion&) = delete;
+   SharedMemoryRegion& operator=(const SharedMemoryRegion&) = delete;
+   SharedMemoryRegion(SharedMemoryRegion&& other) noexcept;
+   SharedMemoryRegion& operator=(SharedMemoryRegion&& other) noexcept;
+
+   [[nodiscard]] std::byte* data() const { return m_data; }
+   [[nodiscard]] size_t size() const { return m_size; }
+
+  private:
+   std::byte* m_data = nullptr;
+   size_t m_size = 0;
+};
+
+namespace detail {
+
+static_assert(
+   std::atomic< uint32_t >::is_always_lock_free and sizeof(std::atomic< uint32_t >) == 4,
+   "Futex words have to be plain 32-bit integers."
+);
+
+/// Sleep while `word` holds `expected`, at most for `timeout`. Unlike `std::atomic::wait` this
+/// also wakes up on notifications from other processes sharing the memory of `word`. Returns
+/// false on timeout.
+bool futex_wait(
+   const std::atomic< uint32_t >& word,
+   uint32_t expected,
+   std::chrono::nanoseconds timeout
+);
+
+/// Wake all threads and processes sleeping on `word`.
+void futex_wake_all(const std::atomic< uint32_t >& word);
+
+}  // namespace detail
+
+}  // namespace force
+
+#endif  // REINFORCE_UTILS_SHARED_MEMORY_HPP
@@ -0,0 +1,81 @@
+#ifndef REINFORCE_UTILS_THREAD_POOL_HPP
+#define REINFORCE_UTILS_THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "reinforce/utils/topology.hpp"
+
+namespace force {
+
+/// Pin the calling thread to the given CPU core. Returns false if the platform does not support
+/// thread affinities or the core is not available to this process.
+bool pin_this_thread(size_t core);
+
+/// @brief A fixed set of worker threads with one task queue each and work stealing.
+///
+/// Tasks submitted to a worker land in its queue. An idle worker first takes the most recently
+/// pushed task of its own queue and then steals the oldest task from the others, so uneven task
+/// costs are balanced across the workers while tasks tend to stay on the worker they were meant
+/// for (e.g. the worker owning an environment). Worker i has the thread index i (see
+/// `set_this_thread_index`), so pools of n workers sample from n thread streams however often they
+/// are recreated. Other threads sampling from the same streams must not hold an index below n,
+/// which automatically numbered threads only avoid if they ask for it after the pool started.
+class ThreadPool {
+  public:
+   using task_type = std::function< void() >;
+
+   /// Start `n_threads` workers. If `cores` is not empty, worker i is pinned to the core
+   /// `cores[i % cores.size()]`.
+   explicit ThreadPool(size_t n_threads, std::vector< size_t > cores = {});
+   /// Start `n_threads` workers placed on the CPUs of `topology` by `policy`, e.g. for sampling
+   /// with thread streams close to the memory of the batches.
+   ThreadPool(size_t n_threads, placement policy, const Topology& topology = Topology::query())
+       : ThreadPool(n_threads, place_workers(topology, n_threads, policy))
+   {
+   }
+   ~ThreadPool();
+
+   ThreadPool(const ThreadPool&) = delete;
+   ThreadPool& operator=(const ThreadPool&) = delete;
+
+   /// Queue the task at the calling worker, or round-robin if called from outside the pool.
+   void submit(task_type task);
+   /// Queue the task at the given worker.
+   void submit(size_t worker, task_type task);
+
+   [[nodiscard]] size_t size() const { return m_threads.size(); }
+
+   /// The index of the calling worker of the pool it belongs to, nullopt outside of any pool.
+   static std::optional< size_t > this_worker();
+
+  private:
+   struct alignas(64) task_queue {
+      std::mutex mutex;
+      std::deque< task_type > tasks;
+   };
+
+   std::vector< std::unique_ptr< task_queue > > m_queues;
+   std::vector< std::thread > m_threads;
+   std::mutex m_sleep_mutex;
+   std::condition_variable m_wakeup;
+   /// the number of queued tasks not yet taken by a worker
+   std::atomic< size_t > m_pending{0};
+   std::atomic< size_t > m_next_queue{0};
+   bool m_stop = false;
+
+   void _run(size_t index, std::optional< size_t > core);
+   bool _take(size_t index, task_type& task);
+};
+
+}  // namespace force
+
+#endif  // REINFORCE_UTILS_THREAD_POOL_HPP
@@ -0,0 +1,72 @@
+#ifndef REINFORCE_UTILS_TOPOLOGY_HPP
+#define REINFORCE_UTILS_TOPOLOGY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace force {
+
+struct NumaNode {
+   size_t id;
+   /// the CPUs of the node this process may run on
+   std::vector< size_t > cpus;
+};
+
+/// @brief The NUMA nodes of the machine and their CPUs.
+class Topology {
+  public:
+   explicit Topology(std::vector< NumaNode > nodes);
+
+   /// @brief Read the NUMA nodes from sysfs (/sys/devices/system/node/node*/cpulist).
+   ///
+   /// Only CPUs in the affinity mask of the process are listed, nodes without any are left out.
+   /// Without NUMA information (e.g. on single-node machines without sysfs entries or on other
+   /// platforms) the topology is a single node 0 with all available CPUs.
+   static Topology query(const std::filesystem::path& sysfs_nodes = "/sys/devices/system/node");
+
+   [[nodiscard]] auto& nodes() const { return m_nodes; }
+   [[nodiscard]] size_t nr_nodes() const { return m_nodes.size(); }
+   [[nodiscard]] size_t nr_cpus() const;
+   /// The id of the node the CPU belongs to, nullopt if it is not part of the topology.
+   [[nodiscard]] std::optional< size_t > node_of(size_t cpu) const;
+
+  private:
+   std::vector< NumaNode > m_nodes;
+};
+
+/// How to spread worker threads over the CPUs of a topology.
+enum class placement : uint8_t {
+   /// leave the threads to the scheduler
+   none,
+   /// fill the CPUs of one node after the other, keeping workers close together
+   compact,
+   /// alternate the nodes from worker to worker, spreading workers over all memory controllers
+   scatter
+};
+
+/// The CPU for each of `n_workers` workers, empty for `placement::none` or a topology without CPUs.
+/// CPUs are reused once every CPU of the topology has a worker.
+std::vector< size_t > place_workers(const Topology& topology, size_t n_workers, placement policy);
+
+/// @brief Run `task(i)` on a thread pinned to `cpus[i]` for every i and wait for all of them.
+///
+/// Memory first written by `task(i)` is placed on the NUMA node of `cpus[i]` by the kernel's
+/// first-touch policy. Rethrows the first exception of any task.
+void run_pinned(std::span< const size_t > cpus, const std::function< void(size_t) >& task);
+
+namespace detail {
+
+/// Parse a sysfs CPU list such as "0-3,8,10-11".
+std::vector< size_t > parse_cpu_list(std::string_view list);
+
+}  // namespace detail
+
+}  // namespace force
+
+#endif  // REINFORCE_UTILS_TOPOLOGY_HPP
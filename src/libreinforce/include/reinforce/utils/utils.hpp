@@ -11,12 +11,14 @@
 #include <functional>
 #include <iterator>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <pcg_extras.hpp>
 #include <pcg_random.hpp>
 #include <random>
 #include <range/v3/all.hpp>
 #include <ranges>
+#include <set>
 #include <span>
 #include <stdexcept>
 #include <string_view>
@@ -201,6 +203,131 @@ inline auto create_rng()
    return pcg64{pcg_extras::seed_seq_from< std::random_device >{}};
 }
 
+/// The generator that overrides every space's own generator on the current thread while set.
+/// Managed through `rng_override_guard`.
+inline pcg64*& rng_override()
+{
+   thread_local pcg64* override_rng = nullptr;
+   return override_rng;
+}
+
+/// RAII guard redirecting all sampling on the current thread to a caller-supplied generator.
+/// Guards nest, the previous override is restored on destruction.
+class rng_override_guard {
+  public:
+   explicit rng_override_guard(pcg64& rng) : m_previous(std::exchange(rng_override(), &rng)) {}
+   ~rng_override_guard() { rng_override() = m_previous; }
+
+   rng_override_guard(const rng_override_guard&) = delete;
+   rng_override_guard& operator=(const rng_override_guard&) = delete;
+
+  private:
+   pcg64* m_previous;
+};
+
+/// Keeps track of the thread indices held by living threads, explicitly set ones included. An
+/// index is returned when its thread exits or sets another one, and the smallest index not held by
+/// any thread is handed out first, so automatic indices stay below the number of threads alive at
+/// once and never collide with explicitly set ones.
+class thread_index_registry {
+  public:
+   static thread_index_registry& instance()
+   {
+      static thread_index_registry registry;
+      return registry;
+   }
+
+   size_t acquire()
+   {
+      std::lock_guard lock{m_mutex};
+      size_t index = 0;
+      // the held indices are sorted, the first gap is the smallest free index
+      for(size_t held : m_held) {
+         if(held > index) {
+            break;
+         }
+         if(held == index) {
+            ++index;
+         }
+      }
+      m_held.insert(index);
+      return index;
+   }
+
+   /// hold `index` for the calling thread, even if another thread holds it already
+   void reserve(size_t index)
+   {
+      std::lock_guard lock{m_mutex};
+      m_held.insert(index);
+   }
+
+   void release(size_t index)
+   {
+      std::lock_guard lock{m_mutex};
+      m_held.erase(m_held.find(index));
+   }
+
+  private:
+   std::mutex m_mutex;
+   std::multiset< size_t > m_held;
+};
+
+/// the index of the calling thread, released on thread exit
+struct thread_index_slot {
+   std::optional< size_t > index = std::nullopt;
+
+   thread_index_slot() = default;
+   thread_index_slot(const thread_index_slot&) = delete;
+   thread_index_slot& operator=(const thread_index_slot&) = delete;
+   ~thread_index_slot() { release(); }
+
+   void release()
+   {
+      if(index.has_value()) {
+         thread_index_registry::instance().release(*index);
+         index = std::nullopt;
+      }
+   }
+
+   static thread_index_slot& local()
+   {
+      thread_local thread_index_slot slot;
+      return slot;
+   }
+};
+
+}  // namespace force::detail
+
+namespace force {
+
+/// Explicitly set the index of the calling thread, which selects the random stream a space uses
+/// on this thread once its thread streams are enabled. Set this for reproducible results, since
+/// automatically assigned indices depend on the order in which threads first sample. The index is
+/// reserved, automatically numbered threads skip it. Keeping explicit indices distinct from each
+/// other and from indices handed out before is up to the caller.
+inline void set_this_thread_index(size_t index)
+{
+   auto& slot = detail::thread_index_slot::local();
+   detail::thread_index_registry::instance().reserve(index);
+   slot.release();
+   slot.index = index;
+}
+
+/// The index of the calling thread. Threads without an explicitly set index get the smallest index
+/// not held by another living thread when they first ask for it.
+inline size_t this_thread_index()
+{
+   auto& slot = detail::thread_index_slot::local();
+   if(not slot.index.has_value()) {
+      slot.index = detail::thread_index_registry::instance().acquire();
+   }
+   return *slot.index;
+}
+
+}  // namespace force
+
+namespace force::detail {
+
 class rng_mixin {
   public:
    explicit rng_mixin(std::optional< size_t > seed = std::nullopt)
@@ -210,20 +337,76 @@ class rng_mixin {
    // Seed the PRNG of this space
    /// `seed` can be made const since m_rng is mutable, but do not do this! The only access to m_rng
    /// in a const-object should be for the sake of sampling, not changing the RNG object altogether
-   void seed(std::optional< size_t > seed) { m_rng = create_rng(seed); }
-   void seed(pcg64& seed) { m_rng = create_rng(seed()); }
+   void seed(std::optional< size_t > seed)
+   {
+      m_rng = create_rng(seed);
+      m_seed = seed;
+      _reseed_thread_rngs();
+   }
+   void seed(pcg64& seed) { this->seed(std::optional{static_cast< size_t >(seed())}); }
 
    auto seed() const { return m_seed; }
+
+   /// @brief Give every thread index in [0, n_threads) its own random stream.
+   ///
+   /// Afterwards a const space may be sampled from several threads concurrently. Each stream is
+   /// derived from the space's seed and the thread index (see `set_this_thread_index`), so results
+   /// are reproducible per thread.
+   void enable_thread_streams(size_t n_threads)
+   {
+      m_thread_rngs.resize(n_threads);
+      _reseed_thread_rngs();
+   }
+   void disable_thread_streams() { m_thread_rngs.clear(); }
+   [[nodiscard]] size_t nr_thread_streams() const { return m_thread_rngs.size(); }
+
    /// const rng reference for external rng state inspection
-   [[nodiscard]] auto& rng() const { return m_rng; }
+   [[nodiscard]] auto& rng() const { return _active_rng(); }
    /// mutable rng reference for derived classes to forward random state
-   auto& rng() { return m_rng; }
+   auto& rng() { return _active_rng(); }
 
    bool operator==(const rng_mixin& rhs) const = default;
 
   private:
+   /// one cache line per stream so that concurrently drawing threads do not false-share
+   struct alignas(64) padded_rng {
+      pcg64 rng;
+      bool operator==(const padded_rng& rhs) const = default;
+   };
+
    mutable pcg64 m_rng;
    std::optional< size_t > m_seed = std::nullopt;
+   mutable std::vector< padded_rng > m_thread_rngs{};
+
+   pcg64& _active_rng() const
+   {
+      if(auto* override_rng = rng_override(); override_rng != nullptr) {
+         return *override_rng;
+      }
+      if(m_thread_rngs.empty()) {
+         return m_rng;
+      }
+      const auto index = this_thread_index();
+      if(index >= m_thread_rngs.size()) {
+         throw std::out_of_range(fmt::format(
+            "Thread index {} exceeds the number of thread streams ({}).",
+            index,
+            m_thread_rngs.size()
+         ));
+      }
+      return m_thread_rngs[index].rng;
+   }
+
+   void _reseed_thread_rngs()
+   {
+      if(m_thread_rngs.empty()) {
+         return;
+      }
+      const size_t base_seed = m_seed.has_value() ? *m_seed : static_cast< size_t >(m_rng());
+      for(auto&& [stream, padded] : ranges::views::enumerate(m_thread_rngs)) {
+         padded.rng = pcg64{base_seed, stream};
+      }
+   }
 };
 
 template < typename To >
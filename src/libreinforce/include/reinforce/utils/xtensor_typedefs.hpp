@@ -4,6 +4,7 @@
 #include <cstddef>
 #include <xtensor/xarray.hpp>
 #include <xtensor/xfixed.hpp>
+#include <xtensor/xtensor.hpp>
 
 #ifdef REINFORCE_USE_PYTHON
    #include <xtensor-python/pyarray.hpp>
@@ -17,6 +18,8 @@ template < typename T >
 using xarray = xt::xarray< T, layout >;
 template < typename T, size_t... shape >
 using xstacktensor = xt::xtensor_fixed< T, xt::xshape< shape... >, layout >;
+template < typename T, size_t dim >
+using xtensor = xt::xtensor< T, dim, layout >;
 
 using idx_xarray = xt::xarray< size_t, layout >;
 
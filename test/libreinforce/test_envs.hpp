@@ -0,0 +1,22 @@
+#ifndef REINFORCE_TEST_ENVS_HPP
+#define REINFORCE_TEST_ENVS_HPP
+
+#include <array>
+#include <cstddef>
+
+#include "reinforce/env/gridworld.hpp"
+#include "reinforce/utils/xtensor_typedefs.hpp"
+
+namespace force::test {
+
+/// a single row of three cells with the start on the left and the goal on the right
+inline Gridworld< 2 > make_corridor(size_t /*index*/ = 0)
+{
+   return Gridworld< 2 >{
+      std::array< size_t, 2 >{1, 3}, idx_pyarray{{0, 0}}, idx_pyarray{{0, 2}}, 1.
+   };
+}
+
+}  // namespace force::test
+
+#endif  // REINFORCE_TEST_ENVS_HPP
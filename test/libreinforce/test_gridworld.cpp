@@ -1,11 +1,21 @@
 #include <gtest/gtest.h>
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
 #include <array>
+#include <cmath>
 #include <cstddef>
+#include <random>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
 
+#include "reinforce/env/any_gridworld.hpp"
+#include "reinforce/env/dynamic_gridworld.hpp"
 #include "reinforce/env/gridworld.hpp"
 #include "reinforce/reinforce.hpp"
+#include "test_envs.hpp"
 
 using namespace force;
 
@@ -211,4 +221,139 @@ TEST_F(Gridworld2D_step_F, step)
          break;
       }
    }
-}
\ No newline at end of file
+}
+
+TEST(Gridworld, any_gridworld_runtime_dimension)
+{
+   for(size_t dim = 1; dim <= 5; ++dim) {
+      idx_xarray starts = xt::zeros< size_t >({size_t{1}, dim});
+      idx_xarray goals = starts;
+      goals(0, dim - 1) = 1;
+      AnyGridworld env = make_any_gridworld(dim, std::vector< size_t >(dim, 3), starts, goals, 1.);
+      const auto& [index, coordinates] = env.reset(0);
+      EXPECT_EQ(index, size_t{0});
+      EXPECT_EQ(coordinates.size(), dim);
+      // forth along the last axis reaches the goal
+      auto [observation, reward, terminated, truncated] = env.step(2 * (dim - 1) + 1);
+      EXPECT_TRUE(terminated);
+      EXPECT_EQ(reward, 1.);
+      EXPECT_EQ(std::get< 1 >(observation)(dim - 1), size_t{1});
+   }
+   AnyGridworld corridor = test::make_corridor();
+   EXPECT_NE(corridor.target< Gridworld< 2 > >(), nullptr);
+   EXPECT_EQ(corridor.target< Gridworld< 3 > >(), nullptr);
+   EXPECT_THROW(
+      make_any_gridworld(6, std::vector< size_t >(6, 3), idx_xarray{}, idx_xarray{}, 1.),
+      std::invalid_argument
+   );
+}
+
+TEST(Gridworld, any_gridworld_step_batch)
+{
+   std::vector< AnyGridworld > envs;
+   for(size_t i = 0; i < 3; ++i) {
+      envs.emplace_back(test::make_corridor());
+      envs.back().reset(i);
+   }
+   auto observations = batch_space(envs.front().observation_space(), envs.size()).sample();
+   xarray< double > rewards = xt::zeros< double >({envs.size()});
+   xarray< bool > terminated = xt::zeros< bool >({envs.size()});
+   xarray< bool > truncated = xt::zeros< bool >({envs.size()});
+   AnyGridworld::step_batch(
+      envs, xarray< size_t >{3, 3, 2}, observations, rewards, terminated, truncated
+   );
+   EXPECT_EQ(std::get< 0 >(observations), (xarray< size_t >{1, 1, 0}));
+   AnyGridworld::step_batch(
+      envs, xarray< size_t >{3, 2, 3}, observations, rewards, terminated, truncated
+   );
+   EXPECT_EQ(terminated, (xarray< bool >{true, false, false}));
+   EXPECT_EQ(rewards(0), 1.);
+}
+
+TEST(Gridworld, any_gridworld_empty)
+{
+   std::vector< AnyGridworld > envs;
+   for(size_t i = 0; i < 2; ++i) {
+      envs.emplace_back(test::make_corridor());
+      envs.back().reset(i);
+   }
+   AnyGridworld moved_to = std::move(envs[1]);
+   EXPECT_FALSE(moved_to.empty());
+   EXPECT_TRUE(envs[1].empty());
+   EXPECT_THROW(envs[1].reset(), std::logic_error);
+   EXPECT_THROW(envs[1].step(0), std::logic_error);
+   EXPECT_THROW(envs[1].close(), std::logic_error);
+   EXPECT_THROW(static_cast< void >(envs[1].stores_inline()), std::logic_error);
+
+   auto observations = batch_space(moved_to.observation_space(), envs.size()).sample();
+   xarray< double > rewards = xt::zeros< double >({envs.size()});
+   xarray< bool > terminated = xt::zeros< bool >({envs.size()});
+   xarray< bool > truncated = xt::zeros< bool >({envs.size()});
+   EXPECT_THROW(
+      AnyGridworld::step_batch(
+         envs, xarray< size_t >{3, 3}, observations, rewards, terminated, truncated
+      ),
+      std::logic_error
+   );
+   // the environment before the empty one was not stepped either
+   EXPECT_EQ(envs[0].target< Gridworld< 2 > >()->location_idx(), size_t{0});
+}
+
+TEST(Gridworld, dynamic_gridworld)
+{
+   for(size_t dim : {size_t{2}, size_t{8}}) {
+      idx_xarray starts = xt::zeros< size_t >({size_t{1}, dim});
+      idx_xarray goals = starts;
+      goals(0, dim - 1) = 2;
+      DynamicGridworld env{dim, std::vector< size_t >(dim, 3), starts, goals, 1., -0.1};
+      EXPECT_EQ(env.is_static(), dim <= 6);
+      EXPECT_EQ(env.size(), static_cast< size_t >(std::pow(3, dim)));
+      EXPECT_EQ(env.action_space().n(), 2 * dim);
+      EXPECT_EQ(env.reset(0).first, size_t{0});
+      // back along the first axis leaves the grid and has no effect
+      auto [observation, reward, terminated, truncated] = env.step(0);
+      EXPECT_EQ(observation.first, size_t{0});
+      EXPECT_EQ(reward, 0.);
+      std::tie(observation, reward, terminated, truncated) = env.step(2 * (dim - 1) + 1);
+      EXPECT_FALSE(terminated);
+      EXPECT_DOUBLE_EQ(reward, -0.1);
+      std::tie(observation, reward, terminated, truncated) = env.step(2 * (dim - 1) + 1);
+      EXPECT_TRUE(terminated);
+      EXPECT_DOUBLE_EQ(reward, 0.9);
+      EXPECT_EQ(observation.second[dim - 1], size_t{2});
+      EXPECT_EQ(env.index_state(observation.second), observation.first);
+      EXPECT_EQ(env.coord_state(observation.first), observation.second);
+      EXPECT_TRUE(env.is_terminal(observation.first));
+   }
+   EXPECT_THROW(
+      DynamicGridworld(0, std::vector< size_t >{}, idx_xarray{}, idx_xarray{}, 1.),
+      std::invalid_argument
+   );
+}
+
+TEST(Gridworld, dynamic_gridworld_generic_matches_static)
+{
+   const std::vector< size_t > shape{3, 4, 2};
+   const idx_pyarray starts{{0, 0, 0}, {1, 2, 1}};
+   const idx_pyarray goals{{2, 3, 1}};
+   const idx_pyarray subgoals{{1, 1, 0}};
+   Gridworld< 3 > grid{shape, starts, goals, 1., -0.1, {}, 0.7, subgoals, 0.5};
+   detail::GenericGridworld generic{
+      3, shape, starts, goals, 1., -0.1, {}, 0.7, subgoals, 0.5, {}, {}, 0.
+   };
+   EXPECT_EQ(generic.reset(5).first, grid.reset(5).first);
+   std::mt19937_64 action_rng{0};
+   for(size_t i = 0; i < 200; ++i) {
+      const size_t action = action_rng() % 6;
+      auto [expected_obs, expected_reward, expected_terminated, truncated] = grid.step(action);
+      auto [observation, reward, terminated, generic_truncated] = generic.step(action);
+      ASSERT_EQ(observation.first, expected_obs.first);
+      ASSERT_TRUE(std::ranges::equal(observation.second, expected_obs.second));
+      ASSERT_DOUBLE_EQ(reward, expected_reward);
+      ASSERT_EQ(terminated, expected_terminated);
+      if(terminated) {
+         grid.reset(i);
+         generic.reset(i);
+      }
+   }
+}
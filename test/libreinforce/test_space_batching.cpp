@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+
+#include "reinforce/spaces/batching.hpp"
+#include "reinforce/spaces/box.hpp"
+#include "reinforce/spaces/dict.hpp"
+#include "reinforce/spaces/discrete.hpp"
+#include "reinforce/spaces/multi_binary.hpp"
+#include "reinforce/spaces/text.hpp"
+#include "reinforce/spaces/tuple.hpp"
+#include "reinforce/utils/xarray_formatter.hpp"
+#include "reinforce/utils/xtensor_typedefs.hpp"
+
+using namespace force;
+
+TEST(Spaces, Batching_batch_space)
+{
+   auto box = BoxSpace{xarray< double >{-1, 0}, xarray< double >{1, 2}, std::optional< size_t >{3}};
+   auto batched_box = batch_space(box, 4);
+   EXPECT_EQ(batched_box.shape(), (xt::svector< int >{4, 2}));
+   EXPECT_EQ(xt::view(batched_box.low(), 3), box.low());
+   EXPECT_TRUE(batched_box.contains(box.sample(4)));
+
+   auto discrete = DiscreteSpace{5, 2};
+   auto batched_discrete = batch_space(discrete, 3);
+   static_assert(std::same_as< decltype(batched_discrete), MultiDiscreteSpace< int > >);
+   EXPECT_EQ(batched_discrete.start(), (xarray< int >{2, 2, 2}));
+   EXPECT_EQ(batched_discrete.end(), (xarray< int >{7, 7, 7}));
+   EXPECT_TRUE(batched_discrete.contains(discrete.sample(3)));
+
+   auto batched_binary = batch_space(MultiBinarySpace{2, 3}, 5);
+   EXPECT_EQ(batched_binary.shape(), (xt::svector< int >{5, 2, 3}));
+
+   auto batched_tuple = batch_space(TupleSpace{box, discrete}, 6);
+   auto sample = batched_tuple.sample();
+   EXPECT_EQ(std::get< 0 >(sample).shape(0), size_t{6});
+   EXPECT_EQ(std::get< 1 >(sample).size(), size_t{6});
+
+   auto batched_text = batch_space(TextSpace{8, 42}, 7);
+   auto texts = batched_text.sample();
+   EXPECT_EQ(texts.size(), size_t{7});
+   EXPECT_TRUE(batched_text.contains(texts));
+   texts.pop_back();
+   EXPECT_FALSE(batched_text.contains(texts));
+}
+
+TEST(Spaces, Batching_iterate)
+{
+   auto space = TupleSpace{
+      std::optional< size_t >{21},
+      BoxSpace{xarray< double >{-1, 0}, xarray< double >{1, 2}},
+      DiscreteSpace{5},
+      TextSpace{8}
+   };
+   auto batch = space.sample(10);
+   size_t index = 0;
+   for(auto [box, discrete, text] : iterate(space, batch)) {
+      EXPECT_EQ(box, xt::view(std::get< 0 >(batch), index));
+      EXPECT_EQ(discrete, std::get< 1 >(batch)(index));
+      static_assert(std::same_as< decltype(text), std::string_view >);
+      EXPECT_EQ(text.data(), std::get< 2 >(batch)[index].data());
+      ++index;
+   }
+   EXPECT_EQ(index, size_t{10});
+
+   // the views write through to the batch
+   for(auto&& [box, discrete, text] : iterate(space, batch)) {
+      box = xarray< double >{0.5, 1.5};
+      discrete = 3;
+   }
+   EXPECT_TRUE(xt::all(xt::equal(xt::view(std::get< 0 >(batch), xt::all(), 0), 0.5)));
+   EXPECT_TRUE(xt::all(xt::equal(std::get< 1 >(batch), 3)));
+}
+
+TEST(Spaces, Batching_dict)
+{
+   auto space = DictSpace{
+      std::optional< size_t >{5},
+      entry< "position" >(BoxSpace{xarray< double >{-1, -1}, xarray< double >{1, 1}}),
+      entry< "goal" >(DiscreteSpace{4})
+   };
+   auto batched = batch_space(space, 3);
+   auto batch = batched.sample();
+   EXPECT_EQ(batch.get< "position" >().shape(0), size_t{3});
+   EXPECT_EQ(batch.get< "goal" >().size(), size_t{3});
+   EXPECT_TRUE(space.contains_all(batch));
+
+   size_t index = 0;
+   for(const auto& value : iterate(space, batch)) {
+      EXPECT_EQ(value.get< "goal" >(), batch.get< "goal" >()(index));
+      ++index;
+   }
+   EXPECT_EQ(index, size_t{3});
+}
@@ -1,3 +1,4 @@
+#include <limits>
 #include <numbers>
 #include <stdexcept>
 #include <tuple>
@@ -156,6 +157,30 @@ TEST(Spaces, Box_contains)
    EXPECT_TRUE(space.contains(contain_candidates));
 }
 
+TEST(Spaces, Box_contains_batch)
+{
+   const xarray< double > low{-inf<>, 0, 50};
+   const xarray< double > high{0, inf<>, 51};
+   BoxSpace space{low, high, low.shape(), 5232};
+   auto batch = space.sample(100);
+   EXPECT_TRUE(xt::all(space.contains_batch(batch)));
+   EXPECT_TRUE(space.contains_all(batch));
+
+   // invalidate a few samples, every single one has to be flagged
+   batch(3, 0) = 1.;
+   batch(17, 2) = 51.5;
+   batch(99, 1) = std::numeric_limits< double >::quiet_NaN();
+   auto valid = space.contains_batch(batch);
+   ASSERT_EQ(valid.size(), 100);
+   for(size_t i = 0; i < 100; ++i) {
+      EXPECT_EQ(valid(i), i != 3 and i != 17 and i != 99);
+   }
+   EXPECT_FALSE(space.contains_all(batch));
+   EXPECT_FALSE(space.contains(batch));
+   // a single sample is not a batch
+   EXPECT_THROW(std::ignore = space.contains_batch(space.sample()), std::invalid_argument);
+}
+
 TEST(Spaces, Box_copy_construction)
 {
    const xarray< double > low{-inf<>, 0, -10};
@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <optional>
+#include <tuple>
+#include <vector>
+
+#include "reinforce/spaces/box.hpp"
+#include "reinforce/spaces/dict.hpp"
+#include "reinforce/spaces/discrete.hpp"
+#include "reinforce/spaces/flatten.hpp"
+#include "reinforce/spaces/multi_discrete.hpp"
+#include "reinforce/utils/concatenate.hpp"
+#include "reinforce/utils/xarray_formatter.hpp"
+#include "reinforce/utils/xtensor_typedefs.hpp"
+
+using namespace force;
+
+namespace {
+
+auto make_dict_space(std::optional< size_t > seed = std::nullopt)
+{
+   return DictSpace{
+      seed,
+      entry< "position" >(BoxSpace{xarray< double >{-1, -1}, xarray< double >{1, 1}}),
+      entry< "goal" >(DiscreteSpace{4, 2}),
+      entry< "switches" >(MultiDiscreteSpace{xarray< int >{0, 0, -2}, xarray< int >{2, 5, 3}})
+   };
+}
+
+}  // namespace
+
+TEST(Spaces, Dict_keys)
+{
+   auto space = make_dict_space();
+   using space_type = decltype(space);
+   static_assert(space_type::keys::index_of< "goal" > == 1);
+   EXPECT_EQ(space.size(), size_t{3});
+   EXPECT_EQ(space_type::index_of("switches"), 2);
+   EXPECT_EQ(space_type::index_of("velocity"), std::nullopt);
+   EXPECT_EQ(space_type::names()[0], "position");
+   EXPECT_EQ(space.get< "goal" >(), space.get< 1 >());
+}
+
+TEST(Spaces, Dict_sample_and_contains)
+{
+   auto space = make_dict_space(742);
+   auto sample = space.sample();
+   EXPECT_TRUE(space.contains(sample));
+   EXPECT_GE(sample.get< "goal" >(), 2);
+   EXPECT_LT(get< "goal" >(sample), 6);
+   EXPECT_EQ(sample.get< "switches" >().size(), size_t{3});
+
+   // the batch is a struct of arrays with one batch per key
+   auto batch = space.sample(100);
+   EXPECT_EQ(batch.get< "position" >().shape(0), size_t{100});
+   EXPECT_EQ(batch.get< "goal" >().size(), size_t{100});
+   EXPECT_EQ(batch.get< "switches" >().shape(0), size_t{100});
+   EXPECT_TRUE(space.contains_all(batch));
+   batch.get< "goal" >()(11) = 6;
+   auto valid = space.contains_batch(batch);
+   EXPECT_FALSE(valid(11));
+   EXPECT_FALSE(space.contains_all(batch));
+
+   auto& [position, goal, switches] = sample;
+   space.sample_into(sample);
+   EXPECT_TRUE(space.get< "position" >().contains(position));
+   EXPECT_TRUE(space.get< "goal" >().contains(goal));
+   EXPECT_TRUE(space.get< "switches" >().contains(switches));
+}
+
+TEST(Spaces, Dict_reseeding)
+{
+   constexpr size_t SEED = 3467;
+   auto space = make_dict_space(SEED);
+   auto samples1 = space.sample(10);
+   space.seed(SEED);
+   auto samples2 = space.sample(10);
+   EXPECT_EQ(samples1.get< "position" >(), samples2.get< "position" >());
+   EXPECT_EQ(samples1.get< "goal" >(), samples2.get< "goal" >());
+   EXPECT_EQ(samples1.get< "switches" >(), samples2.get< "switches" >());
+}
+
+TEST(Spaces, Dict_concatenate_and_flatten)
+{
+   auto space = make_dict_space(91);
+   std::vector< decltype(space)::value_type > samples;
+   for(size_t i = 0; i < 5; ++i) {
+      samples.emplace_back(space.sample());
+   }
+   auto batch = concatenate< decltype(space) >{}(space, samples);
+   EXPECT_EQ(batch.get< "position" >().shape(0), size_t{5});
+   for(size_t i = 0; i < 5; ++i) {
+      EXPECT_EQ(batch.get< "goal" >()(i), samples[i].get< "goal" >());
+      EXPECT_EQ(xt::view(batch.get< "switches" >(), i), samples[i].get< "switches" >());
+   }
+   EXPECT_TRUE(space.contains_all(batch));
+
+   EXPECT_EQ(flatdim(space), size_t{2 + 4 + (2 + 5 + 5)});
+   auto flat = flatten(space, samples[0]);
+   auto restored = unflatten(space, std::span< const double >{flat.data(), flat.size()});
+   EXPECT_EQ(restored, samples[0]);
+   auto view = unflatten_view(space, std::span{flat.data(), flat.size()});
+   view.get< "position" >()(1) = 0.25;
+   EXPECT_EQ(flat(1), 0.25);
+   auto flat_batch = flatten_batch(space, batch);
+   EXPECT_EQ(flat_batch.shape(1), flatdim(space));
+   EXPECT_TRUE(flatten_space(space).contains_all(flat_batch));
+}
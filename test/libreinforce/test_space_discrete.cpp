@@ -5,6 +5,8 @@
 
 #include "gtest/gtest.h"
 #include "reinforce/spaces/discrete.hpp"
+#include "reinforce/utils/alias_table.hpp"
+#include "reinforce/utils/bitmask.hpp"
 #include "reinforce/utils/math.hpp"
 #include "reinforce/utils/xarray_formatter.hpp"
 #include "reinforce/utils/xtensor_typedefs.hpp"
@@ -118,3 +120,114 @@ TEST(Spaces, Discrete_copy_construction)
    auto samples_copy = space_copy.sample(10000);
    EXPECT_NE(samples, samples_copy);
 }
+
+TEST(Spaces, Discrete_sample_external_rng)
+{
+   constexpr size_t SEED = 6492374569235;
+   constexpr int n = 10;
+   constexpr int start = 0;
+   const auto space = DiscreteSpace{n, start, SEED};
+   auto space_copy = space;
+   pcg64 gen1{SEED};
+   pcg64 gen2{SEED};
+   // identically seeded external generators produce identical samples
+   EXPECT_EQ(space.sample(gen1, 100), space.sample(gen2, 100));
+   EXPECT_EQ(space.sample(gen1), space.sample(gen2));
+   // the space's own generator was never advanced
+   EXPECT_EQ(space.rng(), space_copy.rng());
+   EXPECT_EQ(space.sample(100), space_copy.sample(100));
+}
+
+TEST(Spaces, Discrete_sample_into)
+{
+   constexpr int n = 10;
+   constexpr int start = 5;
+   auto space = DiscreteSpace{n, start};
+   xarray< int > samples = space.sample(100);
+   const auto* buffer = samples.data();
+   space.sample_into(100, samples);
+   // the buffer is reused when the batch size does not change
+   EXPECT_EQ(samples.data(), buffer);
+   EXPECT_TRUE(xt::all(samples >= start));
+   EXPECT_TRUE(xt::all(samples < start + n));
+
+   int value = 0;
+   for([[maybe_unused]] auto _ : ranges::views::iota(0, 100)) {
+      space.sample_into(value);
+      EXPECT_TRUE(space.contains(value));
+   }
+}
+
+TEST(Spaces, Discrete_sample_bitmask)
+{
+   constexpr int n = 1000;
+   constexpr int start = -20;
+   auto space = DiscreteSpace{n, start};
+   BitMask mask{n};
+   for(int i = 3; i < n; i += 97) {
+      mask.set(static_cast< size_t >(i));
+   }
+   xarray< int > allowed = xt::arange(3, n, 97) + start;
+   auto samples = space.sample(10000, mask);
+   EXPECT_EQ(samples.size(), 10000);
+   EXPECT_TRUE(xt::all(xt::isin(samples, allowed)));
+   // every allowed value is drawn at some point
+   EXPECT_TRUE(xt::all(xt::isin(allowed, samples)));
+   for([[maybe_unused]] auto _ : ranges::views::iota(0, 100)) {
+      EXPECT_TRUE(xt::any(xt::equal(allowed, space.sample(mask))));
+   }
+   // byte masks are converted to the same bitmask
+   xarray< int8_t > byte_mask = xt::zeros< int8_t >({n});
+   for(int i = 3; i < n; i += 97) {
+      byte_mask.unchecked(i) = 1;
+   }
+   EXPECT_EQ(BitMask{byte_mask}, mask);
+   EXPECT_TRUE(xt::all(xt::isin(space.sample(1000, byte_mask), allowed)));
+   // a fully masked out space yields its start value
+   EXPECT_EQ(space.sample(BitMask{n}), start);
+   EXPECT_THROW(space.sample(BitMask{n + 1}), std::invalid_argument);
+}
+
+TEST(Spaces, Discrete_sample_range_mask)
+{
+   constexpr int n = 10;
+   constexpr int start = 0;
+   auto space = DiscreteSpace{n, start};
+   xarray< int > mask = {0, 0, 1, 1, 0, 1, 1, 0, 0, 0};
+   // fewer samples than mask entries must still consider the entire mask
+   for([[maybe_unused]] auto _ : ranges::views::iota(0, 100)) {
+      auto samples = space.sample(3, mask);
+      EXPECT_TRUE(xt::all(xt::isin(samples, xt::xarray< int >{2, 3, 5, 6})));
+   }
+}
+
+TEST(Spaces, Discrete_sample_probability_mask)
+{
+   constexpr int n = 5;
+   constexpr int start = 2;
+   constexpr size_t n_samples = 100000;
+   auto space = DiscreteSpace{n, start, 42};
+   xarray< double > probabilities = {0.1, 0., 0.5, 0.4, 0.};
+   xarray< int > samples = space.sample(n_samples, probabilities);
+   // zero-probability values are never drawn and the rest follow the distribution
+   for(int i = 0; i < n; ++i) {
+      auto frequency = static_cast< double >(xt::sum(xt::equal(samples, start + i))())
+                       / n_samples;
+      EXPECT_NEAR(frequency, probabilities(i), 0.01);
+   }
+   for([[maybe_unused]] auto _ : ranges::views::iota(0, 100)) {
+      auto value = space.sample(probabilities);
+      EXPECT_NE(value, start + 1);
+      EXPECT_NE(value, start + 4);
+   }
+   // a prebuilt alias table is accepted as mask as well
+   AliasTable table{probabilities};
+   EXPECT_TRUE(xt::all(xt::isin(space.sample(1000, table), xt::xarray< int >{2, 4, 5})));
+   // the cache returns the same table for the same distribution
+   EXPECT_EQ(
+      detail::cached_alias_table(std::span{probabilities.data(), probabilities.size()}),
+      detail::cached_alias_table(std::span{probabilities.data(), probabilities.size()})
+   );
+   EXPECT_THROW(space.sample(xarray< double >{0.5, 0.5}), std::invalid_argument);
+   EXPECT_THROW(space.sample(xarray< double >{1., -1., 0., 0., 0.}), std::invalid_argument);
+}
@@ -0,0 +1,64 @@
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+
+#include "gtest/gtest.h"
+#include "reinforce/spaces/fixed_box.hpp"
+#include "reinforce/spaces/flatten.hpp"
+#include "reinforce/utils/math.hpp"
+#include "reinforce/utils/xarray_formatter.hpp"
+#include "reinforce/utils/xtensor_typedefs.hpp"
+
+using namespace force;
+
+TEST(Spaces, FixedBox_constructor)
+{
+   using space_type = FixedBoxSpace< double, 3 >;
+   EXPECT_NO_THROW((space_type{-1., 1.}));
+   EXPECT_NO_THROW((space_type{-1, 1.f, 42}));
+   EXPECT_NO_THROW((space_type{{-inf<>, 0, -10}, {0, inf<>, 10}}));
+   EXPECT_THROW((space_type{{0, 0, 0}, {1, -1, 1}}), std::invalid_argument);
+   EXPECT_EQ(space_type(0, 1).shape(), xt::svector< int >{3});
+   static_assert(space_type::size == 3);
+   static_assert(std::same_as< space_type::value_type, xstacktensor< double, 3 > >);
+   static_assert(std::same_as< space_type::batch_value_type, xtensor< double, 2 > >);
+}
+
+TEST(Spaces, FixedBox_2D_sample)
+{
+   const xstacktensor< double, 2, 3 > low{{-inf<>, 0, -10}, {-2, -inf<>, 5}};
+   const xstacktensor< double, 2, 3 > high{{0, inf<>, 10}, {2, 1, inf<>}};
+   auto box = FixedBoxSpace< double, 2, 3 >{low, high, 8235};
+   auto samples = box.sample(1000);
+   EXPECT_EQ(samples.shape(), (std::array< size_t, 3 >{1000, 2, 3}));
+   for(size_t i = 0; i < 2; ++i) {
+      for(size_t j = 0; j < 3; ++j) {
+         EXPECT_TRUE(xt::all(xt::view(samples, xt::all(), i, j) >= low(i, j)));
+         EXPECT_TRUE(xt::all(xt::view(samples, xt::all(), i, j) <= high(i, j)));
+      }
+   }
+   EXPECT_TRUE(xt::all(box.contains_batch(samples)));
+   EXPECT_TRUE(box.contains_all(samples));
+   samples(17, 0, 2) = 11;
+   auto valid = box.contains_batch(samples);
+   EXPECT_FALSE(valid(17));
+   EXPECT_EQ(std::count(valid.begin(), valid.end(), true), 999);
+   EXPECT_FALSE(box.contains(samples));
+
+   auto sample = box.sample();
+   EXPECT_TRUE(box.contains(sample));
+   box.sample_into(sample);
+   EXPECT_TRUE(box.contains(sample));
+}
+
+TEST(Spaces, FixedBox_flatten)
+{
+   auto box = FixedBoxSpace< float, 2, 2 >{-1, 1, 12};
+   EXPECT_EQ(flatdim(box), size_t{4});
+   auto sample = box.sample();
+   auto flat = flatten< float >(box, sample);
+   EXPECT_EQ(unflatten(box, std::span< const float >{flat.data(), flat.size()}), sample);
+   auto view = unflatten_view(box, std::span{flat.data(), flat.size()});
+   view(1, 1) = 0.5f;
+   EXPECT_EQ(flat(3), 0.5f);
+}
@@ -0,0 +1,49 @@
+#include <stdexcept>
+#include <type_traits>
+
+#include "gtest/gtest.h"
+#include "reinforce/spaces/fixed_multi_discrete.hpp"
+#include "reinforce/spaces/flatten.hpp"
+#include "reinforce/utils/xarray_formatter.hpp"
+#include "reinforce/utils/xtensor_typedefs.hpp"
+
+using namespace force;
+
+TEST(Spaces, FixedMultiDiscrete_constructor)
+{
+   using space_type = FixedMultiDiscreteSpace< int, 3 >;
+   EXPECT_NO_THROW((space_type{xstacktensor< int, 3 >{2, 3, 4}}));
+   EXPECT_NO_THROW((space_type{{-2, 0, 1}, {2, 3, 4}, 42}));
+   EXPECT_THROW((space_type{{0, 3, 0}, {2, 3, 4}}), std::invalid_argument);
+   static_assert(std::same_as< space_type::value_type, xstacktensor< int, 3 > >);
+   static_assert(std::same_as< space_type::batch_value_type, xtensor< int, 2 > >);
+}
+
+TEST(Spaces, FixedMultiDiscrete_sample)
+{
+   const xstacktensor< int, 2, 2 > start{{0, -5}, {10, 3}};
+   const xstacktensor< int, 2, 2 > end{{2, 5}, {11, 7}};
+   auto space = FixedMultiDiscreteSpace< int, 2, 2 >{start, end, 6543};
+   auto samples = space.sample(1000);
+   EXPECT_EQ(samples.shape(), (std::array< size_t, 3 >{1000, 2, 2}));
+   for(size_t i = 0; i < 2; ++i) {
+      for(size_t j = 0; j < 2; ++j) {
+         auto column = xt::view(samples, xt::all(), i, j);
+         EXPECT_TRUE(xt::all(column >= start(i, j)));
+         EXPECT_TRUE(xt::all(column < end(i, j)));
+         // every value of the range is hit
+         EXPECT_EQ(xt::amin(column)(), start(i, j));
+         EXPECT_EQ(xt::amax(column)(), end(i, j) - 1);
+      }
+   }
+   EXPECT_TRUE(space.contains_all(samples));
+   samples(3, 1, 0) = 11;  // the end is excluded
+   EXPECT_FALSE(space.contains_batch(samples)(3));
+   EXPECT_FALSE(space.contains_all(samples));
+
+   auto sample = space.sample();
+   EXPECT_TRUE(space.contains(sample));
+   EXPECT_EQ(flatdim(space), size_t{2 + 10 + 1 + 4});
+   auto flat = flatten(space, sample);
+   EXPECT_EQ(unflatten(space, std::span< const double >{flat.data(), flat.size()}), sample);
+}
@@ -1,4 +1,6 @@
+#include <algorithm>
 #include <cstddef>
+#include <functional>
 #include <optional>
 #include <sstream>
 #include <string_view>
@@ -187,3 +189,108 @@ TEST(Spaces, Graph_Text_SequenceOfDiscrete_sample)
       );
    }
 }
+
+TEST(Spaces, Graph_Discrete_Discrete_sample_packed)
+{
+   auto space = GraphSpace{DiscreteSpace{5, 0}, DiscreteSpace{10, 10}, 553};
+   constexpr size_t n_samples = 20;
+   xarray< size_t > num_nodes = xt::random::randint({n_samples}, 2, 2 + n_samples, space.rng());
+   xarray< size_t > num_edges = xt::random::randint({n_samples}, 0, 10, space.rng());
+   auto batch = space.sample_packed(n_samples, num_nodes, num_edges);
+
+   ASSERT_EQ(batch.size(), n_samples);
+   EXPECT_EQ(batch.nodes.size(), xt::sum(num_nodes)());
+   EXPECT_EQ(batch.edges.size(), xt::sum(num_edges)());
+   EXPECT_EQ(batch.edge_links.shape()[0], xt::sum(num_edges)());
+   EXPECT_EQ(batch.graph_ids.size(), batch.nodes.size());
+   EXPECT_TRUE(space.node_space().contains(batch.nodes));
+   EXPECT_TRUE(space.edge_space()->contains(batch.edges));
+   for(size_t graph = 0; graph < n_samples; ++graph) {
+      auto instance = batch.instance(graph);
+      EXPECT_EQ(instance.nodes.size(), num_nodes(graph));
+      EXPECT_EQ(instance.edges.size(), num_edges(graph));
+      // edge links index the nodes of their own graph only
+      EXPECT_TRUE(xt::all(instance.edge_links < num_nodes(graph)));
+      for(size_t node = batch.node_offsets[graph]; node < batch.node_offsets[graph + 1]; ++node) {
+         EXPECT_EQ(batch.graph_ids[node], graph);
+      }
+   }
+   EXPECT_EQ(batch.unpack().size(), n_samples);
+
+   // a graph space without edge space has no edges at all
+   auto node_only_space = GraphSpace{DiscreteSpace{5, 0}, 553};
+   auto node_only_batch = node_only_space.sample_packed(n_samples, 4);
+   EXPECT_EQ(node_only_batch.nodes.size(), 4 * n_samples);
+   EXPECT_EQ(node_only_batch.edge_links.shape()[0], 0);
+   EXPECT_EQ(node_only_batch.edges.size(), 0);
+}
+
+TEST(Spaces, Graph_sample_into_shapes)
+{
+   auto space = GraphSpace{
+      DiscreteSpace{5, 0}, BoxSpace{xarray< double >{0., 0., 0.}, xarray< double >{1., 1., 1.}}, 553
+   };
+   auto node_only_space = GraphSpace{DiscreteSpace{5, 0}, 553};
+   auto expect_same_shapes = [](const auto& sample, const auto& out) {
+      EXPECT_EQ(out.nodes.shape(), sample.nodes.shape());
+      EXPECT_EQ(out.edges.shape(), sample.edges.shape());
+      EXPECT_EQ(out.edge_links.shape(), sample.edge_links.shape());
+   };
+   for(const auto num_edges :
+       {std::optional< size_t >{}, std::optional< size_t >{0}, std::optional< size_t >{4}}) {
+      // `out` starts with buffers of other shapes, which sample_into has to replace
+      auto out = space.sample(std::nullopt, 3, 7);
+      space.sample_into(out, std::nullopt, 6, num_edges);
+      expect_same_shapes(space.sample(std::nullopt, 6, num_edges), out);
+      EXPECT_EQ(out.edge_links.shape()[0], num_edges.value_or(0));
+
+      auto node_only_out = node_only_space.sample(std::nullopt, 3);
+      node_only_space.sample_into(node_only_out, std::nullopt, 6, num_edges);
+      expect_same_shapes(node_only_space.sample(std::nullopt, 6, num_edges), node_only_out);
+      EXPECT_EQ(node_only_out.edge_links.shape()[0], 0);
+   }
+}
+
+TEST(Spaces, Graph_unique_edges_and_adjacency)
+{
+   auto space = GraphSpace{DiscreteSpace{5, 0}, DiscreteSpace{10, 10}, 553};
+   space.set_edge_sampling({.self_loops = false, .unique = true});
+   constexpr size_t n_nodes = 6;
+   for(size_t n_edges : {size_t{0}, size_t{7}, n_nodes * (n_nodes - 1)}) {
+      auto graph = space.sample(std::nullopt, n_nodes, n_edges);
+      auto adjacency = make_adjacency(graph);
+      auto incoming = make_adjacency(graph, AdjacencyOrder::by_target);
+      ASSERT_EQ(adjacency.nr_nodes(), n_nodes);
+      EXPECT_EQ(adjacency.indices.size(), n_edges);
+      EXPECT_EQ(incoming.indices.size(), n_edges);
+      for(size_t node = 0; node < n_nodes; ++node) {
+         auto neighbours = adjacency.neighbours(node);
+         // unique edges come in ascending order, so neighbour lists are strictly increasing
+         EXPECT_EQ(std::ranges::adjacent_find(neighbours, std::greater_equal{}), neighbours.end());
+         EXPECT_EQ(std::ranges::find(neighbours, node), neighbours.end());
+         for(auto [target, edge] : ranges::views::zip(neighbours, adjacency.edges_of(node))) {
+            EXPECT_EQ(graph.edge_links(edge, 0), node);
+            EXPECT_EQ(graph.edge_links(edge, 1), target);
+         }
+         for(auto edge : incoming.edges_of(node)) {
+            EXPECT_EQ(graph.edge_links(edge, 1), node);
+         }
+      }
+   }
+   // the complete graph without self loops has no room for another edge
+   EXPECT_THROW(
+      space.sample(std::nullopt, n_nodes, n_nodes * (n_nodes - 1) + 1), std::invalid_argument
+   );
+
+   auto batch = space.sample_packed(4, 5, 12);
+   auto block_adjacency = make_adjacency(batch);
+   EXPECT_EQ(block_adjacency.nr_nodes(), 20);
+   for(size_t node = 0; node < block_adjacency.nr_nodes(); ++node) {
+      for(auto neighbour : block_adjacency.neighbours(node)) {
+         EXPECT_EQ(batch.graph_ids[neighbour], batch.graph_ids[node]);
+      }
+   }
+   auto per_graph = make_adjacency(batch.unpack());
+   ASSERT_EQ(per_graph.size(), 4);
+   EXPECT_EQ(per_graph[1].indices.size(), 12);
+}
@@ -64,6 +64,33 @@ TEST(Spaces, MultiBinary_sample_masked)
    }
 }
 
+TEST(Spaces, MultiBinary_sample_packed)
+{
+   auto space = MultiBinarySpace{xt::svector{2, 3}};
+   constexpr size_t n_samples = 1000;
+   auto packed = space.sample_packed(n_samples);
+   EXPECT_EQ(packed.batch_size(), n_samples);
+   EXPECT_EQ(packed.bits_per_sample(), 6);
+   // 6000 bits fit into 94 words
+   EXPECT_EQ(packed.words().size(), 94);
+   auto samples = packed.unpack();
+   EXPECT_TRUE(ranges::equal(samples.shape(), xt::svector{n_samples, 2, 3}));
+   EXPECT_TRUE(space.contains(samples));
+   EXPECT_EQ(space.pack(samples), packed);
+   EXPECT_EQ(samples(7, 1, 2) == 1, packed.test(7, 5));
+
+   xt::xarray< int8_t > mask = {{0, 0, 2}, {1, 2, 2}};
+   samples = space.sample_packed(n_samples, mask).unpack();
+   EXPECT_TRUE(xt::all(xt::equal(xt::view(samples, xt::all(), 0, 0), 0)));
+   EXPECT_TRUE(xt::all(xt::equal(xt::view(samples, xt::all(), 0, 1), 0)));
+   EXPECT_TRUE(xt::all(xt::equal(xt::view(samples, xt::all(), 1, 0), 1)));
+   EXPECT_FALSE(xt::all(xt::equal(xt::view(samples, xt::all(), 1, 2), 1)));
+   EXPECT_FALSE(xt::all(xt::equal(xt::view(samples, xt::all(), 1, 2), 0)));
+   // a single sample has no batch dimension
+   EXPECT_TRUE(ranges::equal(space.sample_packed().unpack().shape(), xt::svector{2, 3}));
+   EXPECT_THROW(space.pack(xt::xarray< int8_t >{1, 0, 1}), std::invalid_argument);
+}
+
 TEST(Spaces, MultiBinary_reseeding)
 {
    constexpr size_t SEED = 6492374569235;
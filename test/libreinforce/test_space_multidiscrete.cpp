@@ -1,9 +1,15 @@
 #include <gtest/gtest.h>
 #include <spdlog/spdlog.h>
 
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <stdexcept>
 #include <tuple>
+#include <vector>
 #include <xtensor/xset_operation.hpp>
 
+#include "reinforce/spaces/flatten.hpp"
 #include "reinforce/spaces/multi_discrete.hpp"
 #include "reinforce/utils/xarray_formatter.hpp"
 #include "reinforce/utils/xtensor_typedefs.hpp"
@@ -19,6 +25,8 @@ TEST(Spaces, MultiDiscrete_constructor)
    // construct with seed
    EXPECT_NO_THROW((MultiDiscreteSpace{start, end, 42}));
    EXPECT_NO_THROW((MultiDiscreteSpace{end, 42}));
+   // every element needs at least one value
+   EXPECT_THROW((MultiDiscreteSpace{start, xarray< int >{10, 0, 3}}), std::invalid_argument);
 }
 
 TEST(Spaces, MultiDiscrete_sample)
@@ -40,6 +48,22 @@ TEST(Spaces, MultiDiscrete_sample)
    }
 }
 
+TEST(Spaces, MultiDiscrete_sample_large_nvec)
+{
+   constexpr int n_elements = 512;
+   constexpr size_t n_samples = 2000;
+   xarray< int > start = xt::arange(-n_elements / 2, n_elements / 2);
+   xarray< int > end = start + 1 + xt::arange(n_elements) % 7;
+   auto space = MultiDiscreteSpace{start, end, 42};
+   xarray< int > samples = space.sample(n_samples);
+   ASSERT_EQ(samples.shape(), (xt::svector< size_t >{n_samples, n_elements}));
+   EXPECT_TRUE(xt::all(samples >= xt::expand_dims(start, 0)));
+   EXPECT_TRUE(xt::all(samples < xt::expand_dims(end, 0)));
+   // every element reaches its lowest and highest value
+   EXPECT_TRUE(xt::all(xt::equal(xt::amin(samples, {0}), start)));
+   EXPECT_TRUE(xt::all(xt::equal(xt::amax(samples, {0}), end - 1)));
+}
+
 TEST(Spaces, MultiDiscrete_sample_masked)
 {
    constexpr auto n_samples = 10000;
@@ -47,7 +71,7 @@ TEST(Spaces, MultiDiscrete_sample_masked)
    auto end = xarray< int >{10, 5, 3};
    auto space = MultiDiscreteSpace{start, end};
    auto mask = std::vector< std::optional< xarray< bool > > >{
-      xarray< bool >{false, false, false, false, false, true, true, true, true, true, true},
+      xarray< bool >{false, false, false, false, false, true, true, true, true, true},
       std::nullopt,
       xarray< bool >{false, true, true, true, false}
    };
@@ -73,6 +97,46 @@ TEST(Spaces, MultiDiscrete_sample_masked)
       EXPECT_GE(samples(2), -1);
       EXPECT_LE(samples(2), 1);
    }
+
+   // masks of the wrong length are rejected rather than cut to size
+   for(size_t length : {size_t{4}, size_t{6}}) {
+      auto wrong_mask = std::vector< std::optional< xarray< bool > > >{
+         std::nullopt, xt::ones< bool >({length}), std::nullopt
+      };
+      EXPECT_THROW(std::ignore = space.sample(n_samples, wrong_mask), std::invalid_argument);
+   }
+}
+
+TEST(Spaces, MultiDiscrete_sample_probability_mask)
+{
+   constexpr auto n_samples = 10000;
+   auto start = xarray< int >{0, 0, -2};
+   auto end = xarray< int >{10, 5, 3};
+   auto space = MultiDiscreteSpace{start, end};
+   auto mask = std::vector< std::optional< xarray< double > > >{
+      xarray< double >{0., 0., 0., 0., 0., 1., 1., 1., 1., 1.},
+      std::nullopt,
+      xarray< double >{0., 0.2, 0.2, 0.6, 0.}
+   };
+   auto samples = space.sample(n_samples, mask);
+   EXPECT_TRUE((
+      xt::all(xt::isin(xt::strided_view(samples, {xt::all(), 0}), xt::xarray< int >{5, 6, 7, 8, 9}))
+   ));
+   EXPECT_TRUE(
+      (xt::all(xt::isin(xt::strided_view(samples, {xt::all(), 2}), xt::xarray< int >{-1, 0, 1})))
+   );
+   auto frequency = static_cast< double >(
+                       xt::sum(xt::equal(xt::strided_view(samples, {xt::all(), 2}), 1))()
+                    )
+                    / n_samples;
+   EXPECT_NEAR(frequency, 0.6, 0.03);
+
+   for([[maybe_unused]] auto _ : ranges::views::iota(0, 100)) {
+      samples = space.sample(mask);
+      EXPECT_GE(samples(0), 5);
+      EXPECT_GE(samples(2), -1);
+      EXPECT_LE(samples(2), 1);
+   }
 }
 
 TEST(Spaces, MultiDiscrete_reseeding)
@@ -145,3 +209,41 @@ TEST(Spaces, MultiDiscrete_copy_construction)
    // the samples now should no longer be the same
    EXPECT_NE(space_copy.sample(), space.sample());
 }
+
+TEST(Spaces, MultiDiscrete_flatten)
+{
+   auto start = xarray< int >{0, 0, -2};
+   auto end = xarray< int >{10, 5, 3};
+   MultiDiscreteSpace space{start, end, 42ul};
+   EXPECT_EQ(flatdim(space), size_t{10 + 5 + 5});
+
+   // every element is one-hot encoded over its own range
+   const xarray< int > value{3, 4, -2};
+   auto flat = flatten(space, value);
+   EXPECT_EQ(xt::sum(flat)(), 3.);
+   EXPECT_EQ(flat(3), 1.);
+   EXPECT_EQ(flat(10 + 4), 1.);
+   EXPECT_EQ(flat(15 + 0), 1.);
+   EXPECT_EQ(unflatten(space, std::span< const double >{flat.data(), flat.size()}), value);
+   EXPECT_THROW(flatten(space, xarray< int >{3, 5, -2}), std::invalid_argument);
+
+   const Flattener space_flattener{space};
+   EXPECT_EQ(space_flattener.flatdim(), flatdim(space));
+   auto batch = space.sample(30);
+   auto flat_batch = flatten_batch(space_flattener, batch);
+   EXPECT_EQ(flat_batch.shape(0), size_t{30});
+   EXPECT_EQ(flat_batch.shape(1), size_t{20});
+   for(size_t i = 0; i < 30; ++i) {
+      auto row = xarray< double >(xt::row(flat_batch, static_cast< std::ptrdiff_t >(i)));
+      EXPECT_EQ(xt::sum(row)(), 3.);
+      EXPECT_EQ(
+         unflatten(space_flattener, std::span< const double >{row.data(), row.size()}),
+         xt::view(batch, i)
+      );
+   }
+
+   auto flat_space = flatten_space(space);
+   EXPECT_EQ(flat_space.low(), xt::zeros< double >({20}));
+   EXPECT_EQ(flat_space.high(), xt::ones< double >({20}));
+   EXPECT_TRUE(flat_space.contains_all(flat_batch));
+}
@@ -7,6 +7,7 @@
 
 #include "reinforce/spaces/box.hpp"
 #include "reinforce/spaces/discrete.hpp"
+#include "reinforce/spaces/multi_binary.hpp"
 #include "reinforce/spaces/multi_discrete.hpp"
 #include "reinforce/spaces/oneof.hpp"
 #include "reinforce/spaces/text.hpp"
@@ -127,7 +128,7 @@ TEST(Spaces, OneOf_Discrete_Box_MultiDiscrete_Text_sample_masked)
       std::nullopt,
       // multidiscrete mask
       std::vector< std::optional< xarray< bool > > >{
-         xarray< bool >{false, false, false, false, false, true, true, true, true, true, true},
+         xarray< bool >{false, false, false, false, false, true, true, true, true, true},
          std::nullopt,
          xarray< bool >{false, true, true, true, false}
       },
@@ -193,6 +194,60 @@ TEST(Spaces, OneOf_Discrete_Box_MultiDiscrete_Text_sample_masked)
    }
 }
 
+TEST(Spaces, OneOf_Discrete_MultiDiscrete_Text_sample_columnar)
+{
+   const xarray< int > md_start = xarray< int >({0, 0, -3});
+   const xarray< int > md_end = xarray< int >({10, 5, 3});
+   auto space = OneOfSpace{
+      size_t{7345},
+      DiscreteSpace{5, 5},
+      MultiDiscreteSpace{md_start, md_end},
+      TextSpace{{.max_length = 6, .characters = "aeiou"}}
+   };
+   constexpr size_t n_samples = 200;
+   auto batch = space.sample_columnar(n_samples);
+   ASSERT_EQ(batch.size(), n_samples);
+   auto& [disc_batch, mdisc_batch, text_batch] = batch.batches;
+   EXPECT_EQ(disc_batch.size() + mdisc_batch.shape()[0] + text_batch.size(), n_samples);
+   EXPECT_TRUE(xt::all(disc_batch >= 5 and disc_batch < 10));
+
+   std::array< size_t, 3 > seen{};
+   for(auto [i, sample] : ranges::views::enumerate(batch)) {
+      auto [space_idx, sample_var] = sample;
+      EXPECT_EQ(space_idx, batch.tags[i]);
+      EXPECT_EQ(sample_var.index(), space_idx);
+      // entries of each subspace are handed out in the order of their sub-batch
+      EXPECT_EQ(batch.indices[i], seen[space_idx]++);
+   }
+   EXPECT_TRUE(ranges::all_of(seen, [](size_t count) { return count > 0; }));
+   EXPECT_EQ(batch.unpack().size(), n_samples);
+}
+
+TEST(Spaces, OneOf_Discrete_MultiBinary_sample_columnar_single_draw)
+{
+   auto space = OneOfSpace{size_t{123}, DiscreteSpace{5, 5}, MultiBinarySpace{2, 3}};
+   size_t multi_binary_draws = 0;
+   for([[maybe_unused]] auto _ : ranges::views::iota(0, 50)) {
+      // a batch of one draws its subspace exactly once
+      auto batch = space.sample_columnar(1);
+      ASSERT_EQ(batch.size(), 1);
+      if(batch.tags[0] != 1) {
+         continue;
+      }
+      ++multi_binary_draws;
+      const auto& binary_batch = std::get< 1 >(batch.batches);
+      ASSERT_EQ(binary_batch.dimension(), 3);
+      EXPECT_EQ(binary_batch.shape()[0], 1);
+      auto [space_idx, sample_var] = batch[0];
+      ASSERT_EQ(space_idx, 1);
+      const auto& sample = std::get< 1 >(sample_var);
+      ASSERT_EQ(sample.dimension(), 2);
+      EXPECT_EQ(sample.shape()[0], 2);
+      EXPECT_EQ(sample.shape()[1], 3);
+   }
+   EXPECT_GT(multi_binary_draws, 0);
+}
+
 //
 // TEST(Spaces, OneOf_Discrete_Box_reseeding)
 //{
@@ -1,8 +1,10 @@
 #include <cstddef>
 #include <reinforce/spaces/box.hpp>
 #include <reinforce/spaces/discrete.hpp>
+#include <reinforce/spaces/multi_binary.hpp>
 #include <reinforce/spaces/multi_discrete.hpp>
 #include <tuple>
+#include <vector>
 #include <xtensor/xset_operation.hpp>
 
 #include "gtest/gtest.h"
@@ -125,7 +127,7 @@ TEST(Spaces, Sequence_MultiDiscrete_sample_masked)
    auto mask = std::tuple{
       10,
       std::vector< std::optional< xarray< bool > > >{
-         xarray< bool >{false, false, false, false, false, true, true, true, true, true, true},
+         xarray< bool >{false, false, false, false, false, true, true, true, true, true},
          std::nullopt,
          xarray< bool >{true, false, true, true, true, false}
       }
@@ -218,3 +220,111 @@ TEST(Spaces, Sequence_Box_copy_construction)
    auto sample = space.sample();
    EXPECT_TRUE(sample_copy.size() != sample.size() or xt::any(xt::not_equal(sample_copy, sample)));
 }
+
+TEST(Spaces, Sequence_Box_sample_ragged)
+{
+   const xarray< double > box_low{-inf<>, 0, -10};
+   const xarray< double > box_high{0, inf<>, 10};
+   auto space = SequenceSpace{BoxSpace{box_low, box_high}, 3737};
+   constexpr size_t n_samples = 50;
+   auto ragged = space.sample_ragged(n_samples);
+   ASSERT_EQ(ragged.size(), n_samples);
+   ASSERT_EQ(ragged.values.shape()[0], ragged.offsets.back());
+   EXPECT_EQ(ragged.values.shape()[1], 3);
+   for(auto coord : ranges::views::iota(0, 3)) {
+      EXPECT_TRUE(xt::all(xt::view(ragged.values, xt::all(), coord) >= box_low(coord)));
+      EXPECT_TRUE(xt::all(xt::view(ragged.values, xt::all(), coord) <= box_high(coord)));
+   }
+
+   auto sequences = ragged.unpack();
+   ASSERT_EQ(sequences.size(), n_samples);
+   for(size_t i = 0; i < n_samples; ++i) {
+      EXPECT_EQ(sequences[i].shape()[0], ragged.length(i));
+   }
+   EXPECT_EQ(decltype(ragged)::pack(sequences), ragged);
+
+   // an empty first sequence does not decide the shape of the packed elements
+   const std::vector< xarray< double > > with_empty_front{
+      xt::empty< double >({0}), xt::zeros< double >({2, 3}), xt::ones< double >({1, 3})
+   };
+   auto packed = decltype(ragged)::pack(with_empty_front);
+   EXPECT_EQ(packed.offsets, (std::vector< size_t >{0, 0, 2, 3}));
+   ASSERT_EQ(packed.values.dimension(), 2);
+   EXPECT_EQ(packed.values.shape()[0], 3);
+   EXPECT_EQ(packed.values.shape()[1], 3);
+   EXPECT_EQ(packed.length(0), 0);
+   EXPECT_EQ(packed.sequence(2), (xarray< double >{{1., 1., 1.}}));
+
+   // fixed lengths and sampling from a set of lengths
+   auto fixed = space.sample_ragged(n_samples, std::tuple{4, std::nullopt});
+   EXPECT_EQ(fixed.values.shape()[0], 4 * n_samples);
+   auto from_set = space.sample_ragged(n_samples, std::tuple{std::vector{1, 3}, std::nullopt});
+   for(size_t i = 0; i < n_samples; ++i) {
+      EXPECT_TRUE(from_set.length(i) == 1 or from_set.length(i) == 3);
+   }
+}
+
+TEST(Spaces, Sequence_Discrete_sample_ragged_masked)
+{
+   auto space = SequenceSpace{DiscreteSpace{6, 0}, 56363};
+   auto mask = std::tuple{10, xarray< bool >{true, false, true, false, true, false}};
+   auto ragged = space.sample_ragged(20, mask);
+   EXPECT_EQ(ragged.values.size(), 200);
+   EXPECT_TRUE(xt::all(xt::isin(ragged.values, xt::xarray< int >{0, 2, 4})));
+   for(size_t i = 0; i < ragged.size(); ++i) {
+      EXPECT_EQ(ragged.row(i).size(), 10);
+   }
+}
+
+TEST(Spaces, Sequence_MultiDiscrete_sample_long)
+{
+   auto start = xarray< int >({0, 0, -3});
+   auto end = xarray< int >({10, 5, 3});
+   auto space = SequenceSpace{MultiDiscreteSpace{start, end}, 0.002, 4356};
+   auto sample = space.sample(std::tuple{500, std::nullopt});
+   ASSERT_EQ(sample.dimension(), 2);
+   EXPECT_EQ(sample.shape()[0], 500);
+   EXPECT_TRUE(xt::all(sample >= xt::view(start, xt::newaxis(), xt::all())));
+   EXPECT_TRUE(xt::all(sample < xt::view(end, xt::newaxis(), xt::all())));
+
+   // sampling into existing storage reuses the stacked output
+   xarray< int > out;
+   for([[maybe_unused]] auto _ : ranges::views::iota(0, 10)) {
+      space.sample_into(out);
+      EXPECT_EQ(out.dimension(), 2);
+      EXPECT_TRUE(out.size() == 0 or xt::all(out < xt::view(end, xt::newaxis(), xt::all())));
+   }
+}
+
+TEST(Spaces, Sequence_MultiBinary_sample_length_one)
+{
+   auto space = SequenceSpace{MultiBinarySpace{2, 3}, 0.5, 42};
+   const auto expected_shape = std::vector< size_t >{1, 2, 3};
+
+   auto sample = space.sample(std::tuple{1, std::nullopt});
+   EXPECT_EQ(std::vector< size_t >(sample.shape().begin(), sample.shape().end()), expected_shape);
+
+   auto samples = space.sample(10, std::tuple{1, std::nullopt});
+   ASSERT_EQ(samples.size(), 10);
+   for(const auto& sub_batch : samples) {
+      EXPECT_EQ(
+         std::vector< size_t >(sub_batch.shape().begin(), sub_batch.shape().end()), expected_shape
+      );
+   }
+
+   // geometric lengths include 0 and 1, every sequence keeps its sequence axis
+   xarray< int8_t > out;
+   for([[maybe_unused]] auto _ : ranges::views::iota(0, 50)) {
+      space.sample_into(out);
+      ASSERT_EQ(out.dimension(), 3);
+      EXPECT_EQ(out.shape()[1], 2);
+      EXPECT_EQ(out.shape()[2], 3);
+   }
+   auto batch_out = space.sample(50);
+   space.sample_into(50, batch_out);
+   for(const auto& sub_batch : batch_out) {
+      ASSERT_EQ(sub_batch.dimension(), 3);
+      EXPECT_EQ(sub_batch.shape()[1], 2);
+      EXPECT_EQ(sub_batch.shape()[2], 3);
+   }
+}
@@ -179,3 +179,65 @@ TEST(Spaces, Text_copy_construction)
    auto samples_copy = space_copy.sample(10000);
    EXPECT_NE(samples, samples_copy);
 }
+
+TEST(Spaces, Text_sample_into)
+{
+   auto space = TextSpace{{.max_length = 8, .min_length = 2, .characters = "AEIOU"}, 56356739};
+   std::vector< std::string > samples;
+   space.sample_into(20, samples);
+   EXPECT_EQ(samples.size(), 20);
+   const auto* buffer = samples.data();
+   space.sample_into(20, samples);
+   EXPECT_EQ(samples.data(), buffer);
+   for(const auto& sample : samples) {
+      EXPECT_TRUE(space.contains(sample));
+   }
+   std::string sample;
+   space.sample_into(sample);
+   EXPECT_TRUE(space.contains(sample));
+}
+
+TEST(Spaces, Text_sample_columnar)
+{
+   auto space = TextSpace{{.max_length = 8, .min_length = 2, .characters = "AEIOU"}, 56356739};
+   auto batch = space.sample_columnar(50);
+   EXPECT_EQ(batch.size(), 50);
+   EXPECT_EQ(batch.offsets().size(), 51);
+   EXPECT_EQ(batch.offsets().back(), batch.chars().size());
+   for(std::string_view sample : batch) {
+      EXPECT_GE(sample.size(), 2);
+      EXPECT_LE(sample.size(), 8);
+      // the views point into the shared buffer
+      EXPECT_GE(sample.data(), batch.chars().data());
+      EXPECT_LE(sample.data() + sample.size(), batch.chars().data() + batch.chars().size());
+   }
+   EXPECT_TRUE(space.contains(batch));
+   // round trip through individual strings
+   EXPECT_EQ(TextBatch{batch.to_strings()}, batch);
+
+   TextBatch invalid{std::vector< std::string >{"AEI", "XYZ"}};
+   EXPECT_FALSE(space.contains(invalid));
+   EXPECT_EQ(invalid[1], "XYZ");
+   EXPECT_THROW(std::ignore = invalid.at(2), std::out_of_range);
+}
+
+TEST(Spaces, Text_character_index)
+{
+   auto space = TextSpace{{.max_length = 100, .characters = "AEIOU\xE4\xF6"}};
+   EXPECT_EQ(space.character_index('A'), 0);
+   EXPECT_EQ(space.character_index('U'), 4);
+   EXPECT_EQ(space.character_index('\xF6'), 6);
+   EXPECT_EQ(space.character_index('a'), -1);
+   EXPECT_EQ(space.character_index('\0'), -1);
+   // long inputs are validated in vectorized chunks, with any remainder checked one by one
+   std::string long_text(77, 'E');
+   long_text[40] = '\xE4';
+   EXPECT_TRUE(space.contains(long_text));
+   for(size_t pos : {0ul, 15ul, 31ul, 32ul, 63ul, 76ul}) {
+      auto invalid = long_text;
+      invalid[pos] = 'e';
+      EXPECT_FALSE(space.contains(invalid));
+   }
+   EXPECT_TRUE(space.contains("AEIOU"));
+   EXPECT_TRUE(space.contains(space.sample_columnar(100)));
+}
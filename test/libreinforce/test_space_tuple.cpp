@@ -1,14 +1,25 @@
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <span>
+#include <stdexcept>
+#include <thread>
 #include <tuple>
+#include <vector>
 #include <xtensor/xset_operation.hpp>
 
 #include "reinforce/spaces/box.hpp"
 #include "reinforce/spaces/discrete.hpp"
+#include "reinforce/spaces/fixed_box.hpp"
+#include "reinforce/spaces/flatten.hpp"
+#include "reinforce/spaces/multi_binary.hpp"
 #include "reinforce/spaces/multi_discrete.hpp"
 #include "reinforce/spaces/tuple.hpp"
 #include "reinforce/utils/math.hpp"
+#include "reinforce/utils/thread_pool.hpp"
+#include "reinforce/utils/utils.hpp"
 #include "reinforce/utils/xarray_formatter.hpp"
 #include "reinforce/utils/xtensor_typedefs.hpp"
 
@@ -85,7 +96,7 @@ TEST(Spaces, Tuple_Discrete_MultiDiscrete_sample_masked)
    auto mask = std::tuple{
       xarray< bool >{false, false, true, true, false},
       std::vector< std::optional< xarray< bool > > >{
-         xarray< bool >{false, false, false, false, false, true, true, true, true, true, true},
+         xarray< bool >{false, false, false, false, false, true, true, true, true, true},
          std::nullopt,
          xarray< bool >{true, false, true, true, true, false}
       }
@@ -207,4 +218,185 @@ TEST(Spaces, Tuple_Discrete_MultiDiscrete_structured_decomposition)
    EXPECT_EQ(mdisc_space, mdisc_space2);
    std::ignore = disc_space2.sample();
    EXPECT_NE(disc_space.sample(1000), disc_space2.sample(1000));
-}
\ No newline at end of file
+}
+
+TEST(Spaces, Tuple_Discrete_MultiDiscrete_thread_streams)
+{
+   constexpr size_t SEED = 6492374569235;
+   constexpr size_t n_threads = 4;
+   auto start = xarray< int >({0, 0, -3});
+   auto end = xarray< int >({10, 5, 3});
+   auto make_space = [&] {
+      auto space = TupleSpace{SEED, DiscreteSpace{5, 5}, MultiDiscreteSpace{start, end}};
+      space.enable_thread_streams(n_threads);
+      return space;
+   };
+   auto sample_concurrently = [&](const auto& space) {
+      std::vector< decltype(space.sample(size_t{1})) > results(n_threads);
+      std::vector< std::thread > threads;
+      for(size_t t = 0; t < n_threads; ++t) {
+         threads.emplace_back([&, t] {
+            set_this_thread_index(t);
+            results[t] = space.sample(100);
+         });
+      }
+      for(auto& thread : threads) {
+         thread.join();
+      }
+      return results;
+   };
+   const auto space1 = make_space();
+   const auto space2 = make_space();
+   auto results1 = sample_concurrently(space1);
+   auto results2 = sample_concurrently(space2);
+   for(size_t t = 0; t < n_threads; ++t) {
+      EXPECT_EQ(std::get< 0 >(results1[t]), std::get< 0 >(results2[t]));
+      EXPECT_EQ(std::get< 1 >(results1[t]), std::get< 1 >(results2[t]));
+   }
+   // distinct threads draw from distinct streams
+   EXPECT_NE(std::get< 1 >(results1[0]), std::get< 1 >(results1[1]));
+}
+
+TEST(Spaces, Tuple_Discrete_MultiDiscrete_thread_streams_recreated_threads)
+{
+   constexpr size_t n_threads = 2;
+   auto start = xarray< int >({0, 0, -3});
+   auto end = xarray< int >({10, 5, 3});
+   auto space = TupleSpace{size_t{42}, DiscreteSpace{5, 5}, MultiDiscreteSpace{start, end}};
+   space.enable_thread_streams(n_threads);
+   const auto& const_space = space;
+   // every pool numbers its workers anew, so recreating pools never runs out of streams
+   for(size_t round = 0; round < 5; ++round) {
+      ThreadPool pool{n_threads};
+      std::atomic< size_t > nr_done{0};
+      std::atomic< size_t > nr_failed{0};
+      for(size_t worker = 0; worker < n_threads; ++worker) {
+         pool.submit(worker, [&] {
+            try {
+               std::ignore = const_space.sample(10);
+            } catch(const std::out_of_range&) {
+               nr_failed.fetch_add(1);
+            }
+            nr_done.fetch_add(1);
+         });
+      }
+      while(nr_done.load() < n_threads) {
+         std::this_thread::yield();
+      }
+      EXPECT_EQ(nr_failed.load(), size_t{0});
+   }
+   // automatically numbered threads hand their index back when they exit
+   std::vector< size_t > indices;
+   for(size_t round = 0; round < 5; ++round) {
+      std::thread{[&] { indices.emplace_back(this_thread_index()); }}.join();
+   }
+   EXPECT_TRUE(std::ranges::all_of(indices, [&](size_t index) { return index == indices[0]; }));
+   // explicitly set indices are skipped while their thread holds them
+   std::thread{[&] {
+      set_this_thread_index(indices[0]);
+      std::thread{[&] { EXPECT_NE(this_thread_index(), indices[0]); }}.join();
+   }}.join();
+}
+
+TEST(Spaces, Tuple_Discrete_MultiDiscrete_sample_into)
+{
+   auto start = xarray< int >({0, 0, -3});
+   auto end = xarray< int >({10, 5, 3});
+   auto space = TupleSpace{DiscreteSpace{5, 5}, MultiDiscreteSpace{start, end}};
+   auto samples = space.sample(50);
+   const auto* discrete_buffer = std::get< 0 >(samples).data();
+   const auto* multi_discrete_buffer = std::get< 1 >(samples).data();
+   space.sample_into(50, samples);
+   // the subspaces fill their entries in place
+   EXPECT_EQ(std::get< 0 >(samples).data(), discrete_buffer);
+   EXPECT_EQ(std::get< 1 >(samples).data(), multi_discrete_buffer);
+   EXPECT_TRUE(xt::all(std::get< 0 >(samples) >= 5));
+   EXPECT_TRUE(xt::all(std::get< 0 >(samples) < 10));
+   auto sample = space.sample();
+   space.sample_into(sample);
+   EXPECT_TRUE(space.contains(sample));
+}
+
+TEST(Spaces, Tuple_Discrete_MultiDiscrete_contains_batch)
+{
+   auto start = xarray< int >{0, 0, -2};
+   auto end = xarray< int >{10, 5, 3};
+   auto space = TupleSpace{size_t{525}, DiscreteSpace{5, 5}, MultiDiscreteSpace{start, end}};
+   auto batch = space.sample(50);
+   EXPECT_TRUE(xt::all(space.contains_batch(batch)));
+   EXPECT_TRUE(space.contains_all(batch));
+
+   auto& [disc_batch, mdisc_batch] = batch;
+   disc_batch(4) = 10;  // the upper end of the discrete range is excluded
+   mdisc_batch(7, 1) = 5;  // as is the end of every multi-discrete entry
+   auto valid = space.contains_batch(batch);
+   for(size_t i = 0; i < 50; ++i) {
+      EXPECT_EQ(valid(i), i != 4 and i != 7);
+   }
+   EXPECT_FALSE(space.contains_all(batch));
+   EXPECT_FALSE(space.get< 1 >().contains(mdisc_batch));
+}
+
+TEST(Spaces, Tuple_Box_Discrete_MultiBinary_flatten)
+{
+   const xarray< double > box_low{{-1, 0}, {-10, 2}};
+   const xarray< double > box_high{{0, 1}, {10, 4}};
+   auto space = TupleSpace{
+      size_t{81}, BoxSpace{box_low, box_high}, DiscreteSpace{4, 2}, MultiBinarySpace{3}
+   };
+   EXPECT_EQ(flatdim(space), size_t{4 + 4 + 3});
+   const auto offsets = flattener< decltype(space) >::offsets(space);
+   EXPECT_EQ(offsets, (std::array< size_t, 4 >{0, 4, 8, 11}));
+   // a Flattener derives the same offsets once, at construction
+   const Flattener space_flattener{space};
+   EXPECT_EQ(space_flattener.offsets(), offsets);
+   EXPECT_EQ(space_flattener.flatdim(), flatdim(space));
+
+   auto sample = space.sample();
+   auto flat = flatten(space, sample);
+   EXPECT_EQ(xt::view(flat, xt::range(0, 4)), xt::flatten(std::get< 0 >(sample)));
+   EXPECT_EQ(flat(4 + std::get< 1 >(sample) - 2), 1.);
+   EXPECT_EQ(xt::sum(xt::view(flat, xt::range(4, 8)))(), 1.);
+   EXPECT_EQ(unflatten(space, std::span< const double >{flat.data(), flat.size()}), sample);
+
+   // the box part of the flat vector is aliased rather than copied
+   auto view = unflatten_view(space, std::span{flat.data(), flat.size()});
+   std::get< 0 >(view)(1, 0) = 7.;
+   EXPECT_EQ(flat(2), 7.);
+   EXPECT_EQ(std::get< 1 >(view), std::get< 1 >(sample));
+
+   auto batch = space.sample(20);
+   auto flat_batch = flatten_batch(space, batch);
+   EXPECT_EQ(flat_batch.shape(0), size_t{20});
+   EXPECT_EQ(flat_batch.shape(1), flatdim(space));
+   for(size_t i = 0; i < 20; ++i) {
+      auto row = xarray< double >(xt::row(flat_batch, static_cast< std::ptrdiff_t >(i)));
+      auto unflat = unflatten(space, std::span< const double >{row.data(), row.size()});
+      EXPECT_EQ(std::get< 0 >(unflat), xt::view(std::get< 0 >(batch), i));
+      EXPECT_EQ(std::get< 1 >(unflat), std::get< 1 >(batch)(i));
+      EXPECT_EQ(std::get< 2 >(unflat), xt::view(std::get< 2 >(batch), i));
+   }
+
+   auto flat_space = flatten_space(space);
+   EXPECT_EQ(flat_space.shape(), xt::svector< int >{11});
+   EXPECT_TRUE(flat_space.contains(flat));
+   EXPECT_TRUE(flat_space.contains_all(flat_batch));
+}
+
+TEST(Spaces, Tuple_FixedBox_static_offsets)
+{
+   using space_type = TupleSpace< FixedBoxSpace< float, 2, 3 >, FixedBoxSpace< double, 4 > >;
+   static_assert(flattener< space_type >::static_offsets == std::array< size_t, 3 >{0, 6, 10});
+   static_assert(flattener< space_type >::static_flatdim == 10);
+   // a Discrete subspace makes the flat dimension depend on the value of the space
+   static_assert(not detail::constant_flatdim<
+                 TupleSpace< FixedBoxSpace< float, 2, 3 >, DiscreteSpace< int > > >);
+
+   auto space = space_type{
+      FixedBoxSpace< float, 2, 3 >{-1.f, 1.f}, FixedBoxSpace< double, 4 >{0., 2.}
+   };
+   EXPECT_EQ(flatdim(space), size_t{10});
+   auto sample = space.sample();
+   auto flat = flatten(space, sample);
+   EXPECT_EQ(unflatten(space, std::span< const double >{flat.data(), flat.size()}), sample);
+}
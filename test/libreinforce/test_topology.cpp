@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+#include "reinforce/utils/topology.hpp"
+
+using namespace force;
+
+TEST(Topology, parse_cpu_list)
+{
+   EXPECT_EQ(
+      detail::parse_cpu_list("0-3,8,10-11\n"), (std::vector< size_t >{0, 1, 2, 3, 8, 10, 11})
+   );
+   EXPECT_EQ(detail::parse_cpu_list(""), (std::vector< size_t >{}));
+   EXPECT_THROW(detail::parse_cpu_list("3-1"), std::invalid_argument);
+   EXPECT_THROW(detail::parse_cpu_list("a"), std::invalid_argument);
+}
+
+TEST(Topology, query)
+{
+   const auto topology = Topology::query();
+   EXPECT_GE(topology.nr_nodes(), size_t{1});
+   EXPECT_GE(topology.nr_cpus(), size_t{1});
+   // without sysfs entries all CPUs form a single node
+   const auto fallback = Topology::query("/nonexistent");
+   EXPECT_EQ(fallback.nr_nodes(), size_t{1});
+   EXPECT_EQ(fallback.nr_cpus(), topology.nr_cpus());
+   EXPECT_EQ(fallback.node_of(fallback.nodes().front().cpus.front()), size_t{0});
+}
+
+TEST(Topology, place_workers)
+{
+   const Topology topology{{NumaNode{0, {0, 1, 2}}, NumaNode{1, {3, 4, 5}}}};
+   EXPECT_TRUE(place_workers(topology, 4, placement::none).empty());
+   EXPECT_EQ(place_workers(topology, 4, placement::scatter), (std::vector< size_t >{0, 3, 1, 4}));
+   EXPECT_EQ(
+      place_workers(topology, 8, placement::compact),
+      (std::vector< size_t >{0, 1, 2, 3, 4, 5, 0, 1})
+   );
+   EXPECT_EQ(topology.node_of(4), size_t{1});
+   EXPECT_EQ(topology.node_of(6), std::nullopt);
+}
+
+TEST(Topology, place_workers_without_cpus)
+{
+   const Topology topology{{NumaNode{0, {}}, NumaNode{1, {}}}};
+   EXPECT_TRUE(place_workers(topology, 4, placement::compact).empty());
+   EXPECT_TRUE(place_workers(topology, 4, placement::scatter).empty());
+}
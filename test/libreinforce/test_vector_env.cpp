@@ -0,0 +1,160 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "reinforce/env/async_vector_env.hpp"
+#include "reinforce/env/dynamic_gridworld.hpp"
+#include "reinforce/env/gridworld.hpp"
+#include "reinforce/env/process_vector_env.hpp"
+#include "reinforce/env/vector_env.hpp"
+#include "reinforce/utils/xarray_formatter.hpp"
+#include "reinforce/utils/xtensor_typedefs.hpp"
+#include "test_envs.hpp"
+
+using namespace force;
+using test::make_corridor;
+
+TEST(VectorEnv, Sync_spaces)
+{
+   SyncVectorEnv< Gridworld< 2 > > envs{4, make_corridor};
+   EXPECT_EQ(envs.size(), size_t{4});
+   EXPECT_EQ(envs.action_space().shape(), (xt::svector< int >{4}));
+   const auto& [indices, coordinates] = envs.reset(0);
+   EXPECT_EQ(indices, (xarray< size_t >{0, 0, 0, 0}));
+   EXPECT_EQ(coordinates.shape(0), size_t{4});
+   EXPECT_TRUE(envs.observation_space().contains(envs.observations()));
+
+   for(int i = 0; i < 10; ++i) {
+      auto [observations, rewards, terminated, truncated] = envs.step(envs.action_space().sample());
+      EXPECT_TRUE(envs.observation_space().contains(observations));
+      EXPECT_EQ(rewards.size(), size_t{4});
+   }
+}
+
+TEST(VectorEnv, Sync_dynamic_gridworld)
+{
+   // a corridor along the last axis of a grid of a dimension without a compiled Gridworld
+   constexpr size_t dim = 7;
+   std::vector< size_t > shape(dim, 1);
+   shape.back() = 3;
+   idx_xarray starts = xt::zeros< size_t >({size_t{1}, dim});
+   idx_xarray goals = starts;
+   goals(0, dim - 1) = 2;
+   std::vector< DynamicGridworld > grids;
+   for(size_t i = 0; i < 2; ++i) {
+      grids.emplace_back(dim, shape, starts, goals, 1.);
+   }
+   SyncVectorEnv< DynamicGridworld > envs{std::move(grids)};
+   const auto& [indices, coordinates] = envs.reset(0);
+   EXPECT_EQ(indices, (xarray< size_t >{0, 0}));
+   EXPECT_EQ(coordinates.shape(1), dim);
+   const size_t forth = 2 * (dim - 1) + 1;
+   envs.step(xarray< size_t >{forth, forth - 1});
+   auto [observations, rewards, terminated, truncated] = envs.step(
+      xarray< size_t >{forth, forth}
+   );
+   EXPECT_EQ(terminated, (xarray< bool >{true, false}));
+   EXPECT_EQ(rewards(0), 1.);
+   EXPECT_EQ(std::get< 1 >(observations)(1, dim - 1), size_t{1});
+   EXPECT_EQ(std::get< 1 >(envs.final_observations())(0, dim - 1), size_t{2});
+   EXPECT_TRUE(envs.observation_space().contains(observations));
+}
+
+TEST(VectorEnv, Sync_autoreset)
+{
+   SyncVectorEnv< Gridworld< 2 > > envs{3, make_corridor};
+   envs.reset(0);
+   // action 3 moves forth and action 2 back along the second axis, action 0 leaves the grid
+   envs.step(xarray< size_t >{3, 3, 2});
+   std::vector< SyncVectorEnv< Gridworld< 2 > >::info_type > infos;
+   auto [observations, rewards, terminated, truncated] = envs.step(
+      xarray< size_t >{3, 0, 3}, infos
+   );
+   EXPECT_EQ(infos.size(), size_t{3});
+   EXPECT_EQ(terminated, (xarray< bool >{true, false, false}));
+   EXPECT_EQ(truncated, (xarray< bool >{false, false, false}));
+   EXPECT_EQ(rewards(0), 1.);
+   // the first environment reached the goal and started over
+   EXPECT_EQ(std::get< 0 >(observations), (xarray< size_t >{0, 1, 1}));
+   EXPECT_EQ(std::get< 0 >(envs.final_observations())(0), size_t{2});
+   EXPECT_EQ(xt::view(std::get< 1 >(envs.final_observations()), 0), (xarray< size_t >{0, 2}));
+}
+
+TEST(VectorEnv, Async_recv_first_k)
+{
+   AsyncVectorEnv< Gridworld< 2 > > envs{6, make_corridor, size_t{3}};
+   EXPECT_EQ(envs.nr_threads(), size_t{3});
+   envs.async_reset(0);
+   {
+      auto [ids, observations, rewards, terminated, truncated] = envs.recv();
+      EXPECT_EQ(ids.size(), size_t{6});
+      EXPECT_EQ(std::get< 0 >(observations), (xarray< size_t >{0, 0, 0, 0, 0, 0}));
+   }
+   // move every environment forth twice, receiving them in batches of (at most) two
+   std::vector< size_t > steps(6, 0);
+   envs.send(xarray< size_t >{3, 3, 3, 3, 3, 3});
+   size_t nr_goals = 0;
+   while(envs.nr_in_flight() > 0) {
+      const size_t k = std::min< size_t >(2, envs.nr_in_flight());
+      auto [ids, observations, rewards, terminated, truncated] = envs.recv(k);
+      ASSERT_EQ(ids.size(), k);
+      std::vector< size_t > resend;
+      for(size_t row = 0; row < ids.size(); ++row) {
+         const size_t id = ids[row];
+         if(++steps[id] == 2) {
+            EXPECT_TRUE(terminated(row));
+            EXPECT_EQ(rewards(row), 1.);
+            EXPECT_EQ(std::get< 0 >(envs.final_observations())(row), size_t{2});
+            ++nr_goals;
+         } else {
+            EXPECT_FALSE(terminated(row));
+            EXPECT_EQ(std::get< 0 >(observations)(row), size_t{1});
+            resend.emplace_back(id);
+         }
+      }
+      if(not resend.empty()) {
+         xarray< size_t > forth = xarray< size_t >::from_shape({resend.size()});
+         forth.fill(3);
+         envs.send(forth, resend);
+      }
+   }
+   EXPECT_EQ(nr_goals, size_t{6});
+   EXPECT_THROW(envs.recv(1), std::invalid_argument);
+}
+
+TEST(VectorEnv, Async_placement)
+{
+   AsyncVectorEnv< Gridworld< 2 > > envs{4, make_corridor, size_t{2}, placement::scatter};
+   EXPECT_EQ(envs.nr_threads(), size_t{2});
+   envs.async_reset(0);
+   envs.recv();
+   auto [ids, observations, rewards, terminated, truncated] = envs.step(
+      xarray< size_t >{3, 3, 3, 3}
+   );
+   EXPECT_EQ(ids.size(), size_t{4});
+   EXPECT_EQ(std::get< 0 >(observations), (xarray< size_t >{1, 1, 1, 1}));
+}
+
+TEST(VectorEnv, Process_autoreset)
+{
+   ProcessVectorEnv< Gridworld< 2 > > envs{3, make_corridor, size_t{2}};
+   EXPECT_EQ(envs.nr_workers(), size_t{2});
+   const auto& [indices, coordinates] = envs.reset(0);
+   EXPECT_EQ(indices, (xarray< size_t >{0, 0, 0}));
+   envs.step(xarray< size_t >{3, 3, 2});
+   auto [observations, rewards, terminated, truncated] = envs.step(xarray< size_t >{3, 0, 3});
+   // the workers wrote straight into the batches the parent holds
+   EXPECT_EQ(&std::get< 0 >(observations), &std::get< 0 >(envs.observations()));
+   EXPECT_EQ(terminated, (xarray< bool >{true, false, false}));
+   EXPECT_EQ(rewards(0), 1.);
+   EXPECT_EQ(std::get< 0 >(observations), (xarray< size_t >{0, 1, 1}));
+   EXPECT_EQ(std::get< 0 >(envs.final_observations())(0), size_t{2});
+   EXPECT_EQ(xt::view(std::get< 1 >(envs.final_observations()), 0), (xarray< size_t >{0, 2}));
+   envs.close();
+   EXPECT_THROW(envs.reset(), std::logic_error);
+}
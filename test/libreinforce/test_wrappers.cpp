@@ -0,0 +1,218 @@
+#include <gtest/gtest.h>
+
+#include <any>
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+
+#include "reinforce/env/gridworld.hpp"
+#include "reinforce/env/gym_env_concept.h"
+#include "reinforce/env/vector_env.hpp"
+#include "reinforce/env/wrappers.hpp"
+#include "reinforce/spaces/box.hpp"
+#include "reinforce/spaces/discrete.hpp"
+#include "reinforce/utils/xtensor_typedefs.hpp"
+#include "test_envs.hpp"
+
+using namespace force;
+using test::make_corridor;
+
+namespace {
+
+/// counts its steps and pays the action as reward, with gymnasium's signatures of step and reset
+class Counter {
+  public:
+   using info_type = std::unordered_map< std::string, std::any >;
+
+   [[nodiscard]] DiscreteSpace< size_t > observation_space() const
+   {
+      return DiscreteSpace< size_t >{100};
+   }
+   [[nodiscard]] DiscreteSpace< size_t > action_space() const { return DiscreteSpace< size_t >{2}; }
+
+   std::tuple< size_t, double, bool, bool, info_type > step(size_t action)
+   {
+      return {++m_count, static_cast< double >(action), false, false, {}};
+   }
+   std::tuple< size_t, info_type >
+   reset(std::optional< size_t > /*seed*/ = {}, std::optional< info_type > /*options*/ = {})
+   {
+      m_count = 0;
+      return {m_count, {}};
+   }
+
+  private:
+   size_t m_count = 0;
+};
+
+/// a point on a line moved by the action, which is bounded to [-1, 1]
+class Line {
+  public:
+   [[nodiscard]] BoxSpace< double > observation_space() const
+   {
+      return BoxSpace< double >{xarray< double >{-10.}, xarray< double >{10.}};
+   }
+   [[nodiscard]] BoxSpace< double > action_space() const
+   {
+      return BoxSpace< double >{xarray< double >{-1.}, xarray< double >{1.}};
+   }
+
+   std::tuple< xarray< double >, double, bool, bool > step(const xarray< double >& action)
+   {
+      m_position += action;
+      return {m_position, action(0), false, false};
+   }
+   const xarray< double >& reset(std::optional< size_t > /*seed*/ = {})
+   {
+      m_position.fill(0.);
+      return m_position;
+   }
+
+  private:
+   xarray< double > m_position = xt::zeros< double >({size_t{1}});
+};
+
+}  // namespace
+
+static_assert(gym_env< TimeLimit< EpisodeStats< Counter > >, size_t, size_t >);
+static_assert(detail::vectorizable_env< TimeLimit< EpisodeStats< Gridworld< 2 > > > >);
+
+TEST(Wrappers, time_limit_and_episode_statistics)
+{
+   EpisodeStats< TimeLimit< Gridworld< 2 > > > env{TimeLimit{make_corridor(0), 3}};
+   EXPECT_EQ(env.reset(0).first, size_t{0});
+   // action 2 moves back along the corridor and leaves the grid, the agent stays at the start
+   for(size_t i = 0; i < 2; ++i) {
+      auto [observation, reward, terminated, truncated] = env.step(2);
+      EXPECT_FALSE(truncated);
+   }
+   auto [observation, reward, terminated, truncated] = env.step(2);
+   EXPECT_TRUE(truncated);
+   EXPECT_EQ(env.episode_count(), size_t{1});
+   EXPECT_EQ(env.history().back().length, size_t{3});
+
+   env.reset();
+   EXPECT_EQ(env.env().elapsed_steps(), size_t{0});
+   env.step(3);
+   std::tie(observation, reward, terminated, truncated) = env.step(3);
+   EXPECT_TRUE(terminated);
+   EXPECT_FALSE(truncated);
+   EXPECT_EQ(env.episode_count(), size_t{2});
+   EXPECT_EQ(env.history().back().length, size_t{2});
+   EXPECT_EQ(env.history().back().episode_return, 1.);
+   EXPECT_EQ(&env.unwrapped(), &env.env().env());
+}
+
+TEST(Wrappers, episode_statistics_inside_time_limit)
+{
+   TimeLimit< EpisodeStats< Gridworld< 2 > > > env{
+      EpisodeStats< Gridworld< 2 > >{make_corridor(0)}, 3
+   };
+   env.reset(0);
+   for(size_t i = 0; i < 2; ++i) {
+      env.step(2);
+   }
+   EXPECT_EQ(env.env().episode_count(), size_t{0});
+   // the time limit outside tells the statistics about its truncation
+   auto [observation, reward, terminated, truncated] = env.step(2);
+   EXPECT_TRUE(truncated);
+   EXPECT_EQ(env.env().episode_count(), size_t{1});
+   EXPECT_EQ(env.env().history().back().length, size_t{3});
+   EXPECT_EQ(env.env().episode_length(), size_t{0});
+   env.reset();
+   EXPECT_EQ(env.env().episode_count(), size_t{1});
+
+   env.step(3);
+   std::tie(observation, reward, terminated, truncated) = env.step(3);
+   EXPECT_TRUE(terminated);
+   EXPECT_EQ(env.env().episode_count(), size_t{2});
+   EXPECT_EQ(env.env().history().back().length, size_t{2});
+   EXPECT_EQ(env.env().history().back().episode_return, 1.);
+   // an episode cut short by a reset is discarded, as in gymnasium
+   env.reset();
+   env.step(2);
+   env.reset();
+   EXPECT_EQ(env.env().episode_count(), size_t{2});
+   EXPECT_EQ(env.env().episode_length(), size_t{0});
+}
+
+TEST(Wrappers, episode_statistics_info)
+{
+   EpisodeStats< TimeLimit< Counter > > env{TimeLimit{Counter{}, 2}};
+   env.reset();
+   auto [observation, reward, terminated, truncated, info] = env.step(1);
+   EXPECT_TRUE(info.empty());
+   std::tie(observation, reward, terminated, truncated, info) = env.step(1);
+   EXPECT_TRUE(truncated);
+   const auto statistics = std::any_cast< EpisodeStatistics >(info.at("episode"));
+   EXPECT_EQ(statistics.episode_return, 2.);
+   EXPECT_EQ(statistics.length, size_t{2});
+}
+
+TEST(Wrappers, clip_action)
+{
+   ClipAction< Line > env{Line{}};
+   env.reset();
+   auto [observation, reward, terminated, truncated] = env.step(xarray< double >{5.});
+   EXPECT_EQ(reward, 1.);
+   std::tie(observation, reward, terminated, truncated) = env.step(xarray< double >{-0.5});
+   EXPECT_EQ(observation, (xarray< double >{0.5}));
+}
+
+TEST(Wrappers, vector_time_limit_and_episode_statistics)
+{
+   VectorRecordEpisodeStatistics< VectorTimeLimit< SyncVectorEnv< Gridworld< 2 > > > > envs{
+      size_t{100}, size_t{3}, size_t{2}, make_corridor
+   };
+   envs.reset(0);
+   // the first environment walks to the goal, the second one stays at the start
+   envs.step(xarray< size_t >{3, 2});
+   auto [observations, rewards, terminated, truncated] = envs.step(xarray< size_t >{3, 2});
+   EXPECT_EQ(terminated, (xarray< bool >{true, false}));
+   EXPECT_EQ(envs.final_returns()(0), 1.);
+   EXPECT_EQ(envs.final_lengths()(0), size_t{2});
+
+   std::tie(observations, rewards, terminated, truncated) = envs.step(xarray< size_t >{3, 2});
+   EXPECT_EQ(truncated, (xarray< bool >{false, true}));
+   EXPECT_EQ(envs.final_lengths()(1), size_t{3});
+   EXPECT_EQ(envs.episode_count(), size_t{2});
+   EXPECT_EQ(envs.env().elapsed_steps(), (xarray< size_t >{1, 0}));
+   EXPECT_EQ(envs.episode_lengths(), (xarray< size_t >{1, 0}));
+   EXPECT_EQ(std::get< 0 >(observations), (xarray< size_t >{1, 0}));
+}
+
+TEST(Wrappers, vector_episode_statistics_inside_time_limit)
+{
+   VectorTimeLimit< VectorRecordEpisodeStatistics< SyncVectorEnv< Gridworld< 2 > > > > envs{
+      size_t{3}, size_t{100}, size_t{2}, make_corridor
+   };
+   envs.reset(0);
+   envs.step(xarray< size_t >{3, 2});
+   envs.step(xarray< size_t >{3, 2});
+   auto& statistics = envs.env();
+   EXPECT_EQ(statistics.episode_count(), size_t{1});
+   EXPECT_EQ(statistics.final_lengths()(0), size_t{2});
+
+   auto [observations, rewards, terminated, truncated] = envs.step(xarray< size_t >{3, 2});
+   EXPECT_EQ(truncated, (xarray< bool >{false, true}));
+   // the truncation by the outer time limit closes the episode of the second environment
+   EXPECT_EQ(statistics.episode_count(), size_t{2});
+   EXPECT_EQ(statistics.final_lengths()(1), size_t{3});
+   EXPECT_EQ(statistics.history().back().length, size_t{3});
+   EXPECT_EQ(statistics.episode_lengths(), (xarray< size_t >{1, 0}));
+   EXPECT_EQ(envs.elapsed_steps(), (xarray< size_t >{1, 0}));
+}
+
+TEST(Wrappers, vector_clip_action)
+{
+   VectorClipAction< SyncVectorEnv< Line > > envs{size_t{2}, [](size_t) { return Line{}; }};
+   envs.reset();
+   auto [observations, rewards, terminated, truncated] = envs.step(
+      xarray< double >{{5.}, {-0.5}}
+   );
+   EXPECT_EQ(rewards, (xarray< double >{1., -0.5}));
+   EXPECT_EQ(observations, (xarray< double >{{1.}, {-0.5}}));
+}